@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "adb/ADBClient.hpp"
+
+// 一帧 BGR 图像，附带单调时钟时间戳与序号
+struct Frame {
+    cv::Mat image;
+    uint64_t sequence = 0; // 从 1 起递增
+    std::chrono::steady_clock::time_point started;   // 开始截图时刻，画面内容不早于此刻
+    std::chrono::steady_clock::time_point timestamp; // 截图完成时刻
+};
+
+/**
+ * @brief 帧源接口：每次 grab 得到一帧 BGR 图像
+ *
+ * grab 尽量复用 out 已有的内存，尺寸不变时不重新分配。
+ */
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool grab(cv::Mat& out) = 0;
+    // 中断进行中的 grab（可从其他线程调用），之后的 grab 不受影响
+    virtual void interrupt() {}
+    virtual std::string name() const = 0;
+};
+
+/**
+ * @brief 经 ADBClient 截图的帧源
+ *
+ * 覆盖 PNG screencap、原始 screencap、framebuffer 与 gzip 压缩原始截图；
+ * 未指定 mode 时跟随 ADBClient::capture_mode(device_id)。PNG 数据与原始像素缓冲区跨帧复用。
+ */
+class AdbFrameSource : public FrameSource {
+public:
+    AdbFrameSource(ADBClient& client, std::string device_id, std::optional<AdbCaptureMode> mode = std::nullopt);
+
+    bool grab(cv::Mat& out) override;
+    void interrupt() override;
+    std::string name() const override;
+
+    // 最近一次原始截图（PNG 方式时为空），供局部截图换算屏幕几何信息
+    const AdbRawFrame& raw() const { return raw_frame_; }
+
+private:
+    AdbCaptureMode mode() const;
+
+    ADBClient& client_;
+    std::string device_id_;
+    std::optional<AdbCaptureMode> mode_;
+    AdbRawFrame raw_frame_;
+    std::string png_buffer_;
+    std::mutex cancel_mutex_;
+    std::shared_ptr<AdbCancelToken> cancel_; // interrupt() 时取消并换新
+};
+
+/**
+ * @brief 从目录回放截图的帧源（离线调试与基准测试）
+ *
+ * 构造时按文件名顺序解码目录下的 png/jpg/bmp 图像，grab 依次复制到输出，
+ * loop 为 false 时回放完最后一张后返回 false。
+ */
+class ReplayFrameSource : public FrameSource {
+public:
+    explicit ReplayFrameSource(const std::string& directory, bool loop = true);
+
+    bool grab(cv::Mat& out) override;
+    std::string name() const override;
+
+    size_t size() const { return images_.size(); }
+
+private:
+    std::string directory_;
+    std::vector<cv::Mat> images_;
+    std::atomic<size_t> next_{0};
+    bool loop_;
+};
+
+// 后台截图统计
+struct FrameRingStats {
+    uint64_t frames = 0;    // 成功截取的帧数
+    uint64_t failures = 0;  // grab 失败次数
+    uint64_t stalls = 0;    // 所有缓冲区都被占用而等待的次数
+    double capture_seconds = 0.0; // 成功截图的累计耗时
+
+    double avg_ms() const { return frames ? capture_seconds * 1000.0 / frames : 0.0; }
+};
+
+/**
+ * @brief 环形缓冲的后台截图
+ *
+ * 后台线程循环调用 FrameSource::grab，写入固定数量、跨帧复用的 cv::Mat 缓冲区并发布为最新帧。
+ * 读取方拿到的 shared_ptr 持有期间该缓冲区不会被覆盖；稳定运行后不再分配内存。
+ * 读取方直接取最新帧，无需等待一次截图往返。
+ */
+class FrameRing {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @param capacity 缓冲区数量（至少 2：一个发布，一个写入）
+     * @param interval 两次截图开始的最小间隔，0 表示连续截图
+     */
+    explicit FrameRing(std::unique_ptr<FrameSource> source, size_t capacity = 3,
+                       std::chrono::milliseconds interval = std::chrono::milliseconds(0));
+    ~FrameRing();
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // 启动后台线程；重新启动时丢弃停止前的帧
+    void start();
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    // 最新帧，还没有时为空
+    std::shared_ptr<const Frame> latest() const;
+    // 等待开始时刻不早于 since 的帧（如点击之后的画面），超时、停止或 cancel_waits() 时返回空
+    std::shared_ptr<const Frame> wait_since(clock::time_point since, std::chrono::milliseconds timeout);
+    // 等待序号大于 sequence 的帧
+    std::shared_ptr<const Frame> wait_after(uint64_t sequence, std::chrono::milliseconds timeout);
+    // 唤醒所有等待中的读取方
+    void cancel_waits();
+
+    FrameRingStats stats() const;
+    FrameSource& source() { return *source_; }
+    // 停止并交出帧源，之后不可再 start
+    std::unique_ptr<FrameSource> take_source();
+
+private:
+    void run();
+    // 取一个没有被读取方持有、也不是最新帧的缓冲区（需持有 mutex_）
+    std::shared_ptr<Frame> free_slot();
+    template <typename Pred>
+    std::shared_ptr<const Frame> wait_for(Pred&& ready, std::chrono::milliseconds timeout);
+
+    std::unique_ptr<FrameSource> source_;
+    std::chrono::milliseconds interval_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable frame_cv_;  // 发布新帧、停止或 cancel_waits 时通知
+    std::condition_variable slot_cv_;   // 无空闲缓冲区时等待，读取方释放后由下一次轮询发现
+    std::vector<std::shared_ptr<Frame>> slots_;
+    std::shared_ptr<Frame> latest_;
+    uint64_t sequence_ = 0;
+    uint64_t wake_generation_ = 0;
+    FrameRingStats stats_;
+
+    std::atomic<bool> running_{false};
+    std::thread worker_;
+};
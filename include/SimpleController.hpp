@@ -1,42 +1,160 @@
 #pragma once
 #include <string>
+#include <array>
+#include <condition_variable>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "FrameSource.hpp"
 #include "adb/ADBClient.hpp"
+#include "adb/AdbTouchInjector.hpp"
 #include "vision/ocr_pack.h"
 
+// ocr_region 的识别方式
+enum class RegionOcrMode {
+    Detect,         // 先检测文本框再识别
+    Line,           // 整个区域作为一行文本直接识别，省去检测与透视变换
+    LineThenDetect, // 先按单行直接识别，结果为空时再检测 + 识别（TaskExecutor 在结果不符合 roi 正则时也会退回检测）
+};
+
+// 一帧的分析结果：同一帧上的重复查询直接返回，帧被重新截图或重新载入时清空
+struct FrameAnalysis {
+    std::optional<std::vector<std::pair<TextBox, std::string>>> texts;   // 全图检测 + 识别
+    std::map<std::pair<std::array<int, 5>, std::string>, std::string> regions; // 区域 OCR：(缩放后的 x, y, w, h 与识别方式, 字符集) -> 文本
+    std::unordered_map<std::string, std::optional<cv::Point>> templates; // 模板路径 -> 命中中心（未命中为空）
+};
+
+// 帧分析缓存命中统计
+struct FrameCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    double hit_rate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
 
 class SimpleController {
 public:
     using Task = std::function<void(SimpleController&)>;
-    SimpleController();
+    /**
+     * @param ocr_config_path OCR 模型的 ONNX Runtime 会话参数文件，为空时使用 resource/ocr_runtime.json（存在时；仓库只附带 ocr_runtime.example.json）
+     */
+    explicit SimpleController(const std::string& ocr_config_path = "");
     ~SimpleController();
     // 连接设备
     bool connect(const std::string& adb_path, const std::string& address, const std::string& config_path = "");
 
     // 基本操作
+    // 截图存入内存帧缓存（以 filename 为键），仅调试模式下写盘
     bool capture_screenshot(const std::string& filename);
+    /**
+     * @brief 局部截图：只传输覆盖 regions 的屏幕行，存入内存帧缓存
+     * @param regions 相对坐标（0~1）表示的区域，帧中区域以外的行无效
+     */
+    bool capture_partial(const std::string& filename, const std::vector<cv::Rect2f>& regions);
+    // 截图并直接解码为 BGR 图像，不落盘
+    bool capture_frame(cv::Mat& out);
+    // 设置截图传输方式（PNG / 原始像素 / framebuffer / gzip 压缩原始像素）
+    void set_capture_mode(AdbCaptureMode mode);
+    // 设置后台截图的帧源（如 ReplayFrameSource），为空时按截图方式经 ADB 截图；后台截图运行中时重启
+    void set_frame_source(std::unique_ptr<FrameSource> source);
+    /**
+     * @brief 启动后台连续截图
+     *
+     * 运行期间 capture_screenshot / capture_frame 直接取环形缓冲中的最新帧，
+     * 只要求该帧在最近一次点击、滑动或 shell 命令完成之后才开始截取，不再等待一次截图往返。
+     * @param ring_size 缓冲区数量
+     * @param interval 两次截图开始的最小间隔，0 表示连续截图
+     */
+    bool start_capture_stream(size_t ring_size = 3, std::chrono::milliseconds interval = std::chrono::milliseconds(0));
+    void stop_capture_stream();
+    // 后台截图的最新帧，未运行或还没有帧时为空
+    std::shared_ptr<const Frame> latest_frame() const;
+    // 调试模式：截图同时写入 work_dir_，便于排查
+    void set_debug_save(bool enable);
+    // 取内存帧缓存中的图像，缓存中没有时从 work_dir_ 读取并加入缓存
+    cv::Mat get_frame(const std::string& image_path);
     bool click(int x, int y);
+    // 等待 ms 毫秒，cancel() 时提前返回
     void wait(int ms);
+    // 等待 ms 毫秒；取得 generation 之后发生过 cancel()（包括等待开始之前）时立即返回 false
+    bool wait(int ms, uint64_t generation);
+    // 当前的取消代数：在可中断的工作开始前取得，传给 wait() / wait_stable()，不会漏掉其间的 cancel()
+    uint64_t cancel_generation();
+    /**
+     * @brief 等待画面稳定：轮询截图，连续 stable_count 次与上一帧的差异不超过 threshold 即返回 true
+     *
+     * 差异为缩小到 64 像素宽的灰度缩略图逐像素差的平均值（0~255）。
+     * 后台截图运行时直接取新帧，否则每 interval_ms 同步截图一次。
+     * @param min_wait_ms 开始轮询前的最短等待
+     * @param generation cancel_generation() 的返回值，省略时取调用时刻的值
+     * @return 超时、截图一直失败或 cancel() 时返回 false
+     */
+    bool wait_stable(int timeout_ms, int min_wait_ms = 0, int interval_ms = 200,
+                     double threshold = 2.0, int stable_count = 2,
+                     std::optional<uint64_t> generation = std::nullopt);
+    // 中断进行中的 ADB 调用与等待（可从其他线程调用，如 TaskExecutor::stop）
+    void cancel();
     std::string build_cmd(const std::string& cmd);
     bool swipe(int x1, int y1, int x2, int y2, int duration_ms);
+    // 触摸注入：直接写 /dev/input/eventN（默认开启），不可用或关闭时使用 input tap/swipe
+    void set_touch_injection(bool enable);
 
     // 视觉功能
     bool detect_text(const std::string& image_path, std::string& out_text);
     bool find_template(const std::string& image_path, const std::string& template_path, int& out_x, int& out_y);
     bool find_text(const std::string& image_path, const std::string& target_text, int& out_x, int& out_y);
 
-    // OCR 区域识别
+    // OCR 区域识别，mode 选择检测 + 识别或单行直接识别；filter_pattern 非空时只解码该正则可能包含的字符
+    // （字符集外的字形会被改判，只在整行须完全匹配该正则时传入）
     bool ocr_region(const std::string& image_path, int roi_x, int roi_y, int roi_w, int roi_h,
-                    int base_w, int base_h, std::string& out_text);
+                    int base_w, int base_h, std::string& out_text,
+                    RegionOcrMode mode = RegionOcrMode::Detect, const std::string& filter_pattern = "");
+
+    // 帧分析缓存的累计命中统计（find_text / detect_text / ocr_region / find_template）
+    FrameCacheStats frame_cache_stats() const { return cache_stats_; }
 
 
 private:
+    // 触摸注入是否可用，首次调用时初始化
+    bool touch_ready();
+    // 记录输入操作完成时刻，之后的截图须晚于此刻
+    void mark_input();
+    // 从后台截图取一帧复制到 out（复用其内存）
+    bool take_stream_frame(cv::Mat& out);
+    // 帧内容变化（重新截图或载入）时丢弃其分析结果
+    void invalidate_analysis(const std::string& image_path);
+    // 全图 OCR 结果，同一帧只识别一次；帧不存在时返回空
+    const std::vector<std::pair<TextBox, std::string>>* frame_texts(const std::string& image_path);
+
     std::unique_ptr<ADBClient> adb_client_;
     std::unique_ptr<OcrPack> vision_api_;
+    std::unique_ptr<AdbTouchInjector> touch_; // 触摸注入，须在 adb_client_ 之后声明（析构先于它）
+    bool touch_injection_ = true;
+    bool touch_init_tried_ = false;
     std::string device_address_;
     std::string adb_path_;
     std::string config_path_;
     std::string work_dir_;  // ADB 工作目录
+    AdbCaptureMode capture_mode_ = AdbCaptureMode::PNG;
+    AdbRawFrame raw_frame_;  // 局部截图的原始帧缓冲，跨帧复用
+    std::unique_ptr<AdbFrameSource> adb_source_; // 同步截图
+    std::unique_ptr<FrameSource> stream_source_; // set_frame_source 设置、尚未启动的帧源
+    std::unique_ptr<FrameRing> frame_ring_;      // 后台截图，须在 adb_client_ 之后声明
+    std::mutex ring_mutex_; // 保护 frame_ring_ 与 adb_client_ 的替换，cancel() 可在其他线程调用
+    size_t ring_size_ = 3;
+    std::chrono::milliseconds ring_interval_{0};
+    std::chrono::steady_clock::time_point last_input_{};
+    cv::Mat poll_frame_; // wait_stable 的截图缓冲，跨调用复用
+    bool debug_save_ = false;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    uint64_t cancel_generation_ = 0; // cancel() 时递增，唤醒 wait()
+    std::unordered_map<std::string, cv::Mat> frames_;    // 内存帧缓存：save_name -> BGR 图像
+    std::unordered_map<std::string, cv::Mat> templates_; // 模板图像缓存：template_path -> 图像
+    std::unordered_map<std::string, FrameAnalysis> analysis_; // 帧分析缓存：save_name -> 分析结果
+    FrameCacheStats cache_stats_;
 };
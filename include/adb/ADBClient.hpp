@@ -1,10 +1,27 @@
 #pragma once
 
 #include "AdbStatus.hpp"
+#include "AdbCall.hpp"
+#include "AdbConnectionPool.hpp"
+#include "AdbSync.hpp"
+#include "AdbFrame.hpp"
+#include "AdbShellSession.hpp"
+#include "AdbShellStream.hpp"
+#include "AdbDeviceTracker.hpp"
+#include "AdbdTransport.hpp"
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <vector>
 #include <boost/asio.hpp>
 
+class AdbFrameDecoder;
+
 // ADB 客户端，Socket 直连 ADB Server，支持常用设备管理与文件操作
 class ADBClient {
 public:
@@ -15,24 +32,189 @@ public:
     explicit ADBClient(std::string_view work_dir = "adb");
     ~ADBClient();
 
+    // ADB Server 上的设备与直连设备（直连断开时为 OFFLINE）
     std::map<std::string, AdbDeviceStatus> list_devices();
+    /**
+     * @brief 订阅设备状态变化（host:track-devices-l 推送，无需轮询）
+     *
+     * 首次订阅时启动后台跟踪线程。回调在跟踪线程上执行，设备掉线或重连时
+     * 连接池与 shell 会话已先行失效。返回订阅 ID，供 untrack_devices 取消。
+     */
+    uint64_t track_devices(AdbDeviceCallback callback);
+    void untrack_devices(uint64_t id);
+    // 跟踪到的当前设备表，无锁读取；未调用过 track_devices 时为空
+    std::shared_ptr<const AdbDeviceTable> device_snapshot() const { return tracker_->snapshot(); }
     bool connect(std::string_view ip, std::string_view port);
     bool disconnect(std::string_view ip, std::string_view port);
+    /**
+     * @brief 不经 ADB Server，以 ADB 线协议直连设备的 adbd（adb tcpip 开启的端口）
+     *
+     * 设备 ID 为 "ip:port"，之后该设备的所有服务经同一条 TCP 连接多路复用，可在没有 adb server 时运行。
+     * 认证密钥取 ~/.android/adbkey（与 adb 共用，已授权的设备无需再次确认），不存在时在工作目录生成；
+     * 设备首次见到该密钥时需在设备上允许调试，等待时间受默认超时与 AdbCallScope 约束。
+     * 连接断开后下一次阻塞调用自动重连。
+     */
+    bool connect_direct(std::string_view ip, std::string_view port = "5555");
+    void disconnect_direct(std::string_view ip, std::string_view port = "5555");
+    // 设备是否经直连 adbd 访问
+    bool is_direct(std::string_view device_id);
     std::string shell(std::string_view device_id, std::string_view command);
     std::deque<std::string> shell_lines(std::string_view device_id, std::string_view command);
+    /**
+     * @brief 流式 shell：输出边到达边交给回调，不等命令结束、不缓存完整输出
+     *
+     * 回调返回 false 时提前结束并关闭连接，适合 logcat 等不会自行退出的命令。
+     * 打开失败或读取出错时返回 false，读到结尾或被回调结束时返回 true。
+     */
+    bool shell_stream(std::string_view device_id, std::string_view command, const AdbChunkCallback& on_chunk);
+    bool shell_stream_lines(std::string_view device_id, std::string_view command, const AdbLineCallback& on_line);
+    // 打开流式 shell 由调用方逐行/逐块拉取，打开失败时 ok() 为 false
+    AdbShellStream open_shell_stream(std::string_view device_id, std::string_view command,
+                                     size_t buffer_size = AdbShellStream::DEFAULT_BUFFER_SIZE);
+    /**
+     * @brief 在设备的长连接 shell 会话中执行命令（输入、快捷命令等高频短命令）
+     *
+     * 会话按设备首次使用时打开并保持，断开后下次调用自动重开；
+     * 会话无法打开时退回一次性 shell:，此时 exit_code 为 -1。
+     * 会话中途断开时不重试，避免重复执行点击等有副作用的命令。
+     */
+    AdbShellResult shell_run(std::string_view device_id, std::string_view command);
+    // 关闭设备的长连接 shell 会话
+    void close_shell_session(std::string_view device_id);
+    // 打开 exec:<command> 原始双向字节流（无 pty、二进制安全），失败返回空
+    std::optional<boost::asio::ip::tcp::socket> exec_stream(std::string_view device_id, std::string_view command);
     bool capture_screenshot(std::string_view device_id, std::string_view save_path);
-    bool pull(std::string_view device_id, std::string_view remote_path, std::string_view local_path);
-    bool push(std::string_view device_id, std::string_view local_path, std::string_view remote_path);
+    // 获取 PNG 编码的截图数据
+    bool capture_png(std::string_view device_id, std::string& out_png);
+    /**
+     * @brief 获取未编码的原始帧，跳过设备端 PNG 编码与主机端解码
+     * @param frame 输出帧，像素缓冲区跨调用复用
+     * @param mode RAW 使用 screencap 原始输出，FRAMEBUFFER 使用 framebuffer: 服务
+     */
+    bool capture_raw(std::string_view device_id, AdbRawFrame& frame, AdbCaptureMode mode = AdbCaptureMode::RAW);
+    /**
+     * @brief 局部截图：只传输覆盖给定行区间的像素
+     *
+     * 设备端用 dd 按字节偏移截取 screencap 原始输出中的对应行，像素写入整帧大小的
+     * 稀疏帧，frame.valid_rows 记录有效行，其余行置零。尚未缓存屏幕几何信息时退化为一次整帧原始截图；
+     * 截取失败时整帧重试，连续多次短读且几何信息未变则之后该设备只走整帧。
+     */
+    bool capture_rows(std::string_view device_id, const std::vector<AdbRowRange>& rows, AdbRawFrame& frame);
+    // 设置/查询设备的截图传输方式（未设置时为 PNG）
+    void set_capture_mode(std::string_view device_id, AdbCaptureMode mode);
+    AdbCaptureMode capture_mode(std::string_view device_id);
+    // 设备各传输方式的累计截图统计（带宽、耗时、解压 CPU）
+    std::map<AdbCaptureMode, AdbCaptureStats> capture_stats(std::string_view device_id);
+
+    /**
+     * @brief 通过 sync: 协议拉取/推送文件，64 KiB 分块直接与磁盘流式读写
+     * @param stats 可选，输出传输字节数、耗时与吞吐量
+     * @param resume 为 true 时从已有的部分文件末尾续传（假定已有部分是完整前缀）
+     */
+    bool pull(std::string_view device_id, std::string_view remote_path, std::string_view local_path,
+              AdbTransferStats* stats = nullptr, bool resume = false);
+    bool push(std::string_view device_id, std::string_view local_path, std::string_view remote_path,
+              AdbTransferStats* stats = nullptr, bool resume = false);
+    // 查询远端文件信息，不存在时 mode 为 0
+    AdbFileStat stat(std::string_view device_id, std::string_view remote_path);
+
+    // 连接池命中统计（端点缓存与预握手 socket）
+    AdbPoolStats pool_stats() const;
+
+    /**
+     * 截止时间与取消：一次性命令、截图、stat 与会话内命令默认 default_timeout 后超时，
+     * pull/push 与流式 shell 不设默认超时，只受 AdbCallScope 与取消约束。
+     * 超时或取消时关闭连接、立即以失败返回，last_error() 给出原因。
+     */
+    // 默认超时（默认 10 s），0 表示不限
+    void set_default_timeout(std::chrono::milliseconds timeout);
+    // 中断所有线程上在途的阻塞调用（之后的调用不受影响）
+    void cancel_all();
+    // 当前线程上一次调用的失败原因
+    AdbError last_error() const;
+    // 累计超时与取消次数
+    AdbCallStats call_stats() const;
+
+    /**
+     * 协程接口：与同名阻塞接口行为一致，在 io_context() 上 co_spawn 运行。
+     * 事件循环由连接池的后台线程驱动，单线程即可让多个设备的截图、输入与文件传输同时在途。
+     * 参数按值传递，协程挂起期间不依赖调用方的临时对象。
+     */
+    boost::asio::io_context& io_context() { return io_context_; }
+    boost::asio::awaitable<std::map<std::string, AdbDeviceStatus>> async_list_devices();
+    boost::asio::awaitable<std::string> async_shell(std::string device_id, std::string command);
+    boost::asio::awaitable<bool> async_capture_screenshot(std::string device_id, std::string filename);
+    boost::asio::awaitable<bool> async_capture_png(std::string device_id, std::string& out_png);
+    boost::asio::awaitable<bool> async_capture_raw(std::string device_id, AdbRawFrame& frame,
+                                                   AdbCaptureMode mode = AdbCaptureMode::RAW);
+    // 不支持断点续传
+    boost::asio::awaitable<bool> async_pull(std::string device_id, std::string remote_path, std::string local_path,
+                                            AdbTransferStats* stats = nullptr);
+    boost::asio::awaitable<bool> async_push(std::string device_id, std::string local_path, std::string remote_path,
+                                            AdbTransferStats* stats = nullptr);
 
 private:
     // 连接到 ADB Server
     boost::asio::ip::tcp::socket connect_to_server(std::string_view host = "127.0.0.1", std::string_view port = "5037");
+    // 选择设备并打开服务，返回服务已确认（OKAY）的 socket，失败抛出异常；watchdog 非空时监视握手过程
+    boost::asio::ip::tcp::socket open_service(std::string_view device_id, std::string_view service, AdbWatchdog* watchdog = nullptr,
+                                              std::string_view host = "127.0.0.1", std::string_view port = "5037");
+    // 直连设备的传输，断开时重新握手；不是直连设备时返回空，重连失败抛出异常
+    std::shared_ptr<AdbdTransport> direct_transport(std::string_view device_id, AdbWatchdog* watchdog);
+    // 协程版 open_service：池中无预握手 socket 时异步建连并握手；直连设备断开时不在协程中重连
+    boost::asio::awaitable<boost::asio::ip::tcp::socket> async_open_service(std::string device_id, std::string service);
+    // 解析 host:devices 的输出
+    static std::map<std::string, AdbDeviceStatus> parse_device_list(std::string_view payload);
+    // 并入直连设备
+    void add_direct_devices(std::map<std::string, AdbDeviceStatus>& devices);
+    // 当前调用的截止时间：AdbCallScope 与默认超时（use_default 为 true 时）中较早者
+    std::chrono::steady_clock::time_point call_deadline(bool use_default) const;
+    // 当前调用绑定的取消令牌（cancel_all 与 AdbCallScope）
+    std::vector<std::shared_ptr<AdbCancelToken>> call_tokens() const;
+    // 记录调用结果：看门狗已触发时以超时/取消为准，并累计计数
+    void finish_call(const AdbWatchdog& watchdog, AdbError failure);
+    // 是否为超时或取消（此时不再尝试兜底路径）
+    static bool interrupted(AdbError error) { return error == AdbError::TIMEOUT || error == AdbError::CANCELLED; }
+    // 打开流式 shell 并由看门狗监视
+    AdbShellStream open_shell_stream(std::string_view device_id, std::string_view command, size_t buffer_size, AdbWatchdog* watchdog);
+    // 取设备可用的 shell 会话，没有或已断开时重新打开，失败返回空
+    std::shared_ptr<AdbShellSession> shell_session(std::string_view device_id);
+    // 为设备端 shell 命令转义参数
+    static std::string shell_quote(std::string_view arg);
     // 发送 ADB 协议命令
     std::string send_command(std::string_view command, std::string_view host = "127.0.0.1", std::string_view port = "5037");
     // 选择设备并发送命令
     std::string send_device_command(std::string_view device_id, std::string_view command, std::string_view host = "127.0.0.1", std::string_view port = "5037");
 
+    // 查询设备 screencap 原始头部长度，未知时返回 0
+    size_t cached_header_size(std::string_view device_id);
+    // 记录整帧原始截图得到的屏幕几何信息
+    void cache_geometry(std::string_view device_id, const AdbRawFrame& frame, size_t header_size);
+    std::optional<AdbScreenGeometry> cached_geometry(std::string_view device_id);
+    // 收尾一次原始截图：缓存几何信息并累计统计
+    void finish_capture(std::string_view device_id, AdbCaptureMode mode, AdbRawFrame& frame,
+                        const AdbFrameDecoder& decoder, bool ok, std::chrono::steady_clock::duration elapsed);
+    // 累计一次截图统计
+    void record_capture(std::string_view device_id, AdbCaptureMode mode, const AdbCaptureStats& sample, bool ok);
+
     boost::asio::io_context io_context_;  // ASIO IO上下文
-    boost::asio::ip::tcp::resolver resolver_; // TCP解析器
+    AdbConnectionPool pool_; // 连接池（端点缓存 + 预握手 socket）
     std::string work_dir_; // ADB工作目录
+    std::mutex cache_mutex_; // 保护以下设备信息缓存
+    std::map<std::string, AdbScreenGeometry> screen_geometry_; // 设备屏幕几何信息与 screencap 头部长度
+    std::set<std::string> partial_unsupported_; // 不支持局部截取的设备
+    std::map<std::string, int> partial_failures_; // 设备局部截取连续短读次数
+    std::map<std::string, AdbCaptureMode> capture_modes_; // 设备截图传输方式
+    std::map<std::string, std::map<AdbCaptureMode, AdbCaptureStats>> capture_stats_; // 设备截图统计
+    std::mutex session_mutex_; // 保护 shell_sessions_
+    std::map<std::string, std::shared_ptr<AdbShellSession>> shell_sessions_; // 设备长连接 shell 会话
+    std::mutex direct_mutex_; // 保护 direct_devices_ 与 adb_key_
+    std::map<std::string, std::shared_ptr<AdbdTransport>> direct_devices_; // 直连设备，值为空表示尚未连上
+    std::shared_ptr<const AdbRsaKey> adb_key_; // 直连认证密钥，首次直连时加载
+    std::atomic<int64_t> default_timeout_ms_{10000}; // 默认超时（毫秒），0 不限
+    std::atomic<std::shared_ptr<AdbCancelToken>> cancel_all_; // cancel_all() 时取消并换新
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> cancellations_{0};
+    std::once_flag tracking_started_;
+    std::unique_ptr<AdbDeviceTracker> tracker_; // 设备跟踪，回调会访问上面的成员，须最后声明（最先析构）
 };
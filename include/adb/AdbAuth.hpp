@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct evp_pkey_st;
+
+/**
+ * @brief adbd 认证用的 RSA 密钥
+ *
+ * 私钥为 PEM 格式，与 adb 的 ~/.android/adbkey 通用：复用该文件时，已授权过本机 adb 的设备无需再次确认。
+ * 设备发来 20 字节令牌后，先用私钥签名（PKCS#1 v1.5 / SHA-1 摘要）；
+ * 设备不认识该密钥时再发送 Android 格式的公钥，由用户在设备上确认。
+ */
+class AdbRsaKey {
+public:
+    ~AdbRsaKey();
+
+    AdbRsaKey(const AdbRsaKey&) = delete;
+    AdbRsaKey& operator=(const AdbRsaKey&) = delete;
+
+    /**
+     * @brief 读取 PEM 私钥，不存在时生成 2048 位密钥并写入 path（公钥写入 path.pub）
+     * @return 失败时返回空
+     */
+    static std::shared_ptr<AdbRsaKey> load_or_create(const std::string& path);
+    // 默认密钥路径：$ANDROID_USER_HOME/adbkey 或 ~/.android/adbkey 已存在时复用，否则为 <work_dir>/adbkey
+    static std::string default_path(std::string_view work_dir);
+
+    // 对 AUTH 令牌签名，失败返回空
+    std::string sign(std::string_view token) const;
+    // Android 格式公钥：base64(RSAPublicKey) + " 用户名@主机名"
+    std::string public_key() const;
+
+private:
+    explicit AdbRsaKey(evp_pkey_st* key) : key_(key) {}
+
+    evp_pkey_st* key_;
+};
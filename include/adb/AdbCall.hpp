@@ -0,0 +1,155 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// ADBClient 操作失败原因（ADBClient::last_error()）
+enum class AdbError {
+    NONE,
+    TIMEOUT,     // 超过截止时间，连接已被关闭
+    CANCELLED,   // 被取消令牌或 ADBClient::cancel_all() 中断
+    CONNECTION,  // 无法连接 ADB Server 或连接中途断开
+    REJECTED,    // ADB Server 返回 FAIL（设备不存在、离线、服务不支持等）
+    IO           // 本地文件读写失败或输出不完整
+};
+
+std::string_view adbErrorToString(AdbError error);
+
+/**
+ * @brief 取消令牌
+ *
+ * 可在多个调用、多个线程间共享。cancel() 立即关闭所有绑定到该令牌的在途连接，
+ * 之后绑定的调用直接以 CANCELLED 失败，直到 reset()。
+ */
+class AdbCancelToken {
+public:
+    void cancel();
+    bool cancelled() const;
+    void reset();
+
+private:
+    friend class AdbWatchdog;
+    // 注册取消时执行的中断动作，已取消时立即执行；返回注册 ID
+    uint64_t bind(std::function<void()> interrupt);
+    // 注销中断动作，返回后该动作不会再执行
+    void unbind(uint64_t id);
+
+    mutable std::mutex mutex_; // 执行中断动作期间持有，保证 unbind 返回后不再执行
+    bool cancelled_ = false;
+    uint64_t next_id_ = 1;
+    std::map<uint64_t, std::function<void()>> interrupts_;
+};
+
+// 单次调用的截止时间与取消令牌
+struct AdbCallOptions {
+    std::chrono::milliseconds timeout{0};      // 0 使用客户端默认超时
+    std::shared_ptr<AdbCancelToken> cancel;    // 可为空
+};
+
+/**
+ * @brief 为当前线程上的 ADBClient 调用设置截止时间与取消令牌
+ *
+ * 作用域内的所有阻塞调用共享同一个截止时间（构造时起算），离开作用域后恢复外层设置：
+ *     AdbCallScope scope({.timeout = std::chrono::seconds(3), .cancel = token});
+ *     adb.capture_raw(device, frame);
+ */
+class AdbCallScope {
+public:
+    explicit AdbCallScope(const AdbCallOptions& options);
+    ~AdbCallScope();
+
+    AdbCallScope(const AdbCallScope&) = delete;
+    AdbCallScope& operator=(const AdbCallScope&) = delete;
+
+    // 当前线程最内层的作用域，没有时为空
+    static const AdbCallScope* current();
+
+    std::chrono::steady_clock::time_point deadline() const { return deadline_; }
+    const std::shared_ptr<AdbCancelToken>& cancel() const { return cancel_; }
+
+private:
+    std::chrono::steady_clock::time_point deadline_; // time_point::max() 表示不限时
+    std::shared_ptr<AdbCancelToken> cancel_;
+    const AdbCallScope* outer_;
+};
+
+// 超时与取消计数
+struct AdbCallStats {
+    uint64_t timeouts = 0;
+    uint64_t cancellations = 0;
+};
+
+/**
+ * @brief 单次阻塞调用的看门狗
+ *
+ * 在 IO 上下文中挂一个截止定时器并绑定取消令牌；到期或取消时对被监视的连接执行中断
+ * （shutdown socket），阻塞在 read/write 中的调用线程随即返回错误，调用方据 reason() 区分超时与取消。
+ */
+class AdbWatchdog {
+public:
+    using tcp = boost::asio::ip::tcp;
+
+    AdbWatchdog(boost::asio::io_context& io_context, std::chrono::steady_clock::time_point deadline,
+                std::vector<std::shared_ptr<AdbCancelToken>> tokens);
+    ~AdbWatchdog();
+
+    AdbWatchdog(const AdbWatchdog&) = delete;
+    AdbWatchdog& operator=(const AdbWatchdog&) = delete;
+
+    /**
+     * @brief 监视期间的守卫
+     *
+     * 析构时恢复之前监视的对象（可嵌套，如 sync 会话中临时打开的 exec: 连接）。
+     * 须在被监视对象之后声明，保证先于它析构。
+     */
+    class Watch {
+    public:
+        Watch(AdbWatchdog* watchdog, std::function<void()> previous)
+            : watchdog_(watchdog), previous_(std::move(previous)) {}
+        Watch(Watch&& other) noexcept
+            : watchdog_(std::exchange(other.watchdog_, nullptr)), previous_(std::move(other.previous_)) {}
+        Watch& operator=(Watch&&) = delete;
+        ~Watch() { if (watchdog_) watchdog_->restore(std::move(previous_)); }
+
+    private:
+        AdbWatchdog* watchdog_;
+        std::function<void()> previous_;
+    };
+
+    // 监视 socket，已到期或已取消时立即中断
+    [[nodiscard]] Watch watch(tcp::socket& socket);
+    // 以自定义动作中断（如 shell 会话、sync 会话内部的 socket）
+    [[nodiscard]] Watch watch(std::function<void()> interrupt);
+    // 停止监视，返回后不会再中断任何对象
+    void release() { restore(nullptr); }
+
+    // 中断原因，未触发时为 NONE
+    AdbError reason() const;
+    bool triggered() const { return reason() != AdbError::NONE; }
+
+private:
+    // 换回之前监视的对象，已触发时立即中断它
+    void restore(std::function<void()> interrupt);
+
+    struct State {
+        std::mutex mutex;
+        std::function<void()> interrupt;
+        AdbError reason = AdbError::NONE;
+        boost::asio::steady_timer timer;
+
+        explicit State(boost::asio::io_context& io_context) : timer(io_context) {}
+        void trigger(AdbError why);
+    };
+
+    boost::asio::io_context& io_context_;
+    std::shared_ptr<State> state_;
+    std::vector<std::pair<std::shared_ptr<AdbCancelToken>, uint64_t>> bindings_;
+    bool has_deadline_ = false;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// 连接池统计
+struct AdbPoolStats {
+    uint64_t endpoint_hits = 0;     // 端点解析缓存命中
+    uint64_t endpoint_misses = 0;   // 端点解析缓存未命中（实际 resolve）
+    uint64_t transport_hits = 0;    // 取到预握手 socket
+    uint64_t transport_misses = 0;  // 现场建连并握手
+    uint64_t stale_dropped = 0;     // 被服务端关闭或过期而丢弃的空闲 socket
+    uint64_t warmed = 0;            // 后台预热成功的 socket 数
+};
+
+/**
+ * @brief ADB Server 连接池
+ *
+ * ADB 的一条 socket 只能承载一次 host:transport + 一个服务，服务结束后即被关闭，
+ * 因此这里不复用"用过的"连接，而是缓存端点解析结果，并为每个设备在后台预先完成
+ * 建连与 host:transport: 握手，下一条命令直接取用，省掉 resolve/connect/握手的往返。
+ */
+class AdbConnectionPool {
+public:
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @param io_context 所有 socket 所属的 IO 上下文，由连接池的后台线程驱动
+     * @param spare_per_device 每个设备保持的预握手 socket 数量，0 表示关闭预热
+     * @param max_idle 空闲 socket 的最长保留时间，超时后丢弃重建
+     */
+    explicit AdbConnectionPool(boost::asio::io_context& io_context,
+                               size_t spare_per_device = 1,
+                               std::chrono::seconds max_idle = std::chrono::seconds(30));
+    ~AdbConnectionPool();
+
+    AdbConnectionPool(const AdbConnectionPool&) = delete;
+    AdbConnectionPool& operator=(const AdbConnectionPool&) = delete;
+
+    // 连接到 ADB Server（使用缓存的端点），失败抛出异常
+    tcp::socket connect(std::string_view host, std::string_view port);
+
+    // 取得已完成 host:transport:<device_id> 握手的 socket，失败抛出异常
+    tcp::socket acquire_transport(std::string_view device_id, std::string_view host, std::string_view port);
+
+    // 只取池中现成的预握手 socket，未命中返回空（供协程接口异步建连）
+    std::optional<tcp::socket> try_acquire(std::string_view device_id, std::string_view host, std::string_view port);
+
+    // 在已连接的 socket 上完成 host:transport:<device_id> 握手，失败抛出异常
+    static void request_transport(tcp::socket& socket, std::string_view device_id);
+
+    // 解析（并缓存）ADB Server 端点
+    tcp::resolver::results_type resolve(std::string_view host, std::string_view port);
+
+    // 协程版本：未命中缓存时异步解析，不阻塞事件循环
+    boost::asio::awaitable<tcp::resolver::results_type> async_resolve(std::string host, std::string port);
+
+    // 丢弃设备的所有空闲 socket（设备断开或重连时调用）
+    void invalidate(std::string_view device_id);
+
+    AdbPoolStats stats() const;
+
+private:
+    struct IdleSocket {
+        tcp::socket socket;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct DevicePool {
+        std::deque<IdleSocket> idle;
+        size_t warming = 0;     // 正在后台握手的数量
+        uint64_t generation = 0; // invalidate 后递增，丢弃过期的预热结果
+        std::string host;
+        std::string port;
+    };
+
+    // 同步建连并完成 transport 握手
+    tcp::socket handshake(std::string_view device_id, std::string_view host, std::string_view port);
+    // 补足设备的预握手 socket（需持有 mutex_）
+    void schedule_warmup(const std::string& device_id, DevicePool& pool);
+    // socket 是否仍可用（对端未关闭）
+    static bool is_alive(tcp::socket& socket);
+
+    boost::asio::io_context& io_context_;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard_;
+    size_t spare_per_device_;
+    std::chrono::seconds max_idle_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, tcp::resolver::results_type> endpoints_;
+    std::map<std::string, DevicePool> devices_;
+    AdbPoolStats stats_;
+
+    std::thread worker_;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "AdbStatus.hpp"
+#include <atomic>
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 设备表中的一项（track-devices-l 的一行）
+struct AdbDeviceInfo {
+    std::string serial;
+    AdbDeviceStatus status = AdbDeviceStatus::OFFLINE;
+    std::string product;
+    std::string model;
+    std::string device;
+    uint64_t transport_id = 0;
+};
+
+using AdbDeviceTable = std::map<std::string, AdbDeviceInfo>;
+
+// 设备状态变化，previous/current 为空表示变化前/后设备不在列表中
+struct AdbDeviceEvent {
+    std::string serial;
+    std::optional<AdbDeviceStatus> previous;
+    std::optional<AdbDeviceStatus> current;
+    AdbDeviceInfo info; // 变化后的设备信息，设备移除时为最后一次已知的信息
+};
+
+using AdbDeviceCallback = std::function<void(const AdbDeviceEvent&)>;
+
+/**
+ * @brief 基于 host:track-devices-l 的设备跟踪
+ *
+ * 后台线程保持一条到 ADB Server 的长连接，服务端在设备列表变化时主动推送完整列表，
+ * 与上一份列表比较后对每个状态变化调用回调，并原子替换设备表快照，
+ * 读取方无需加锁、无需往返即可得到当前设备表。
+ * 连接断开（如 adb kill-server）时视为全部设备移除，并按退避间隔重连。
+ */
+class AdbDeviceTracker {
+public:
+    AdbDeviceTracker(std::string host = "127.0.0.1", std::string port = "5037");
+    ~AdbDeviceTracker();
+
+    AdbDeviceTracker(const AdbDeviceTracker&) = delete;
+    AdbDeviceTracker& operator=(const AdbDeviceTracker&) = delete;
+
+    // 启动后台跟踪线程（重复调用无效果）
+    void start();
+    void stop();
+
+    /**
+     * @brief 订阅设备状态变化，返回订阅 ID
+     *
+     * 回调在跟踪线程上执行，应尽快返回；其中可以调用 subscribe/unsubscribe。
+     * 订阅时不补发当前已有设备，需要时先读 snapshot()。
+     */
+    uint64_t subscribe(AdbDeviceCallback callback);
+    // 取消订阅，返回后该回调不会再被调用（在回调内取消自身除外）
+    void unsubscribe(uint64_t id);
+
+    // 当前设备表快照（不为空），无锁读取
+    std::shared_ptr<const AdbDeviceTable> snapshot() const { return table_.load(std::memory_order_acquire); }
+    // 是否已连上 ADB Server 并收到过设备列表
+    bool connected() const { return connected_.load(std::memory_order_acquire); }
+    // 累计收到的设备列表推送次数
+    uint64_t updates() const { return updates_.load(std::memory_order_relaxed); }
+
+    // 解析 devices / devices -l 格式的设备列表
+    static AdbDeviceTable parse_device_table(std::string_view payload);
+
+private:
+    // 跟踪协程：连接、读取推送、断开后退避重连
+    boost::asio::awaitable<void> run();
+    boost::asio::awaitable<void> track_once();
+    // 用新设备表替换快照并通知变化
+    void apply(AdbDeviceTable table);
+
+    std::string host_;
+    std::string port_;
+    boost::asio::io_context io_context_;
+    boost::asio::steady_timer retry_timer_;
+    std::optional<boost::asio::ip::tcp::socket> socket_; // 当前跟踪连接，仅在跟踪线程访问
+    bool stopping_ = false;                               // 仅在跟踪线程访问
+    std::thread worker_;
+    bool started_ = false;
+
+    std::atomic<std::shared_ptr<const AdbDeviceTable>> table_;
+    std::atomic<bool> connected_{false};
+    std::atomic<uint64_t> updates_{0};
+
+    std::recursive_mutex callback_mutex_; // 调用回调期间持有，unsubscribe 借此等待进行中的回调结束
+    std::mutex subscriber_mutex_; // 保护 subscribers_ 与 next_id_
+    std::map<uint64_t, std::shared_ptr<AdbDeviceCallback>> subscribers_;
+    uint64_t next_id_ = 1;
+};
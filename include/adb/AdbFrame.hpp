@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 截图传输方式
+enum class AdbCaptureMode {
+    PNG,         // exec-out:screencap -p，设备端 PNG 编码
+    RAW,         // exec-out:screencap，头部 + 原始像素
+    FRAMEBUFFER, // framebuffer: 服务
+    GZIP_RAW     // exec-out:screencap | gzip -1，主机端流式解压，适合 Wi-Fi 连接
+};
+
+// 截图统计：按设备、按传输方式累计，用于比较带宽与主机 CPU 开销
+struct AdbCaptureStats {
+    uint64_t frames = 0;
+    uint64_t failures = 0;
+    uint64_t wire_bytes = 0;     // 网络上实际传输的字节数
+    uint64_t pixel_bytes = 0;    // 解码后的像素字节数
+    double total_seconds = 0.0;  // 截图总耗时
+    double decode_seconds = 0.0; // 主机端解压耗时（CPU）
+
+    double avg_ms() const { return frames ? total_seconds * 1000.0 / frames : 0.0; }
+    double compression_ratio() const {
+        return wire_bytes ? static_cast<double>(pixel_bytes) / wire_bytes : 0.0;
+    }
+};
+
+// Android PixelFormat 取值（screencap 头部中的 format 字段）
+enum class AdbPixelFormat : uint32_t {
+    UNKNOWN = 0,
+    RGBA_8888 = 1,
+    RGBX_8888 = 2,
+    RGB_888 = 3,
+    RGB_565 = 4,
+    BGRA_8888 = 5
+};
+
+// 连续的行区间 [first, first + count)
+struct AdbRowRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+// 设备屏幕几何信息，整帧原始截图后缓存，局部截图据此计算字节偏移
+struct AdbScreenGeometry {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    AdbPixelFormat format = AdbPixelFormat::UNKNOWN;
+    size_t header_size = 0; // screencap 原始头部长度（12 或 16）
+};
+
+// 原始帧：像素按行连续存放，缓冲区跨帧复用
+struct AdbRawFrame {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    AdbPixelFormat format = AdbPixelFormat::UNKNOWN;
+    std::vector<uint8_t> pixels;
+    std::vector<AdbRowRange> valid_rows; // 局部截图时有效的行区间，空表示整帧有效
+
+    uint32_t bytes_per_pixel() const {
+        switch (format) {
+            case AdbPixelFormat::RGB_888: return 3;
+            case AdbPixelFormat::RGB_565: return 2;
+            case AdbPixelFormat::UNKNOWN: return 0;
+            default: return 4;
+        }
+    }
+    size_t row_bytes() const { return static_cast<size_t>(width) * bytes_per_pixel(); }
+    size_t frame_bytes() const { return row_bytes() * height; }
+};
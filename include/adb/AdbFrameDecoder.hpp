@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AdbFrame.hpp"
+#include <boost/asio/buffer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 截图数据流的增量解码器
+ *
+ * 读取方循环调用 prepare() 取得下一段可写缓冲区、把 socket 数据直接读入其中、
+ * 再 commit() 实际字节数，直到对端关闭后调用 finish()。阻塞与协程两种读取方式共用同一解码逻辑，
+ * 原始像素直接读入帧缓冲，不经过中间拷贝。
+ */
+class AdbFrameDecoder {
+public:
+    virtual ~AdbFrameDecoder() = default;
+
+    // 下一次读取应写入的缓冲区（非空）
+    virtual boost::asio::mutable_buffer prepare() = 0;
+    // 提交读入的 n 字节，数据非法时返回 false
+    virtual bool commit(size_t n) = 0;
+    // 数据流结束，校验完整性
+    virtual bool finish() = 0;
+
+    // screencap 原始头部长度（解码成功后有效，用于缓存）
+    size_t header_size() const { return header_size_; }
+    size_t wire_bytes() const { return wire_bytes_; }
+    double decode_seconds() const { return std::chrono::duration<double>(decode_time_).count(); }
+
+    /**
+     * @brief 创建对应传输方式的解码器
+     * @param frame 输出帧，解码器持有其引用
+     * @param known_header_size 已缓存的 screencap 头部长度，未知为 0
+     */
+    static std::unique_ptr<AdbFrameDecoder> create(AdbCaptureMode mode, AdbRawFrame& frame, size_t known_header_size);
+    // 传输方式对应的设备服务名
+    static const char* service(AdbCaptureMode mode);
+
+protected:
+    size_t header_size_ = 0;
+    size_t wire_bytes_ = 0;
+    std::chrono::steady_clock::duration decode_time_{};
+};
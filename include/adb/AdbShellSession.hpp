@@ -0,0 +1,74 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// 持久 shell 会话中一条命令的执行结果
+struct AdbShellResult {
+    bool ok = false;        // 命令已执行且读到结束标记
+    int exit_code = -1;     // 命令退出码，未知时为 -1
+    std::string out;        // 标准输出
+    std::string err;        // 标准错误（仅 shell v2 单独区分，否则并入 out）
+};
+
+/**
+ * @brief 设备上的长连接 shell 会话
+ *
+ * 一次打开 shell,v2,raw:（不支持 shell v2 的设备退回 exec:sh），之后每条命令写入 shell 的标准输入，
+ * 命令后追加 echo <标记>$?，读到标记即得到该命令的完整输出与退出码，省去每条命令的建连与 shell 启动。
+ * shell v2 按 [id:1][len:4 小端][payload] 分帧，标准输出、标准错误与 shell 自身的退出分别独立。
+ *
+ * 命令的标准输入重定向到 /dev/null，避免读取 stdin 的命令吞掉后续标记；
+ * 命令中的 exit 或语法错误会结束整个会话，此时 run() 返回失败，会话不再可用。
+ */
+class AdbShellSession {
+public:
+    // shell v2 数据包类型
+    enum PacketId : uint8_t {
+        STDIN = 0,
+        STDOUT = 1,
+        STDERR = 2,
+        EXIT = 3,
+        CLOSE_STDIN = 4,
+    };
+
+    /**
+     * @param socket 已打开 shell,v2,raw: 或 exec:sh 服务的 socket
+     * @param shell_v2 socket 上的数据是否为 shell v2 分帧
+     */
+    AdbShellSession(boost::asio::ip::tcp::socket socket, bool shell_v2);
+    ~AdbShellSession();
+
+    AdbShellSession(const AdbShellSession&) = delete;
+    AdbShellSession& operator=(const AdbShellSession&) = delete;
+
+    // 执行一条命令并等待其结束，多线程调用时串行执行
+    AdbShellResult run(std::string_view command);
+    // 会话是否仍可用（对端未关闭）
+    bool alive();
+    bool shell_v2() const { return shell_v2_; }
+    // 关闭 shell 标准输入并断开
+    void close();
+    // 从其他线程中断进行中的 run()（超时/取消），会话随之失效
+    void interrupt();
+
+private:
+    void write_stdin(std::string_view data);
+    // 读取一段输出追加到 out_/err_，会话结束时返回 false
+    bool read_more();
+    // 在 buffer 中取出标记之前的内容；exit_code 非空时解析标记后的退出码。标记行不完整时返回 false
+    static bool take_until_marker(std::string& buffer, std::string_view marker, std::string& before, int* exit_code);
+
+    boost::asio::ip::tcp::socket socket_;
+    bool shell_v2_;
+    bool alive_ = true;
+    uint64_t sequence_ = 0;
+    uint32_t nonce_;        // 会话随机数，避免标记与命令输出偶然重合
+    std::string out_;       // 尚未归属到命令的标准输出
+    std::string err_;       // 尚未归属到命令的标准错误
+    std::string buffer_;    // 复用的读缓冲区
+    std::mutex mutex_;
+};
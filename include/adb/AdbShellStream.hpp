@@ -0,0 +1,91 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// 流式回调：返回 false 时停止读取并关闭连接（如 logcat 中等到了目标事件）
+using AdbChunkCallback = std::function<bool(std::string_view chunk)>;
+using AdbLineCallback = std::function<bool(std::string_view line)>;
+
+/**
+ * @brief 边收边读的 shell: 输出流
+ *
+ * 输出按到达顺序以原始块或行的形式交给调用方，内部只用一块固定大小的缓冲区，
+ * 跟踪 logcat 或读取大段 dumpsys 时内存占用恒定，第一行到达即可处理。
+ * 返回的 string_view 指向内部缓冲区，只在下一次读取前有效。
+ *
+ * 行不含行尾的 \r\n；超过缓冲区长度的行被切成多段依次返回。
+ * 支持范围 for 逐行遍历：for (std::string_view line : stream) { ... }
+ */
+class AdbShellStream {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 16 * 1024;
+
+    // 未打开的流，ok() 为 false
+    AdbShellStream() = default;
+    explicit AdbShellStream(boost::asio::ip::tcp::socket socket, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    ~AdbShellStream();
+
+    AdbShellStream(AdbShellStream&&) noexcept = default;
+    AdbShellStream& operator=(AdbShellStream&&) noexcept = default;
+
+    // 流已打开且没有读取错误（读到结尾仍为 true，close() 之后为 false）
+    bool ok() const { return socket_.has_value() && !closed_ && !error_; }
+    // 对端已关闭且缓冲区已读完
+    bool eof() const { return eof_ && begin_ == end_; }
+
+    // 读取下一块原始输出，结束或出错时返回 false
+    bool next_chunk(std::string_view& chunk);
+    // 读取下一行，结束或出错时返回 false
+    bool next_line(std::string_view& line);
+    // 提前结束：关闭连接，设备端命令随之收到 SIGPIPE/SIGHUP
+    void close();
+    // 从其他线程中断阻塞中的读取（超时/取消），之后读取返回 false
+    void interrupt();
+
+    // 按行遍历的输入迭代器
+    class LineIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        LineIterator() = default;
+        explicit LineIterator(AdbShellStream* stream) : stream_(stream) { ++*this; }
+
+        reference operator*() const { return line_; }
+        pointer operator->() const { return &line_; }
+        LineIterator& operator++() {
+            if (stream_ && !stream_->next_line(line_)) stream_ = nullptr;
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(const LineIterator& other) const { return stream_ == other.stream_; }
+
+    private:
+        AdbShellStream* stream_ = nullptr;
+        std::string_view line_;
+    };
+
+    LineIterator begin() { return LineIterator(this); }
+    LineIterator end() { return LineIterator(); }
+
+private:
+    // 读入更多数据追加到缓冲区末尾，对端关闭或出错时返回 false
+    bool fill();
+
+    std::optional<boost::asio::ip::tcp::socket> socket_;
+    std::vector<char> buffer_;
+    size_t begin_ = 0; // 未消费数据的起止位置
+    size_t end_ = 0;
+    bool eof_ = false;
+    bool error_ = false;
+    bool closed_ = false;
+};
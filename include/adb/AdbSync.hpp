@@ -0,0 +1,65 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+// sync: 协议单个 DATA 包的最大负载
+constexpr size_t ADB_SYNC_MAX_CHUNK = 64 * 1024;
+
+// 远端文件信息（sync STAT）
+struct AdbFileStat {
+    uint32_t mode = 0;
+    uint32_t size = 0;
+    uint32_t mtime = 0;
+
+    bool exists() const { return mode != 0; }
+};
+
+// 单次文件传输统计
+struct AdbTransferStats {
+    uint64_t bytes = 0;         // 本次实际传输的字节数
+    uint64_t total_size = 0;    // 文件总大小
+    uint64_t resumed_from = 0;  // 断点续传起始偏移，0 表示完整传输
+    double seconds = 0.0;       // 传输耗时
+
+    // 吞吐量（MiB/s）
+    double throughput_mib() const {
+        return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+/**
+ * @brief ADB sync: 服务会话
+ *
+ * 在已完成 host:transport + sync: 的 socket 上收发 STAT/RECV/SEND/DATA/DONE 请求，
+ * 文件数据按 64 KiB 分块在 socket 与磁盘之间流式搬运，不在内存中缓存整个文件。
+ * 协议错误或远端 FAIL 时抛出异常。
+ */
+class AdbSyncConnection {
+public:
+    explicit AdbSyncConnection(boost::asio::ip::tcp::socket socket);
+    ~AdbSyncConnection();
+
+    AdbFileStat stat(std::string_view remote_path);
+    // 接收远端文件写入 out，返回写入字节数
+    uint64_t recv(std::string_view remote_path, std::ostream& out);
+    // 将 in 的剩余内容发送到远端，返回发送字节数
+    uint64_t send(std::string_view remote_path, uint32_t mode, uint32_t mtime, std::istream& in);
+    // 结束会话
+    void quit();
+    // 从其他线程中断进行中的请求（超时/取消）
+    void interrupt();
+
+private:
+    void write_request(std::string_view id, std::string_view payload);
+    void write_header(std::string_view id, uint32_t value);
+    void read_header(char id[4], uint32_t& value);
+    std::string read_fail_message(uint32_t length);
+
+    boost::asio::ip::tcp::socket socket_;
+    std::string buffer_; // 复用的分块缓冲区
+    bool closed_ = false;
+};
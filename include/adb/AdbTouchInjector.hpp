@@ -0,0 +1,95 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class ADBClient;
+
+// 设备触摸屏信息（getevent -lp 探测得到）
+struct AdbTouchDevice {
+    std::string path;           // /dev/input/eventN
+    std::string name;
+    int32_t x_min = 0, x_max = 0;
+    int32_t y_min = 0, y_max = 0;
+    int32_t slot_max = -1;      // ABS_MT_SLOT 最大值，-1 表示 A 类多点协议（无 slot）
+    int32_t tracking_max = 65535;
+    int32_t pressure_max = 0;   // 0 表示不上报 ABS_MT_PRESSURE
+    int32_t touch_major_max = 0; // 0 表示不上报 ABS_MT_TOUCH_MAJOR
+    bool has_btn_touch = false;
+};
+
+/**
+ * @brief 直接写 /dev/input/eventN 的触摸注入
+ *
+ * input tap/swipe 每次都要在设备上启动 app_process 与 Java 运行时（约 200~400 ms）。
+ * 这里一次性用 getevent -lp 找到触摸屏节点与坐标范围，再经 exec:cat > /dev/input/eventN 的长连接
+ * 直接写入二进制 input_event（与 sendevent 等价），一次触摸的全部事件合成一次写入。
+ * 支持多点触控（按手指序号 down/move/up）与由主机计时的精确滑动。
+ *
+ * 传入坐标为当前显示方向下的屏幕像素（即截图坐标），按屏幕旋转与触摸屏坐标范围换算。
+ * 写 /dev/input 需要 shell 用户属于 input 组，不满足时 init() 失败，调用方应退回 input 命令。
+ */
+class AdbTouchInjector {
+public:
+    AdbTouchInjector(ADBClient& adb, std::string device_id);
+    ~AdbTouchInjector();
+
+    AdbTouchInjector(const AdbTouchInjector&) = delete;
+    AdbTouchInjector& operator=(const AdbTouchInjector&) = delete;
+
+    // 探测触摸屏、屏幕尺寸、旋转与用户态 ABI，并打开写入通道
+    bool init();
+    bool ready() const { return ready_; }
+    const AdbTouchDevice& device() const { return touch_; }
+
+    // 点击：按下保持 hold_ms 后抬起
+    bool tap(int x, int y, int hold_ms = 30);
+    // 滑动：按 step_ms 间隔插值移动，按下到抬起总时长 duration_ms
+    bool swipe(int x1, int y1, int x2, int y2, int duration_ms, int step_ms = 8);
+
+    // 多点触控：pointer 为手指序号（0 起），超出设备 slot 数时失败
+    bool touch_down(int pointer, int x, int y);
+    bool touch_move(int pointer, int x, int y);
+    bool touch_up(int pointer);
+
+    /**
+     * @brief 告知最新截图尺寸
+     *
+     * 横竖方向与缓存的旋转不一致时（如从桌面进入横屏游戏）重新查询旋转。
+     */
+    void update_display_size(int width, int height);
+    // 重新查询屏幕旋转（0~3，对应 0/90/180/270 度）
+    void refresh_rotation();
+
+    // 解析 getevent -lp 输出，返回第一个多点触摸屏
+    static std::optional<AdbTouchDevice> parse_getevent(std::string_view output);
+
+private:
+    // 显示坐标 -> 触摸屏坐标
+    std::pair<int32_t, int32_t> map_point(int x, int y) const;
+    void append_event(std::string& out, uint16_t type, uint16_t code, int32_t value) const;
+    // 追加一帧事件：pointer 触点变化后的状态（B 类只发该 slot，A 类重发全部触点）
+    void append_frame(std::string& out, int pointer, bool down_changed);
+    // 写入一批事件，通道断开时重开一次
+    bool write_events(const std::string& events);
+    bool open_channel();
+
+    ADBClient& adb_;
+    std::string device_id_;
+    AdbTouchDevice touch_;
+    bool ready_ = false;
+    size_t event_size_ = 24;    // 64 位用户态 24 字节，32 位 16 字节
+    int natural_width_ = 0;     // 自然方向（rotation 0）下的屏幕尺寸
+    int natural_height_ = 0;
+    int rotation_ = 0;
+    int32_t next_tracking_id_ = 0;
+    std::vector<std::optional<std::pair<int32_t, int32_t>>> contacts_; // 各手指当前触摸屏坐标，空为未按下
+    std::optional<boost::asio::ip::tcp::socket> channel_;
+    std::mutex mutex_;
+};
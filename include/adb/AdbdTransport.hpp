@@ -0,0 +1,147 @@
+#pragma once
+
+#include "AdbAuth.hpp"
+#include "AdbCall.hpp"
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 报文头：command, arg0, arg1, data_length, data_check, magic（各 4 字节小端）
+constexpr size_t ADBD_HEADER_SIZE = 24;
+
+/**
+ * @brief 直连 adbd 的 ADB 传输（不经 ADB Server）
+ *
+ * 一条 TCP 连接上完成 CNXN/AUTH 握手后，以 OPEN/OKAY/WRTE/CLSE 多路复用任意多个服务流。
+ * 每个服务流经进程内 socketpair 桥接为 tcp::socket 交给调用方，sync、shell 会话、截图等
+ * 现有读写代码无需区分连接来自 ADB Server 还是直连；看门狗 shutdown 该 socket 即关闭对应的流。
+ *
+ * 流量控制遵循协议：每个流同一时刻只有一个未确认的 WRTE，设备数据写入桥接 socket 后才回 OKAY，
+ * 调用方读得慢只会让该流的设备端等待，不影响同一连接上的其他流。
+ * 报文收发都在 IO 上下文的线程上进行，open() 可从任意线程调用。
+ */
+class AdbdTransport : public std::enable_shared_from_this<AdbdTransport> {
+public:
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 建连并完成 CNXN/AUTH 握手，失败抛出异常
+     *
+     * 设备先要求签名令牌；不认识该密钥时发送公钥，等待用户在设备上确认（受 watchdog 截止时间约束）。
+     * @param key 认证密钥，为空时只能连接关闭了认证的设备
+     * @param watchdog 非空时监视建连与握手
+     */
+    static std::shared_ptr<AdbdTransport> connect(boost::asio::io_context& io_context,
+                                                  const tcp::resolver::results_type& endpoints,
+                                                  std::shared_ptr<const AdbRsaKey> key,
+                                                  AdbWatchdog* watchdog = nullptr);
+    ~AdbdTransport();
+
+    AdbdTransport(const AdbdTransport&) = delete;
+    AdbdTransport& operator=(const AdbdTransport&) = delete;
+
+    // 打开服务流，返回设备已确认（OKAY）的 socket；设备拒绝或连接断开时抛出异常
+    tcp::socket open(std::string_view service, AdbWatchdog* watchdog = nullptr);
+    // 协程版 open，须在 IO 上下文上 co_await
+    boost::asio::awaitable<tcp::socket> async_open(std::string service);
+
+    // 关闭连接与所有流
+    void close();
+    // 连接是否仍可用（断开后须重新 connect）
+    bool alive() const { return alive_.load(std::memory_order_acquire); }
+
+    // 设备 CNXN 报文中的标识，如 "device::ro.product.name=...;features=shell_v2,cmd"
+    const std::string& banner() const { return banner_; }
+    bool has_feature(std::string_view feature) const;
+    // 逗号分隔的设备特性（与 host-serial:<id>:features 的应答格式一致）
+    std::string features() const;
+    // 当前打开的流数量
+    size_t active_streams() const { return active_streams_.load(std::memory_order_relaxed); }
+
+private:
+    struct Packet {
+        uint32_t command = 0;
+        uint32_t arg0 = 0;
+        uint32_t arg1 = 0;
+        std::string payload;
+    };
+
+    using OpenHandler = std::function<void(boost::system::error_code, tcp::socket)>;
+
+    // 一个服务流：bridge 为本端持有的一端，另一端在 OKAY 前暂存于 peer
+    struct Stream {
+        uint32_t local_id;
+        uint32_t remote_id = 0;
+        tcp::socket bridge;
+        std::optional<tcp::socket> peer;
+        OpenHandler on_open;
+        std::string buffer;               // 调用方写入的数据，WRTE 确认前不复用
+        std::deque<std::string> incoming; // 设备数据，逐个写入 bridge
+        bool writing = false;             // incoming.front() 正在写入 bridge
+        bool remote_closed = false;       // 设备已发送 CLSE，incoming 写完后关闭
+        bool local_closed = false;        // 调用方已 shutdown 写端并已通知设备，等待设备的 CLSE
+        bool closed = false;
+
+        Stream(uint32_t id, tcp::socket socket) : local_id(id), bridge(std::move(socket)) {}
+    };
+
+    // 待发送报文：头部与负载分开，WRTE 负载直接引用流的缓冲区
+    struct Outgoing {
+        std::array<char, ADBD_HEADER_SIZE> header;
+        std::string payload;
+        std::shared_ptr<Stream> stream; // 非空时负载为 stream->buffer 的前 length 字节
+        size_t length = 0;
+    };
+
+    AdbdTransport(boost::asio::io_context& io_context, tcp::socket socket);
+
+    // 同步握手（start 之前，在调用线程进行）
+    void handshake(const AdbRsaKey* key);
+    Packet read_packet_sync();
+    void write_packet_sync(uint32_t command, uint32_t arg0, uint32_t arg1, std::string_view payload);
+    std::array<char, ADBD_HEADER_SIZE> make_header(uint32_t command, uint32_t arg0, uint32_t arg1,
+                                                   std::string_view payload) const;
+
+    // 以下在 IO 线程上执行
+    void start();
+    void read_header();
+    void read_payload(std::shared_ptr<Packet> packet, uint32_t length);
+    void dispatch(Packet& packet);
+    void send(uint32_t command, uint32_t arg0, uint32_t arg1, std::string payload = {});
+    void send_write(const std::shared_ptr<Stream>& stream, size_t length);
+    void flush();
+    void begin_open(uint32_t local_id, std::string service, OpenHandler handler);
+    void abort_open(uint32_t local_id);
+    void pump_bridge(const std::shared_ptr<Stream>& stream);
+    void drain_incoming(const std::shared_ptr<Stream>& stream);
+    // 关闭流；notify 为 true 时通知设备（CLSE），尚未打开的流以 ec 回调打开失败
+    void close_stream(const std::shared_ptr<Stream>& stream, bool notify,
+                      boost::system::error_code ec = boost::asio::error::operation_aborted);
+    void fail(const boost::system::error_code& ec);
+
+    boost::asio::io_context& io_context_;
+    tcp::socket socket_;
+    std::string banner_;
+    std::vector<std::string> features_;
+    uint32_t protocol_version_ = 0;
+    size_t max_payload_ = 4096; // 设备可接收的最大负载，握手后更新
+
+    std::atomic<bool> alive_{false};
+    std::atomic<uint32_t> next_id_{1};
+    std::atomic<size_t> active_streams_{0};
+
+    // 仅在 IO 线程访问
+    std::array<char, ADBD_HEADER_SIZE> read_header_{};
+    std::map<uint32_t, std::shared_ptr<Stream>> streams_;
+    std::deque<Outgoing> outbox_;
+    bool flushing_ = false;
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
 #include <optional>
+#include <regex>
 #include <variant>
 
 // OCR 区域配置
@@ -13,29 +15,44 @@ struct ROIConfig {
     int base_width = 1280;
     int base_height = 720;
     std::string preprocess = "auto";
-    std::string filter_pattern;
+    std::string filter_pattern;  // 识别结果须匹配的正则，默认取第一个匹配的部分
+    std::shared_ptr<const std::regex> filter_regex; // filter_pattern 加载时编译的结果
+    bool filter_full_match = false; // 整行须完全匹配 filter_pattern，此时才按其字符集限定解码
     bool debug_save = false;
+    // 识别方式：line 直接按单行识别，detect 先检测再识别，
+    // auto 在区域不高于 line_max_height 且宽高比不超过 line_max_aspect 时按单行识别（结果为空再检测）
+    std::string ocr_mode = "auto";
+    int line_max_height = 60;     // 基准分辨率下的像素
+    double line_max_aspect = 10.0;
 };
 
 // 基础操作：点击、滑动、等待
 struct BasicStep {
-    std::string action;      // click, swipe, wait
+    std::string action;      // click, swipe, wait, wait_stable
     int x = 0;
     int y = 0;
     int x2 = 0;
     int y2 = 0;
     int duration = 0;
+    // wait_stable：画面连续 stable_count 次变化不超过 threshold 即结束，最长 timeout 毫秒
+    int timeout = 10000;
+    int min_wait = 0;        // 开始轮询前的最短等待，避开操作生效前的静止画面
+    int interval = 200;      // 轮询间隔
+    double threshold = 2.0;  // 缩略灰度图逐像素平均差（0~255）
+    int stable_count = 2;
 };
 
 // 视觉操作：截图、OCR、模板匹配
 struct VisionStep {
-    std::string action;      // screenshot, ocr, ocr_click, ocr_region, template
+    std::string action;      // screenshot, ocr, ocr_click, ocr_region, template, wait_for_text, wait_for_template
     std::string image_name;
     std::string text;
     std::string template_path;
     std::optional<ROIConfig> roi;
-    int retry = 1;
-    int timeout = 5000;
+    std::vector<ROIConfig> capture_rois; // screenshot：后续只做区域 OCR 时只截取这些区域所在的行（加载时推导）
+    int retry = 1;           // ocr_click / ocr_region / template：最多检查次数，失败时重新截图
+    int timeout = 5000;      // 重试与 wait_for_* 轮询的总时长上限
+    bool click = false;      // wait_for_*：找到后点击
 };
 
 // 系统操作：shell、启动应用
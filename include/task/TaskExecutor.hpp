@@ -7,6 +7,7 @@
 #include <condition_variable>
 #include <atomic>
 #include <thread>
+#include <functional>
 
 class TaskExecutor {
 public:
@@ -16,7 +17,7 @@ public:
     // 启动工作线程
     void start();
 
-    // 停止工作线程
+    // 停止工作线程，中断进行中的步骤（阻塞的 ADB 调用与等待）
     void stop();
 
     // 投递任务（JSON 路径）
@@ -31,12 +32,39 @@ public:
 private:
     void worker_loop();
     bool execute_task(const TaskConfig& task);
+    // 输出本任务期间帧分析缓存的命中率
+    void log_cache_stats(const FrameCacheStats& before) const;
 
     // 静态多态：函数重载执行不同类型步骤
     bool execute(const BasicStep& step);
     bool execute(const VisionStep& step);
     bool execute(const SystemStep& step);
 
+    /**
+     * @brief 轮询视觉检查：check 失败时重新截图再检查，直到成功、超过 step.timeout 或用尽 max_attempts
+     *
+     * 间隔从 100ms 起每次放大 1.5 倍，最长 1s：界面就绪得快时尽早结束，迟迟不变时不频繁截图。
+     * @param max_attempts 最多检查次数，0 表示只受超时限制
+     * @param capture_first 第一次检查前是否截图（否则使用之前 screenshot 步骤的帧）
+     * @param check 检查函数，参数为本次检查应读取的帧名
+     */
+    bool poll(const VisionStep& step, int max_attempts, bool capture_first,
+              const std::function<bool(const std::string& frame)>& check);
+    /**
+     * @brief 重新截图，frame 返回截图写入的帧名
+     *
+     * 无 roi 时整帧截取到 step.image_name；有 roi 时只截取其所在的行，写入本步骤私有的帧名
+     * （roi_frame_name），不覆盖其他步骤共用的 step.image_name。
+     */
+    bool recapture(const VisionStep& step, std::string& frame);
+    // roi 步骤局部重截图使用的私有帧名
+    static std::string roi_frame_name(const VisionStep& step);
+    // 按 roi.ocr_mode 与区域尺寸选择区域 OCR 的识别方式
+    static RegionOcrMode region_mode(const ROIConfig& roi);
+    // 识别 frame 中的 step.roi 区域；设置了 filter_pattern 时结果取第一个匹配（filter_full_match 时须整行匹配，
+    // 并按其字符集限定解码），无匹配视为失败
+    bool read_roi(const VisionStep& step, const std::string& frame, std::string& text);
+
     SimpleController& controller_;
 
     // 任务队列（存放 JSON 路径）
@@ -47,4 +75,5 @@ private:
     // 工作线程
     std::thread worker_thread_;
     std::atomic<bool> running_{false};
+    uint64_t step_generation_ = 0; // 当前步骤开始前取得的取消代数，步骤内的等待据此响应 stop()
 };
@@ -48,7 +48,7 @@ private:
                 std::string action = s["action"].asString();
 
                 // 基础操作
-                if (action == "click" || action == "swipe" || action == "wait") {
+                if (action == "click" || action == "swipe" || action == "wait" || action == "wait_stable") {
                     BasicStep step;
                     step.action = action;
                     step.x = s["x"].asInt();
@@ -56,18 +56,29 @@ private:
                     step.x2 = s["x2"].asInt();
                     step.y2 = s["y2"].asInt();
                     step.duration = s["duration"].asInt();
+                    step.timeout = s.get("timeout", 10000).asInt();
+                    step.min_wait = s.get("min_wait", 0).asInt();
+                    step.interval = s.get("interval", 200).asInt();
+                    step.threshold = s.get("threshold", 2.0).asDouble();
+                    step.stable_count = s.get("stable_count", 2).asInt();
                     config.steps.push_back(step);
                 }
                 // 视觉操作
                 else if (action == "screenshot" || action == "ocr" || action == "ocr_click" ||
-                         action == "ocr_region" || action == "template") {
+                         action == "ocr_region" || action == "template" ||
+                         action == "wait_for_text" || action == "wait_for_template") {
                     VisionStep step;
                     step.action = action;
                     step.image_name = s["save_name"].asString();
+                    // wait_for_* 自行截图，save_name 可省略
+                    if (step.image_name.empty() && action.starts_with("wait_for_")) {
+                        step.image_name = action + ".png";
+                    }
                     step.text = s["text"].asString();
                     step.template_path = s["template_path"].asString();
                     step.retry = s.get("retry", 1).asInt();
                     step.timeout = s.get("timeout", 5000).asInt();
+                    step.click = s.get("click", false).asBool();
 
                     if (s.isMember("roi")) {
                         ROIConfig roi;
@@ -80,7 +91,23 @@ private:
                         roi.base_height = r.get("base_height", 720).asInt();
                         roi.preprocess = r.get("preprocess", "auto").asString();
                         roi.filter_pattern = r.get("filter_pattern", "").asString();
+                        if (!roi.filter_pattern.empty()) {
+                            try {
+                                roi.filter_regex = std::make_shared<const std::regex>(roi.filter_pattern);
+                            } catch (const std::regex_error& e) {
+                                std::cerr << "filter_pattern 无效: " << roi.filter_pattern << " (" << e.what() << ")，已忽略" << std::endl;
+                                roi.filter_pattern.clear();
+                            }
+                        }
+                        roi.filter_full_match = r.get("filter_full_match", false).asBool();
                         roi.debug_save = r.get("debug_save", false).asBool();
+                        roi.ocr_mode = r.get("ocr_mode", "auto").asString();
+                        if (roi.ocr_mode != "auto" && roi.ocr_mode != "line" && roi.ocr_mode != "detect") {
+                            std::cerr << "未知的 ocr_mode: " << roi.ocr_mode << "（可选 auto / line / detect），按 auto 处理" << std::endl;
+                            roi.ocr_mode = "auto";
+                        }
+                        roi.line_max_height = r.get("line_max_height", 60).asInt();
+                        roi.line_max_aspect = r.get("line_max_aspect", 10.0).asDouble();
                         step.roi = roi;
                     }
                     config.steps.push_back(step);
@@ -98,6 +125,31 @@ private:
                 }
             }
         }
+        mark_partial_captures(config);
         return config;
     }
+
+    // 若某次截图之后引用它的步骤全部是带 roi 的 ocr_region，则该截图只需传输这些区域所在的行
+    static void mark_partial_captures(TaskConfig& config) {
+        for (size_t i = 0; i < config.steps.size(); ++i) {
+            auto* shot = std::get_if<VisionStep>(&config.steps[i]);
+            if (!shot || shot->action != "screenshot") continue;
+
+            std::vector<ROIConfig> rois;
+            bool roi_only = true;
+            for (size_t j = i + 1; j < config.steps.size() && roi_only; ++j) {
+                const auto* next = std::get_if<VisionStep>(&config.steps[j]);
+                if (!next || next->image_name != shot->image_name) continue;
+                if (next->action == "screenshot") break;
+                if (next->action == "ocr_region" && next->roi.has_value()) {
+                    rois.push_back(next->roi.value());
+                } else {
+                    roi_only = false;
+                }
+            }
+            if (roi_only && !rois.empty()) {
+                shot->capture_rois = std::move(rois);
+            }
+        }
+    }
 };
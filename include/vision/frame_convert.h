@@ -0,0 +1,57 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include "adb/AdbFrame.hpp"
+
+/**
+ * @brief 将 ADB 原始帧转换为 BGR 图像
+ *
+ * 以零拷贝方式把像素缓冲区包装为 cv::Mat，只做一次颜色空间转换；
+ * out 尺寸不变时复用其内存。局部截图帧只转换 valid_rows 覆盖的行，其余行置零。
+ * @param frame 原始帧
+ * @param out 输出 BGR 图像
+ * @return 像素格式不支持时返回 false
+ */
+inline bool rawFrameToBgr(const AdbRawFrame& frame, cv::Mat& out) {
+    int rows = static_cast<int>(frame.height);
+    int cols = static_cast<int>(frame.width);
+    auto* data = const_cast<uint8_t*>(frame.pixels.data());
+    cv::Mat src;
+    int code = 0;
+    switch (frame.format) {
+        case AdbPixelFormat::RGBA_8888:
+        case AdbPixelFormat::RGBX_8888:
+            src = cv::Mat(rows, cols, CV_8UC4, data);
+            code = cv::COLOR_RGBA2BGR;
+            break;
+        case AdbPixelFormat::BGRA_8888:
+            src = cv::Mat(rows, cols, CV_8UC4, data);
+            code = cv::COLOR_BGRA2BGR;
+            break;
+        case AdbPixelFormat::RGB_888:
+            src = cv::Mat(rows, cols, CV_8UC3, data);
+            code = cv::COLOR_RGB2BGR;
+            break;
+        case AdbPixelFormat::RGB_565:
+            src = cv::Mat(rows, cols, CV_8UC2, data);
+            code = cv::COLOR_BGR5652BGR;
+            break;
+        default:
+            return false;
+    }
+
+    if (frame.valid_rows.empty()) {
+        cv::cvtColor(src, out, code);
+        return true;
+    }
+    out.create(rows, cols, CV_8UC3);
+    int next = 0; // 复用的 out 中区间外的行是上一帧的内容，逐段清零
+    for (const auto& r : frame.valid_rows) {
+        cv::Range range(static_cast<int>(r.first), static_cast<int>(r.first + r.count));
+        if (range.start > next) out.rowRange(next, range.start).setTo(cv::Scalar(0));
+        cv::Mat dst = out.rowRange(range);
+        cv::cvtColor(src.rowRange(range), dst, code);
+        next = std::max(next, range.end);
+    }
+    if (next < rows) out.rowRange(next, rows).setTo(cv::Scalar(0));
+    return true;
+}
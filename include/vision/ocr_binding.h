@@ -0,0 +1,69 @@
+#pragma once
+#include <onnxruntime_cxx_api.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 单输入单输出模型的 IoBinding 推理
+ *
+ * 输入、输出张量经 Ort::IoBinding 绑定到持久缓冲区，形状不变时重复使用，
+ * 稳定运行后推理不再分配内存。某个输入形状第一次推理时由 ONNX Runtime 分配输出以得知其形状，
+ * 之后改为绑定自有的输出缓冲区。
+ */
+class BoundInference {
+public:
+    /**
+     * @param session 推理会话（须比本对象存活更久）
+     * @param input_name 输入节点名称
+     * @param output_name 输出节点名称
+     */
+    BoundInference(Ort::Session& session, const char* input_name, const char* output_name);
+
+    /**
+     * @brief 取得 NCHW 形状的输入缓冲区，形状变化时才重新绑定
+     * @return 可写入 N*C*H*W 个 float 的缓冲区，有效期到下一次形状变化
+     */
+    float* input(const std::array<int64_t, 4>& shape);
+
+    /**
+     * @brief 以当前输入推理
+     * @return 输出数据，有效期到下一次 input() 或 run()
+     */
+    const float* run();
+
+    /**
+     * @brief 最近一次推理的输出形状
+     */
+    const std::vector<int64_t>& output_shape() const { return output_shape_; }
+
+    /**
+     * @brief 输入、输出缓冲区因容量不足而重新分配的次数
+     */
+    uint64_t reallocations() const { return reallocations_; }
+
+    /**
+     * @brief 开关 IoBinding；关闭时每次推理由 Session::Run 分配输出（用于基准对比）
+     */
+    void set_enabled(bool enabled) { enabled_ = enabled; }
+
+private:
+    Ort::Session& session_;
+    const char* input_name_;
+    const char* output_name_;
+    Ort::MemoryInfo memory_info_;
+    Ort::IoBinding binding_;
+    Ort::RunOptions run_options_;
+    bool enabled_ = true;
+
+    std::array<int64_t, 4> input_shape_{};
+    std::vector<float> input_buffer_;
+    Ort::Value input_value_{nullptr};
+
+    std::vector<int64_t> output_shape_;
+    std::vector<float> output_buffer_;
+    Ort::Value output_value_{nullptr};
+    bool output_bound_ = false;              ///< 当前输入形状的输出是否已绑定到 output_buffer_
+    std::vector<Ort::Value> unbound_outputs_; ///< 关闭 IoBinding 时保留 Run 的输出
+    uint64_t reallocations_ = 0;
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 推导正则表达式的匹配结果可能包含的字符，换算为识别字典中的下标
+ *
+ * 逐个取出表达式中的字符原子（普通字符、转义字符、\d / \w / \s、[...] 字符类），
+ * 忽略量词、分组、分支与锚点，字典中能被任一原子匹配的字符即为允许字符。
+ * 结果是实际可能出现字符的超集，用于在 CTC 解码时只对这些类别求 argmax。
+ *
+ * @param pattern ECMAScript 正则表达式（如 "[0-9]+"、"\\d+/\\d+"）
+ * @param dictionary 识别字典，下标 0 为 CTC 空白
+ * @return 升序排列的允许下标（含空白 0）；表达式含 .、否定字符类、非 ASCII 字符类、
+ *         反向引用等无法推导的成分或无法编译时返回空，表示不限制字符集
+ */
+std::optional<std::vector<int>> regexCharsetIndices(const std::string& pattern,
+                                                    const std::vector<std::string>& dictionary);
+
+/**
+ * @brief CTC 贪心解码单个样本的 [seq_len, num_classes] 输出
+ *
+ * allowed 非空时每帧只在其中求 argmax：字符集外的字形会被改判为允许字符中得分最高者，
+ * 例如 "82/135" 按 [0-9] 解码时 '/' 也会变成数字。因此只适用于整行都应由这些字符组成的场景。
+ *
+ * @param dictionary 识别字典，下标 0 为 CTC 空白
+ * @param allowed 允许的字典下标（含空白 0），nullptr 表示不限制
+ */
+std::string ctcGreedyDecode(const float* output, int seq_len, int num_classes,
+                            const std::vector<std::string>& dictionary, const std::vector<int>* allowed = nullptr);
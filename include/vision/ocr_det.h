@@ -1,7 +1,10 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
+#include <memory>
 #include <vector>
+#include "ocr_binding.h"
+#include "ocr_session_config.h"
 
 struct TextBox {
     std::vector<cv::Point2f> box; ///< 文本框的四个顶点坐标
@@ -23,8 +26,9 @@ public:
      * @brief 构造函数，加载ONNX文本检测模型
      * @param env ONNX Runtime环境
      * @param model_path 检测模型文件路径
+     * @param config 会话参数（线程数、图优化级别等）
      */
-    TextDetector(Ort::Env& env, const std::string& model_path);
+    TextDetector(Ort::Env& env, const std::string& model_path, const OrtSessionConfig& config = {});
 
     /**
      * @brief 检测输入图像中的文本区域
@@ -33,6 +37,11 @@ public:
      */
     std::vector<TextBox> detect(const cv::Mat& img);
 
+    /**
+     * @brief 推理绑定（输入输出缓冲区、IoBinding 开关与重新分配计数）
+     */
+    BoundInference& binding() { return *binding_; }
+
 private:
     Ort::Session session_; ///< ONNX推理句柄
     Ort::AllocatorWithDefaultOptions allocator_; ///< ONNX内存分配器
@@ -40,15 +49,17 @@ private:
     std::vector<std::string> output_name_strings_; ///< 输出节点名称字符串
     std::vector<const char*> input_names_; ///< 输入节点名称指针
     std::vector<const char*> output_names_; ///< 输出节点名称指针
+    std::unique_ptr<BoundInference> binding_; ///< 持久输入输出缓冲区
+    cv::Mat resized_;    ///< 预处理缓冲：缩放后的图像
 
     /**
-     * @brief 图像预处理，调整尺寸并归一化
+     * @brief 图像预处理，调整尺寸（归一化在写入输入缓冲区时由 normalizeToPlanar 完成）
      * @param img 输入图像
      * @param ratio_h 输出：高度缩放比例
      * @param ratio_w 输出：宽度缩放比例
-     * @return 预处理后的图像
+     * @return 缩放后的图像（成员缓冲区，下一次调用前有效）
      */
-    cv::Mat preprocess(const cv::Mat& img, float& ratio_h, float& ratio_w);
+    const cv::Mat& preprocess(const cv::Mat& img, float& ratio_h, float& ratio_w);
 
     /**
      * @brief 后处理推理结果，生成文本框
@@ -0,0 +1,46 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <array>
+
+/**
+ * @brief 归一化内核使用的指令集
+ */
+enum class NormalizeIsa {
+    Scalar, ///< 标量实现
+    SSE41,  ///< SSSE3 解交织 + SSE4.1 转换
+    AVX2,   ///< AVX2 + FMA
+};
+
+/**
+ * @brief 将 uint8 图像一次遍历归一化为平面 float（CHW），直接写入推理输入缓冲区
+ *
+ * 对每个像素计算 dst[c][y][x] = (src(y, x)[c] / 255 - mean[c]) / std[c]，
+ * 取代 convertTo、subtract、divide、split 多趟遍历整幅图像。
+ * 单通道图像写入三个相同的平面（等价于先转为三通道）。
+ * dst_width 大于图像宽度时，右侧补齐像素值 0 对应的归一化值。
+ *
+ * @param src CV_8UC3（按内存中的通道顺序）或 CV_8UC1 图像
+ * @param dst 至少 3 * src.rows * dst_width 个 float
+ * @param dst_width 每个平面的行宽，不小于 src.cols
+ * @param mean 各通道均值（0~1）
+ * @param std 各通道标准差
+ * @throws std::invalid_argument 图像类型不支持或 dst_width 小于图像宽度
+ */
+void normalizeToPlanar(const cv::Mat& src, float* dst, int dst_width,
+                       const std::array<float, 3>& mean, const std::array<float, 3>& std);
+
+/**
+ * @brief 当前使用的指令集（启动时按 CPU 支持情况选择最优）
+ */
+NormalizeIsa normalizeIsa();
+
+/**
+ * @brief 限定使用的指令集，CPU 不支持时退回可用的最优指令集（用于基准对比）
+ * @return 实际生效的指令集
+ */
+NormalizeIsa setNormalizeIsa(NormalizeIsa isa);
+
+/**
+ * @brief 指令集名称
+ */
+const char* normalizeIsaName(NormalizeIsa isa);
@@ -27,24 +27,29 @@ public:
      * @param det_model_path 检测模型路径
      * @param rec_model_path 识别模型路径
      * @param dict_path 字典文件路径
+     * @param runtime 检测、识别模型各自的 ONNX Runtime 会话参数
      */
     OcrPack(const std::string& det_model_path,
             const std::string& rec_model_path,
-            const std::string& dict_path);
+            const std::string& dict_path,
+            const OcrRuntimeConfig& runtime = {});
 
     /**
-     * @brief 对图像进行完整的OCR识别（检测+识别）
+     * @brief 对图像进行完整的OCR识别（检测+批量识别）
      * @param img 输入图像
+     * @param filter_pattern 非空时只在该正则表达式可能包含的字符中解码（字符集外的字形会被改判，只用于整行须匹配的场景）
      * @return 检测到的文本框和对应识别文字
      */
-    std::vector<std::pair<TextBox, std::string>> recognizeAll(const cv::Mat& img);
+    std::vector<std::pair<TextBox, std::string>> recognizeAll(const cv::Mat& img,
+                                                              const std::string& filter_pattern = "");
 
     /**
      * @brief 仅对图像进行文本识别（不检测，适用于已裁剪的ROI）
      * @param img 输入图像（已裁剪的文本区域）
+     * @param filter_pattern 非空时只在该正则表达式可能包含的字符中解码（字符集外的字形会被改判，只用于整行须匹配的场景）
      * @return 识别出的文字
      */
-    std::string recognizeText(const cv::Mat& img);
+    std::string recognizeText(const cv::Mat& img, const std::string& filter_pattern = "");
 
     /**
      * @brief 检测图像中的文本区域
@@ -1,15 +1,54 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include "ocr_binding.h"
+#include "ocr_session_config.h"
 
 class TextRecognizer {
 public:
-    TextRecognizer(Ort::Env& env, const std::string& model_path, const std::string& dict_path);
-    std::string recognize(const cv::Mat& img);
+    /**
+     * @param max_batch 批量识别时单次推理的最大文本框数
+     * @param vocab_path 非空时按该词表裁剪分类层（见 pruneRecognizerHead），裁剪失败时使用完整模型
+     */
+    TextRecognizer(Ort::Env& env, const std::string& model_path, const std::string& dict_path,
+                   const OrtSessionConfig& config = {}, int max_batch = 8, const std::string& vocab_path = "");
+    /**
+     * @param filter_pattern 非空时只在该正则表达式可能包含的字符中解码（见 regexCharsetIndices、ctcGreedyDecode），
+     *        字符集外的字形会被改判为允许字符，只应在整行都须匹配该正则时使用
+     */
+    std::string recognize(const cv::Mat& img, const std::string& filter_pattern = "");
+
+    /**
+     * @brief 批量识别多个文本区域
+     *
+     * 按缩放后的宽度分桶（宽度向上取整到 kWidthStep 的倍数），同一桶的文本框补齐到相同宽度后
+     * 拼成一个 NCHW 张量，每 max_batch 个推理一次；不足 max_batch 个时以空白样本补满，
+     * 使每个桶宽只有单个与满批两种输入形状。模型输入宽度或批大小为静态时退化为固定宽度 / 逐个推理。
+     * @param filter_pattern 同 recognize()
+     * @return 与 imgs 顺序一致的识别结果
+     */
+    std::vector<std::string> recognizeBatch(const std::vector<cv::Mat>& imgs,
+                                            const std::string& filter_pattern = "");
+
+    // 开关 IoBinding（见 BoundInference::set_enabled），作用于所有输入形状
+    void setBindingEnabled(bool enabled);
+    // 各输入形状推理绑定的缓冲区重新分配次数之和
+    uint64_t reallocations() const;
+    // 已创建的推理绑定数，即出现过的输入形状数
+    size_t bindingCount() const { return bindings_.size(); }
 
 private:
+    static constexpr int kHeight = 48;     ///< 输入高度
+    static constexpr int kMaxWidth = 320;  ///< 输入最大宽度，更宽的文本压缩到该宽度
+    static constexpr int kWidthStep = 80;  ///< 分桶宽度步长
+    static constexpr float kPadValue = -1.0f; ///< 像素值 0 归一化后的值，用于补齐宽度与空白样本
+
     Ort::Session session_;
     Ort::AllocatorWithDefaultOptions allocator_;
     std::vector<std::string> input_name_strings_;
@@ -17,7 +56,25 @@ private:
     std::vector<const char*> input_names_;
     std::vector<const char*> output_names_;
     std::vector<std::string> characters_;
+    std::unordered_map<std::string, std::optional<std::vector<int>>> charsets_; ///< filter_pattern -> 允许的字典下标
+    int max_batch_;
+    bool dynamic_width_ = true; ///< 模型输入宽度是否为动态维度
+    bool binding_enabled_ = true;
+    /// 每种输入形状（批大小, 宽度）一个推理绑定，形状各自固定，稳定运行后不再重新绑定与分配
+    std::map<std::pair<int64_t, int>, std::unique_ptr<BoundInference>> bindings_;
+    cv::Ptr<cv::CLAHE> clahe_;
+    // 预处理各阶段的缓冲区，尺寸不变时复用
+    cv::Mat enlarged_, gray_, enhanced_, resized_;
 
     void loadDict(const std::string& dict_path);
-    cv::Mat preprocess(const cv::Mat& img);
+    // 取得该输入形状的推理绑定，首次使用时创建
+    BoundInference& binding(int64_t batch, int width);
+    // 文本框缩放到 kHeight 高后所在桶的输入宽度
+    int bucketWidth(const cv::Mat& img) const;
+    // 增强对比度并缩放，归一化后写入 dst 的三个 kHeight x width 平面（右侧补齐）
+    void preprocess(const cv::Mat& img, int width, float* dst);
+    // filter_pattern 对应的允许下标，首次使用时推导；无法限制字符集时返回 nullptr
+    const std::vector<int>* allowedClasses(const std::string& filter_pattern);
+    // CTC 贪心解码单个样本的 [seq_len, num_classes] 输出，allowed 非空时只在其中求 argmax
+    std::string decode(const float* output, int seq_len, int num_classes, const std::vector<int>* allowed) const;
 };
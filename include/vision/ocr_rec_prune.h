@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * @brief 按词表裁剪后的识别模型
+ */
+struct PrunedRecModel {
+    std::string model_path;              ///< 裁剪后模型的缓存路径
+    std::vector<std::string> characters; ///< 重映射后的字典，下标 0 为 CTC 空白
+    bool from_cache = false;             ///< 是否直接使用了已有的缓存
+};
+
+/**
+ * @brief 按词表裁剪识别模型的分类层（最后的 MatMul + Add 或 Gemm），只保留词表中出现的字符与空白
+ *
+ * 在内存中改写 ONNX 图：分类权重与偏置（initializer 或 Constant 节点）按保留的类别切片，
+ * 丢弃 value_info 中的中间形状，修正输出的类别维。结果缓存为模型同目录下的
+ * <模型名>.pruned-<散列>.onnx，散列包含原模型大小、修改时间与保留类别，词表或模型变化时重新生成。
+ * 缓存须能完整解析且输出类别数与保留类别一致才会使用，否则重新生成；同一模型的其他裁剪缓存与
+ * 遗留的临时文件随之删除（同一目录下的多个实例应使用相同词表，否则会相互覆盖）。
+ *
+ * @param model_path 完整识别模型
+ * @param characters 完整字典（下标 0 为空白，与模型类别一一对应）
+ * @param vocab_path 词表文件，每行的每个 UTF-8 字符都会保留（可直接使用界面文本）
+ * @throws std::runtime_error 字典为空、文件无法读写、模型格式不支持或找不到分类层
+ */
+PrunedRecModel pruneRecognizerHead(const std::string& model_path,
+                                   const std::vector<std::string>& characters,
+                                   const std::string& vocab_path);
+
+/**
+ * @brief 改写 ONNX 模型：把类别数不少于 min_classes 的分类层切片为 keep 中的类别
+ * @param model ModelProto 序列化数据
+ * @param keep 保留的类别下标（按新类别顺序）
+ * @return 改写后的 ModelProto 序列化数据
+ * @throws std::runtime_error 模型格式不支持或找不到分类层
+ */
+std::string pruneClassifierHead(const std::string& model, size_t min_classes, const std::vector<int>& keep);
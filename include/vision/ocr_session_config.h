@@ -0,0 +1,45 @@
+#pragma once
+#include <onnxruntime_cxx_api.h>
+#include <optional>
+#include <string>
+
+/**
+ * @brief 单个模型的 ONNX Runtime 会话参数
+ *
+ * 未设置的项保持 ONNX Runtime 默认值。同一主机运行多个实例时，
+ * 可通过线程数与关闭线程自旋把每个实例限制在各自的核心预算内。
+ */
+struct OrtSessionConfig {
+    std::optional<int> intra_op_threads;        ///< 算子内并行线程数
+    std::optional<int> inter_op_threads;        ///< 算子间并行线程数（仅并行执行模式生效）
+    std::optional<std::string> graph_optimization; ///< 图优化级别：disable / basic / extended / all
+    std::optional<bool> parallel_execution;     ///< true 为 ORT_PARALLEL，false 为 ORT_SEQUENTIAL
+    std::optional<bool> mem_pattern;            ///< 按首次推理的内存分配模式预分配
+    std::optional<bool> cpu_arena;              ///< CPU 内存池
+    std::optional<bool> allow_spinning;         ///< 线程池空闲时自旋等待（关闭可降低空闲 CPU 占用）
+
+    /**
+     * @brief 生成 Ort::SessionOptions（无法识别的图优化级别按未设置处理）
+     */
+    Ort::SessionOptions build() const;
+};
+
+/**
+ * @brief OCR 各模型的会话参数，从 JSON 配置文件加载
+ *
+ * 顶层字段对所有模型生效，"det" / "rec" 对象中的同名字段覆盖单个模型：
+ * @code
+ * { "intra_op_threads": 2, "allow_spinning": false, "rec": { "intra_op_threads": 1, "batch_size": 8 } }
+ * @endcode
+ */
+struct OcrRuntimeConfig {
+    OrtSessionConfig det; ///< 文本检测模型
+    OrtSessionConfig rec; ///< 文本识别模型
+    int rec_batch_size = 8; ///< 批量识别时单次推理的最大文本框数（"rec" 对象中的 batch_size）
+    std::string rec_vocabulary; ///< 识别分类层裁剪词表（"rec" 对象中的 vocabulary，相对路径相对于配置文件所在目录）
+
+    /**
+     * @brief 从文件加载，文件不存在或解析失败时输出错误并返回默认配置
+     */
+    static OcrRuntimeConfig load(const std::string& path);
+};
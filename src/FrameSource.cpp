@@ -0,0 +1,231 @@
+#include "FrameSource.hpp"
+#include "vision/frame_convert.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+AdbFrameSource::AdbFrameSource(ADBClient& client, std::string device_id, std::optional<AdbCaptureMode> mode)
+    : client_(client), device_id_(std::move(device_id)), mode_(mode),
+      cancel_(std::make_shared<AdbCancelToken>()) {}
+
+AdbCaptureMode AdbFrameSource::mode() const {
+    return mode_ ? *mode_ : client_.capture_mode(device_id_);
+}
+
+bool AdbFrameSource::grab(cv::Mat& out) {
+    std::shared_ptr<AdbCancelToken> token;
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex_);
+        token = cancel_;
+    }
+    AdbCallScope scope({.cancel = token});
+    AdbCaptureMode mode = this->mode();
+    if (mode == AdbCaptureMode::PNG) {
+        if (!client_.capture_png(device_id_, png_buffer_)) return false;
+        cv::Mat encoded(1, static_cast<int>(png_buffer_.size()), CV_8UC1, png_buffer_.data());
+        cv::imdecode(encoded, cv::IMREAD_COLOR, &out);
+    } else if (!client_.capture_raw(device_id_, raw_frame_, mode) || !rawFrameToBgr(raw_frame_, out)) {
+        return false;
+    }
+    return !out.empty();
+}
+
+void AdbFrameSource::interrupt() {
+    std::shared_ptr<AdbCancelToken> token;
+    {
+        // 换新令牌：被中断的只有进行中的 grab
+        std::lock_guard<std::mutex> lock(cancel_mutex_);
+        token = std::exchange(cancel_, std::make_shared<AdbCancelToken>());
+    }
+    token->cancel();
+}
+
+std::string AdbFrameSource::name() const {
+    switch (mode()) {
+        case AdbCaptureMode::PNG: return "adb-png";
+        case AdbCaptureMode::RAW: return "adb-raw";
+        case AdbCaptureMode::FRAMEBUFFER: return "adb-framebuffer";
+        case AdbCaptureMode::GZIP_RAW: return "adb-gzip-raw";
+    }
+    return "adb";
+}
+
+ReplayFrameSource::ReplayFrameSource(const std::string& directory, bool loop)
+    : directory_(directory), loop_(loop) {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (!entry.is_regular_file()) continue;
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    // 预先解码，回放时只有一次内存复制
+    for (const auto& file : files) {
+        cv::Mat img = cv::imread(file.string(), cv::IMREAD_COLOR);
+        if (!img.empty()) {
+            images_.push_back(std::move(img));
+        }
+    }
+    if (images_.empty()) {
+        std::cerr << std::format("回放目录 {} 中没有可用的图像", directory) << std::endl;
+    }
+}
+
+bool ReplayFrameSource::grab(cv::Mat& out) {
+    if (images_.empty()) return false;
+    size_t index = next_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= images_.size()) {
+        if (!loop_) return false;
+        index %= images_.size();
+    }
+    images_[index].copyTo(out);
+    return true;
+}
+
+std::string ReplayFrameSource::name() const {
+    return "replay:" + directory_;
+}
+
+FrameRing::FrameRing(std::unique_ptr<FrameSource> source, size_t capacity, std::chrono::milliseconds interval)
+    : source_(std::move(source)), interval_(interval) {
+    capacity = std::max<size_t>(capacity, 2);
+    slots_.reserve(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        slots_.push_back(std::make_shared<Frame>());
+    }
+}
+
+FrameRing::~FrameRing() {
+    stop();
+}
+
+void FrameRing::start() {
+    if (!source_ || running_.exchange(true, std::memory_order_acq_rel)) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latest_.reset();
+    }
+    worker_ = std::thread(&FrameRing::run, this);
+}
+
+void FrameRing::stop() {
+    if (!running_.exchange(false, std::memory_order_acq_rel)) return;
+    source_->interrupt();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_generation_++;
+    }
+    frame_cv_.notify_all();
+    slot_cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+std::unique_ptr<FrameSource> FrameRing::take_source() {
+    stop();
+    return std::move(source_);
+}
+
+std::shared_ptr<const Frame> FrameRing::latest() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return latest_;
+}
+
+template <typename Pred>
+std::shared_ptr<const Frame> FrameRing::wait_for(Pred&& ready, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t generation = wake_generation_;
+    bool ok = frame_cv_.wait_for(lock, timeout, [&] {
+        return (latest_ && ready(*latest_)) || wake_generation_ != generation;
+    });
+    if (!ok || wake_generation_ != generation) return nullptr;
+    return latest_;
+}
+
+std::shared_ptr<const Frame> FrameRing::wait_since(clock::time_point since, std::chrono::milliseconds timeout) {
+    return wait_for([since](const Frame& frame) { return frame.started >= since; }, timeout);
+}
+
+std::shared_ptr<const Frame> FrameRing::wait_after(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return wait_for([sequence](const Frame& frame) { return frame.sequence > sequence; }, timeout);
+}
+
+void FrameRing::cancel_waits() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_generation_++;
+    }
+    frame_cv_.notify_all();
+}
+
+FrameRingStats FrameRing::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::shared_ptr<Frame> FrameRing::free_slot() {
+    // 只有环自身持有（use_count 为 1）的缓冲区可以覆盖；latest_ 也算一份引用
+    for (auto& slot : slots_) {
+        if (slot.use_count() == 1) return slot;
+    }
+    return nullptr;
+}
+
+void FrameRing::run() {
+    // grab 失败后的重试间隔，避免设备断开时空转
+    constexpr auto retry_delay = std::chrono::milliseconds(200);
+    // 读取方占满缓冲区时的轮询间隔（释放 shared_ptr 无法通知）
+    constexpr auto slot_poll = std::chrono::milliseconds(5);
+
+    while (running()) {
+        std::shared_ptr<Frame> slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            slot = free_slot();
+            if (!slot) {
+                stats_.stalls++;
+                while (running() && !(slot = free_slot())) {
+                    slot_cv_.wait_for(lock, slot_poll);
+                }
+                if (!slot) break;
+            }
+        }
+
+        auto started = clock::now();
+        // 写入期间 slot 的 use_count 为 2，读取方拿不到它，其他线程也不会选中它
+        bool ok = source_->grab(slot->image);
+        auto finished = clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (ok && !slot->image.empty()) {
+                slot->sequence = ++sequence_;
+                slot->started = started;
+                slot->timestamp = finished;
+                latest_ = slot;
+                stats_.frames++;
+                stats_.capture_seconds += std::chrono::duration<double>(finished - started).count();
+            } else {
+                stats_.failures++;
+            }
+        }
+        slot.reset();
+        if (ok) {
+            frame_cv_.notify_all();
+        }
+
+        auto next = ok ? started + interval_ : finished + retry_delay;
+        if (next > clock::now()) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            slot_cv_.wait_until(lock, next, [this] { return !running(); });
+        }
+    }
+}
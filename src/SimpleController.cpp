@@ -1,18 +1,33 @@
 #include "SimpleController.hpp"
 #include "Config.hpp"
+#include "vision/frame_convert.h"
+#include <algorithm>
 #include <thread>
 #include <chrono>
+#include <filesystem>
 #include <format>
 #include <opencv2/opencv.hpp>
 
-SimpleController::SimpleController() {
+SimpleController::SimpleController(const std::string& ocr_config_path) {
     // 初始化 OCR 模块
     std::string model_dir = std::string(Config::PROJECT_ROOT_DIR) + "/models/onnx/";
     std::string dict_path = std::string(Config::PROJECT_ROOT_DIR) + "/models/ppocr_keys_v1.txt";
+    std::string runtime_path = ocr_config_path;
+    if (runtime_path.empty()) {
+        std::string default_path = std::string(Config::PROJECT_ROOT_DIR) + "/resource/ocr_runtime.json";
+        if (std::filesystem::exists(default_path)) {
+            runtime_path = default_path;
+        }
+    }
+    OcrRuntimeConfig runtime;
+    if (!runtime_path.empty()) {
+        runtime = OcrRuntimeConfig::load(runtime_path);
+    }
     vision_api_ = std::make_unique<OcrPack>(
         model_dir + "ch_ppocr_det.onnx",
         model_dir + "ch_ppocr_rec.onnx",
-        dict_path
+        dict_path,
+        runtime
     );
 }
 
@@ -23,60 +38,370 @@ bool SimpleController::connect(const std::string& adb_path, const std::string& a
     device_address_ = address;
     config_path_ = config_path;
     work_dir_ = adb_path;  // ADB 工作目录
-    adb_client_ = std::make_unique<ADBClient>(adb_path);
+    touch_.reset();
+    touch_init_tried_ = false;
+    {
+        // 后台截图与帧源引用旧的 ADBClient，先于它销毁
+        std::lock_guard<std::mutex> lock(ring_mutex_);
+        frame_ring_.reset();
+        adb_source_.reset();
+        adb_client_ = std::make_unique<ADBClient>(adb_path);
+    }
+    adb_client_->set_capture_mode(device_address_, capture_mode_);
+    adb_source_ = std::make_unique<AdbFrameSource>(*adb_client_, device_address_);
 
     return adb_client_->connect(address.substr(0, address.find(':')), address.substr(address.find(':')+1));
 }
 
 bool SimpleController::capture_screenshot(const std::string& filename) {
+    if (!adb_client_ && !frame_ring_) return false;
+    invalidate_analysis(filename);
+    // 复用同名帧的内存，尺寸不变时不重新分配
+    cv::Mat& frame = frames_[filename];
+    if (!capture_frame(frame)) {
+        frames_.erase(filename);
+        return false;
+    }
+    if (debug_save_) {
+        cv::imwrite(work_dir_ + "/" + filename, frame);
+    }
+    return true;
+}
+
+bool SimpleController::capture_partial(const std::string& filename, const std::vector<cv::Rect2f>& regions) {
     if (!adb_client_) return false;
-    return adb_client_->capture_screenshot(device_address_, filename);
+    invalidate_analysis(filename);
+    // 行号按上次原始截图得到的屏幕高度换算；还没有时取第 0 行，
+    // capture_rows 因缺少几何信息会整帧截图，下次即可局部截取
+    int screen_h = static_cast<int>(raw_frame_.height);
+    if (screen_h == 0 && adb_source_) {
+        screen_h = static_cast<int>(adb_source_->raw().height);
+    }
+    std::vector<AdbRowRange> rows;
+    if (screen_h == 0) {
+        rows.push_back({0, 1});
+    }
+    for (const auto& region : regions) {
+        if (screen_h == 0) break;
+        int top = std::max(0, static_cast<int>(region.y * screen_h));
+        int bottom = static_cast<int>(std::ceil((region.y + region.height) * screen_h));
+        if (bottom > top) {
+            rows.push_back({static_cast<uint32_t>(top), static_cast<uint32_t>(bottom - top)});
+        }
+    }
+    if (rows.empty()) {
+        return capture_screenshot(filename);
+    }
+    if (!adb_client_->capture_rows(device_address_, rows, raw_frame_)) {
+        frames_.erase(filename);
+        return false;
+    }
+    cv::Mat& frame = frames_[filename];
+    if (!rawFrameToBgr(raw_frame_, frame)) {
+        frames_.erase(filename);
+        return false;
+    }
+    if (touch_) {
+        touch_->update_display_size(frame.cols, frame.rows);
+    }
+    if (debug_save_) {
+        cv::imwrite(work_dir_ + "/" + filename, frame);
+    }
+    return true;
+}
+
+bool SimpleController::capture_frame(cv::Mat& out) {
+    if (frame_ring_ && frame_ring_->running()) {
+        if (!take_stream_frame(out)) return false;
+    } else if (!adb_source_ || !adb_source_->grab(out)) {
+        return false;
+    }
+    // 屏幕方向可能随界面变化，触摸注入据此换算坐标
+    if (touch_) {
+        touch_->update_display_size(out.cols, out.rows);
+    }
+    return true;
+}
+
+bool SimpleController::take_stream_frame(cv::Mat& out) {
+    std::chrono::steady_clock::time_point since;
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        since = last_input_;
+    }
+    // 与同步截图的默认超时一致
+    auto frame = frame_ring_->wait_since(since, std::chrono::seconds(10));
+    if (!frame) return false;
+    frame->image.copyTo(out);
+    return !out.empty();
+}
+
+void SimpleController::mark_input() {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    last_input_ = std::chrono::steady_clock::now();
+}
+
+void SimpleController::set_frame_source(std::unique_ptr<FrameSource> source) {
+    bool restart = frame_ring_ && frame_ring_->running();
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex_);
+        frame_ring_.reset();
+    }
+    stream_source_ = std::move(source);
+    if (restart) {
+        start_capture_stream(ring_size_, ring_interval_);
+    }
+}
+
+bool SimpleController::start_capture_stream(size_t ring_size, std::chrono::milliseconds interval) {
+    bool same = ring_size == ring_size_ && interval == ring_interval_;
+    std::unique_ptr<FrameSource> source = std::move(stream_source_);
+    if (frame_ring_) {
+        if (!source && same) {
+            frame_ring_->start();
+            return true;
+        }
+        // 参数变化时沿用原帧源重建
+        std::unique_ptr<FrameSource> previous = frame_ring_->take_source();
+        std::lock_guard<std::mutex> lock(ring_mutex_);
+        frame_ring_.reset();
+        if (!source) source = std::move(previous);
+    }
+    if (!source) {
+        if (!adb_client_) return false;
+        // 与同步截图分开的实例：各自的缓冲区只在各自的线程上使用
+        source = std::make_unique<AdbFrameSource>(*adb_client_, device_address_);
+    }
+    ring_size_ = ring_size;
+    ring_interval_ = interval;
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex_);
+        frame_ring_ = std::make_unique<FrameRing>(std::move(source), ring_size, interval);
+    }
+    frame_ring_->start();
+    return true;
+}
+
+void SimpleController::stop_capture_stream() {
+    if (frame_ring_) {
+        frame_ring_->stop();
+    }
+}
+
+std::shared_ptr<const Frame> SimpleController::latest_frame() const {
+    if (!frame_ring_ || !frame_ring_->running()) return nullptr;
+    return frame_ring_->latest();
+}
+
+void SimpleController::set_capture_mode(AdbCaptureMode mode) {
+    capture_mode_ = mode;
+    if (adb_client_) {
+        adb_client_->set_capture_mode(device_address_, mode);
+    }
+}
+
+void SimpleController::set_debug_save(bool enable) {
+    debug_save_ = enable;
+}
+
+cv::Mat SimpleController::get_frame(const std::string& image_path) {
+    auto it = frames_.find(image_path);
+    if (it != frames_.end()) {
+        return it->second;
+    }
+    // 兼容手动放入工作目录的图片
+    cv::Mat img = cv::imread(work_dir_ + "/" + image_path);
+    if (!img.empty()) {
+        invalidate_analysis(image_path);
+        frames_[image_path] = img;
+    }
+    return img;
+}
+
+void SimpleController::invalidate_analysis(const std::string& image_path) {
+    analysis_.erase(image_path);
+}
+
+const std::vector<std::pair<TextBox, std::string>>* SimpleController::frame_texts(const std::string& image_path) {
+    if (!vision_api_) return nullptr;
+    cv::Mat img = get_frame(image_path);
+    if (img.empty()) return nullptr;
+    auto& texts = analysis_[image_path].texts;
+    if (texts) {
+        cache_stats_.hits++;
+    } else {
+        cache_stats_.misses++;
+        texts = vision_api_->recognizeAll(img);
+    }
+    return &*texts;
 }
 
 bool SimpleController::click(int x, int y) {
     if (!adb_client_) return false;
-    std::string cmd = std::format("input tap {} {}", x, y);
-    adb_client_->shell(device_address_, cmd);
-    return true;
+    bool ok = touch_ready() ? touch_->tap(x, y)
+                            : adb_client_->shell_run(device_address_, std::format("input tap {} {}", x, y)).ok;
+    mark_input();
+    return ok;
 }
 
 
 std::string SimpleController::build_cmd(const std::string& cmd) {
     if (!adb_client_) return "";
-    return adb_client_->shell(device_address_, cmd);
+    // 与原 shell: 行为一致，标准错误附在输出之后
+    auto result = adb_client_->shell_run(device_address_, cmd);
+    // shell 命令可能改变界面（如 am start）
+    mark_input();
+    return result.out + result.err;
 }
 
 bool SimpleController::swipe(int x1, int y1, int x2, int y2, int duration_ms) {
     if (!adb_client_) return false;
-    std::string cmd = std::format("input swipe {} {} {} {} {}", x1, y1, x2, y2, duration_ms);
-    adb_client_->shell(device_address_, cmd);
-    return true;
+    bool ok = touch_ready()
+        ? touch_->swipe(x1, y1, x2, y2, duration_ms)
+        : adb_client_->shell_run(device_address_, std::format("input swipe {} {} {} {} {}", x1, y1, x2, y2, duration_ms)).ok;
+    mark_input();
+    return ok;
+}
+
+void SimpleController::set_touch_injection(bool enable) {
+    touch_injection_ = enable;
+    if (!enable) {
+        touch_.reset();
+        touch_init_tried_ = false;
+    }
+}
+
+bool SimpleController::touch_ready() {
+    if (!touch_injection_ || !adb_client_) return false;
+    if (!touch_init_tried_) {
+        // 首次触摸时探测一次，设备不支持（无触摸节点或无写权限）时之后一直使用 input 命令
+        touch_init_tried_ = true;
+        touch_ = std::make_unique<AdbTouchInjector>(*adb_client_, device_address_);
+        if (!touch_->init()) {
+            touch_.reset();
+        }
+    }
+    return touch_ != nullptr;
 }
 
 void SimpleController::wait(int ms) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    wait(ms, cancel_generation());
+}
+
+bool SimpleController::wait(int ms, uint64_t generation) {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    return !wait_cv_.wait_for(lock, std::chrono::milliseconds(ms), [&] { return cancel_generation_ != generation; });
+}
+
+uint64_t SimpleController::cancel_generation() {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    return cancel_generation_;
+}
+
+namespace {
+// 缩小到固定宽度的灰度缩略图，比较画面时忽略噪点并与分辨率无关
+void stableThumbnail(const cv::Mat& frame, cv::Mat& small, cv::Mat& gray) {
+    constexpr int width = 64;
+    int height = std::max(1, frame.rows * width / std::max(1, frame.cols));
+    cv::resize(frame, small, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+    cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+}
+}
+
+bool SimpleController::wait_stable(int timeout_ms, int min_wait_ms, int interval_ms, double threshold, int stable_count,
+                                   std::optional<uint64_t> generation) {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(timeout_ms);
+    uint64_t since = generation ? *generation : cancel_generation();
+    auto cancelled = [&] { return cancel_generation() != since; };
+
+    if (min_wait_ms > 0) {
+        wait(std::min(min_wait_ms, timeout_ms), since);
+    }
+    cv::Mat small, previous, current, diff;
+    uint64_t sequence = 0;
+    int stable = 0;
+    while (!cancelled()) {
+        // 到达截止时刻后仍取最后一帧比较一次，之后才判定超时
+        auto now = std::chrono::steady_clock::now();
+        bool last = now >= deadline;
+        auto remaining = last ? std::chrono::milliseconds(0)
+                              : std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now);
+
+        bool ok = false;
+        if (frame_ring_ && frame_ring_->running()) {
+            // 直接在环形缓冲的帧上缩略，不复制整帧
+            if (auto frame = frame_ring_->wait_after(sequence, remaining)) {
+                sequence = frame->sequence;
+                stableThumbnail(frame->image, small, current);
+                ok = true;
+            }
+        } else if (capture_frame(poll_frame_)) {
+            stableThumbnail(poll_frame_, small, current);
+            ok = true;
+        }
+
+        if (ok) {
+            if (!previous.empty() && previous.size() == current.size()) {
+                cv::absdiff(previous, current, diff);
+                stable = cv::mean(diff)[0] <= threshold ? stable + 1 : 0;
+                if (stable >= stable_count) return true;
+            }
+            std::swap(previous, current);
+        }
+        if (last) return false;
+        // 最后一次间隔截短到截止时刻，不提前放弃
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        wait(static_cast<int>(std::clamp<int64_t>(left.count(), 0, interval_ms)), since);
+    }
+    return false;
+}
+
+void SimpleController::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        cancel_generation_++;
+    }
+    wait_cv_.notify_all();
+    // 可能在其他线程调用：与 frame_ring_ / adb_client_ 的替换互斥
+    std::lock_guard<std::mutex> lock(ring_mutex_);
+    if (frame_ring_) {
+        frame_ring_->cancel_waits();
+    }
+    if (adb_client_) {
+        adb_client_->cancel_all();
+    }
 }
 
 bool SimpleController::detect_text(const std::string& image_path, std::string& out_text) {
-    if (!vision_api_) return false;
-    std::string full_path = work_dir_ + "/" + image_path;
-    cv::Mat img = cv::imread(full_path);
-    if (img.empty()) return false;
-    auto results = vision_api_->recognizeAll(img);
+    const auto* results = frame_texts(image_path);
+    if (!results) return false;
     out_text.clear();
-    for (const auto& [box, text] : results) {
+    for (const auto& [box, text] : *results) {
         out_text += text + "\n";
     }
     return !out_text.empty();
 }
 
 bool SimpleController::find_template(const std::string& image_path, const std::string& template_path, int& out_x, int& out_y) {
-    std::string full_image_path = work_dir_ + "/" + image_path;
-    std::string full_template_path = std::string(Config::PROJECT_ROOT_DIR) + "/" + template_path;
-    cv::Mat img = cv::imread(full_image_path);
-    cv::Mat templ = cv::imread(full_template_path);
+    cv::Mat img = get_frame(image_path);
+    cv::Mat& templ = templates_[template_path];
+    if (templ.empty()) {
+        templ = cv::imread(std::string(Config::PROJECT_ROOT_DIR) + "/" + template_path);
+    }
     if (img.empty() || templ.empty()) return false;
 
+    auto& templates = analysis_[image_path].templates;
+    if (auto it = templates.find(template_path); it != templates.end()) {
+        cache_stats_.hits++;
+        if (!it->second) return false;
+        out_x = it->second->x;
+        out_y = it->second->y;
+        return true;
+    }
+    cache_stats_.misses++;
+    std::optional<cv::Point>& hit = templates[template_path];
+
     cv::Mat result;
     cv::matchTemplate(img, templ, result, cv::TM_CCOEFF_NORMED);
 
@@ -87,19 +412,17 @@ bool SimpleController::find_template(const std::string& image_path, const std::s
     if (maxVal > 0.8) {  // 匹配阈值
         out_x = maxLoc.x + templ.cols / 2;
         out_y = maxLoc.y + templ.rows / 2;
+        hit = cv::Point(out_x, out_y);
         return true;
     }
     return false;
 }
 
 bool SimpleController::find_text(const std::string& image_path, const std::string& target_text, int& out_x, int& out_y) {
-    if (!vision_api_) return false;
-    std::string full_path = work_dir_ + "/" + image_path;
-    cv::Mat img = cv::imread(full_path);
-    if (img.empty()) return false;
+    const auto* results = frame_texts(image_path);
+    if (!results) return false;
 
-    auto results = vision_api_->recognizeAll(img);
-    for (const auto& [box, text] : results) {
+    for (const auto& [box, text] : *results) {
         if (text.find(target_text) != std::string::npos) {
             // 计算文本框中心点
             float cx = 0, cy = 0;
@@ -116,10 +439,10 @@ bool SimpleController::find_text(const std::string& image_path, const std::strin
 }
 
 bool SimpleController::ocr_region(const std::string& image_path, int roi_x, int roi_y, int roi_w, int roi_h,
-                                   int base_w, int base_h, std::string& out_text) {
+                                   int base_w, int base_h, std::string& out_text, RegionOcrMode mode,
+                                   const std::string& filter_pattern) {
     if (!vision_api_) return false;
-    std::string full_path = work_dir_ + "/" + image_path;
-    cv::Mat img = cv::imread(full_path);
+    cv::Mat img = get_frame(image_path);
     if (img.empty()) return false;
 
     // 根据实际分辨率缩放 ROI
@@ -137,17 +460,36 @@ bool SimpleController::ocr_region(const std::string& image_path, int roi_x, int
     scaled_w = std::min(scaled_w, img.cols - scaled_x);
     scaled_h = std::min(scaled_h, img.rows - scaled_y);
 
+    // 同一帧同一区域只识别一次
+    auto& regions = analysis_[image_path].regions;
+    std::pair<std::array<int, 5>, std::string> key{
+        {scaled_x, scaled_y, scaled_w, scaled_h, static_cast<int>(mode)}, filter_pattern};
+    if (auto it = regions.find(key); it != regions.end()) {
+        cache_stats_.hits++;
+        out_text = it->second;
+        return !out_text.empty();
+    }
+    cache_stats_.misses++;
+
     cv::Rect roi(scaled_x, scaled_y, scaled_w, scaled_h);
     cv::Mat roi_img = img(roi);
 
-    // 对 ROI 区域进行 OCR
-    auto results = vision_api_->recognizeAll(roi_img);
+    // 单行区域直接识别，跳过文本检测
     out_text.clear();
-    for (const auto& [box, text] : results) {
-        out_text += text;
+    bool line = mode != RegionOcrMode::Detect;
+    if (line) {
+        out_text = vision_api_->recognizeText(roi_img, filter_pattern);
+    }
+    if (mode == RegionOcrMode::Detect || (mode == RegionOcrMode::LineThenDetect && out_text.empty())) {
+        line = false;
+        auto results = vision_api_->recognizeAll(roi_img, filter_pattern);
+        for (const auto& [box, text] : results) {
+            out_text += text;
+        }
     }
+    regions.emplace(key, out_text);
 
-    std::cout << "OCR 区域识别结果: " << out_text << std::endl;
+    std::cout << "OCR 区域识别结果" << (line ? "（单行）" : "") << ": " << out_text << std::endl;
     return !out_text.empty();
 }
 
@@ -3,32 +3,230 @@
 //
 #include "ADBClient.hpp"
 #include "../../include/adb/AdbStatus.hpp"
+#include <chrono>
+#include <filesystem>
 #include <format>
 #include <sstream>
 #include <fstream>
+#include <stdexcept>
+#include <utility>
 
 using boost::asio::ip::tcp;
 
+namespace {
+
+// 各线程上一次调用的失败原因
+thread_local AdbError last_call_error = AdbError::NONE;
+
+} // namespace
+
 ADBClient::ADBClient(std::string_view work_dir)
     : io_context_()
-    , resolver_(io_context_)
+    , pool_(io_context_)
     , work_dir_(work_dir)
+    , cancel_all_(std::make_shared<AdbCancelToken>())
+    , tracker_(std::make_unique<AdbDeviceTracker>())
 {
     // 不再预先解析端点，host/port 由 connect/connect_to_server 提供
 }
 
-ADBClient::~ADBClient() = default;
+ADBClient::~ADBClient() {
+    std::lock_guard<std::mutex> lock(direct_mutex_);
+    for (auto& [device_id, transport] : direct_devices_) {
+        if (transport) transport->close();
+    }
+}
 
 tcp::socket ADBClient::connect_to_server(std::string_view host, std::string_view port) {
-    tcp::socket socket(io_context_);
-    auto endpoints = resolver_.resolve(host, port);
-    boost::asio::connect(socket, endpoints);
+    return pool_.connect(host, port);
+}
+
+tcp::socket ADBClient::open_service(std::string_view device_id, std::string_view service, AdbWatchdog* watchdog,
+                                    std::string_view host, std::string_view port) {
+    // 直连设备：在 adbd 连接上多路复用一个新流，设备拒绝时抛出异常
+    if (auto transport = direct_transport(device_id, watchdog)) {
+        return transport->open(service, watchdog);
+    }
+
+    // 选择设备：优先取连接池中已握手的 socket，未命中时现场握手
+    std::optional<tcp::socket> pooled = pool_.try_acquire(device_id, host, port);
+    tcp::socket socket = pooled ? std::move(*pooled) : connect_to_server(host, port);
+    // ADB Server 或设备无响应时 OKAY 可能迟迟不来，握手前开始监视
+    std::optional<AdbWatchdog::Watch> watch;
+    if (watchdog) {
+        watch.emplace(watchdog->watch(socket));
+    }
+    if (!pooled) {
+        AdbConnectionPool::request_transport(socket, device_id);
+    }
+
+    std::string request = std::format("{:04x}{}", service.length(), service);
+    boost::asio::write(socket, boost::asio::buffer(request));
+
+    char status[4];
+    boost::asio::read(socket, boost::asio::buffer(status, 4));
+    if (std::string_view(status, 4) != "OKAY") {
+        throw std::runtime_error(std::format("打开服务失败: {}", service));
+    }
     return socket;
 }
 
+std::shared_ptr<AdbdTransport> ADBClient::direct_transport(std::string_view device_id, AdbWatchdog* watchdog) {
+    std::string host;
+    std::string port;
+    std::shared_ptr<const AdbRsaKey> key;
+    {
+        std::lock_guard<std::mutex> lock(direct_mutex_);
+        auto it = direct_devices_.find(std::string(device_id));
+        if (it == direct_devices_.end()) {
+            return nullptr;
+        }
+        if (it->second && it->second->alive()) {
+            return it->second;
+        }
+        if (!adb_key_) {
+            adb_key_ = AdbRsaKey::load_or_create(AdbRsaKey::default_path(work_dir_));
+        }
+        key = adb_key_;
+        size_t colon = device_id.rfind(':');
+        host = device_id.substr(0, colon);
+        port = device_id.substr(colon + 1);
+    }
+
+    // 握手（可能等待用户确认）不持锁；并发重连时保留先完成的连接
+    auto transport = AdbdTransport::connect(io_context_, pool_.resolve(host, port), key, watchdog);
+    std::lock_guard<std::mutex> lock(direct_mutex_);
+    auto it = direct_devices_.find(std::string(device_id));
+    if (it == direct_devices_.end()) {
+        // 握手期间已 disconnect_direct
+        transport->close();
+        throw std::runtime_error(std::format("直连设备已断开: {}", device_id));
+    }
+    if (it->second && it->second->alive()) {
+        transport->close();
+        return it->second;
+    }
+    // 旧连接上的 shell 会话随桥接 socket 关闭而失效，下次使用时自动重开
+    it->second = transport;
+    return transport;
+}
+
+bool ADBClient::connect_direct(std::string_view ip, std::string_view port) {
+    std::string device_id = std::format("{}:{}", ip, port);
+    {
+        std::lock_guard<std::mutex> lock(direct_mutex_);
+        direct_devices_.try_emplace(device_id);
+    }
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+    try {
+        direct_transport(device_id, &watchdog);
+        finish_call(watchdog, AdbError::NONE);
+        return true;
+    } catch (const std::exception&) {
+        // 保留登记，之后的调用会再次尝试连接
+        finish_call(watchdog, AdbError::CONNECTION);
+        return false;
+    }
+}
+
+void ADBClient::disconnect_direct(std::string_view ip, std::string_view port) {
+    std::string device_id = std::format("{}:{}", ip, port);
+    std::shared_ptr<AdbdTransport> transport;
+    {
+        std::lock_guard<std::mutex> lock(direct_mutex_);
+        auto it = direct_devices_.find(device_id);
+        if (it == direct_devices_.end()) return;
+        transport = std::move(it->second);
+        direct_devices_.erase(it);
+    }
+    close_shell_session(device_id);
+    if (transport) transport->close();
+}
+
+bool ADBClient::is_direct(std::string_view device_id) {
+    std::lock_guard<std::mutex> lock(direct_mutex_);
+    return direct_devices_.contains(std::string(device_id));
+}
+
+std::string ADBClient::shell_quote(std::string_view arg) {
+    // 单引号包裹，内部单引号转义为 '\''
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += "'";
+    return quoted;
+}
+
+AdbPoolStats ADBClient::pool_stats() const {
+    return pool_.stats();
+}
+
+void ADBClient::set_default_timeout(std::chrono::milliseconds timeout) {
+    default_timeout_ms_.store(timeout.count(), std::memory_order_relaxed);
+}
+
+void ADBClient::cancel_all() {
+    // 换上新令牌再取消旧令牌：之后开始的调用不受影响
+    auto token = cancel_all_.exchange(std::make_shared<AdbCancelToken>(), std::memory_order_acq_rel);
+    token->cancel();
+}
+
+AdbError ADBClient::last_error() const {
+    return last_call_error;
+}
+
+AdbCallStats ADBClient::call_stats() const {
+    AdbCallStats stats;
+    stats.timeouts = timeouts_.load(std::memory_order_relaxed);
+    stats.cancellations = cancellations_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::chrono::steady_clock::time_point ADBClient::call_deadline(bool use_default) const {
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (const AdbCallScope* scope = AdbCallScope::current()) {
+        deadline = scope->deadline();
+    }
+    int64_t timeout_ms = default_timeout_ms_.load(std::memory_order_relaxed);
+    if (use_default && timeout_ms > 0) {
+        deadline = std::min(deadline, std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms));
+    }
+    return deadline;
+}
+
+std::vector<std::shared_ptr<AdbCancelToken>> ADBClient::call_tokens() const {
+    std::vector<std::shared_ptr<AdbCancelToken>> tokens{cancel_all_.load(std::memory_order_acquire)};
+    if (const AdbCallScope* scope = AdbCallScope::current(); scope && scope->cancel()) {
+        tokens.push_back(scope->cancel());
+    }
+    return tokens;
+}
+
+void ADBClient::finish_call(const AdbWatchdog& watchdog, AdbError failure) {
+    AdbError reason = watchdog.reason();
+    if (reason == AdbError::NONE || failure == AdbError::NONE) {
+        // 看门狗在操作已完成后才触发时仍算成功
+        last_call_error = failure;
+        return;
+    }
+    last_call_error = reason;
+    if (reason == AdbError::TIMEOUT) {
+        timeouts_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        cancellations_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
 std::string ADBClient::send_command(std::string_view command, std::string_view host, std::string_view port) {
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
     try {
         auto socket = connect_to_server(host, port);
+        auto watch = watchdog.watch(socket);
 
         // ADB协议: 4位十六进制长度 + 命令内容
         std::string request = std::format("{:04x}{}", command.length(), command);
@@ -48,37 +246,23 @@ std::string ADBClient::send_command(std::string_view command, std::string_view h
             // 读取响应内容
             result.resize(len);
             boost::asio::read(socket, boost::asio::buffer(result.data(), len));
+            finish_call(watchdog, AdbError::NONE);
+        } else {
+            finish_call(watchdog, AdbError::REJECTED);
         }
 
         return result;
     } catch (const std::exception&) {
+        finish_call(watchdog, AdbError::CONNECTION);
         return "";
     }
 }
 
 std::string ADBClient::send_device_command(std::string_view device_id, std::string_view command, std::string_view host, std::string_view port) {
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
     try {
-        auto socket = connect_to_server(host, port);
-
-        // 先选择设备
-        std::string transport_cmd = std::format("host:transport:{}", device_id);
-        std::string request = std::format("{:04x}{}", transport_cmd.length(), transport_cmd);
-        boost::asio::write(socket, boost::asio::buffer(request));
-
-        char status[4];
-        boost::asio::read(socket, boost::asio::buffer(status, 4));
-        if (std::string_view(status, 4) != "OKAY") {
-            return "";
-        }
-
-        // 发送命令
-        request = std::format("{:04x}{}", command.length(), command);
-        boost::asio::write(socket, boost::asio::buffer(request));
-
-        boost::asio::read(socket, boost::asio::buffer(status, 4));
-        if (std::string_view(status, 4) != "OKAY") {
-            return "";
-        }
+        auto socket = open_service(device_id, command, &watchdog, host, port);
+        auto watch = watchdog.watch(socket);
 
         // 读取输出（直到连接关闭）
         std::string result;
@@ -86,26 +270,79 @@ std::string ADBClient::send_device_command(std::string_view device_id, std::stri
         boost::system::error_code ec;
         while (true) {
             size_t n = socket.read_some(boost::asio::buffer(buffer), ec);
-            if (ec == boost::asio::error::eof || n == 0) {
-                break;
-            }
+            result.append(buffer, n);
             if (ec) {
                 break;
             }
-            result.append(buffer, n);
         }
 
+        // 超时/取消时 shutdown 也表现为 eof，丢弃不完整的输出
+        if (watchdog.triggered()) {
+            finish_call(watchdog, AdbError::IO);
+            return "";
+        }
+        finish_call(watchdog, ec == boost::asio::error::eof ? AdbError::NONE : AdbError::CONNECTION);
         return result;
     } catch (const std::exception&) {
+        finish_call(watchdog, AdbError::CONNECTION);
         return "";
     }
 }
 
 
 
+std::map<std::string, AdbDeviceStatus> ADBClient::parse_device_list(std::string_view payload) {
+    // 每行 "<serial>\t<state>"
+    std::map<std::string, AdbDeviceStatus> devices;
+    std::istringstream iss{std::string(payload)};
+    std::string line;
+    while (std::getline(iss, line)) {
+        auto tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        devices[line.substr(0, tab)] = stringToAdbDeviceStatus(std::string_view(line).substr(tab + 1));
+    }
+    return devices;
+}
+
+std::map<std::string, AdbDeviceStatus> ADBClient::list_devices() {
+    auto devices = parse_device_list(send_command("host:devices"));
+    add_direct_devices(devices);
+    return devices;
+}
+
+void ADBClient::add_direct_devices(std::map<std::string, AdbDeviceStatus>& devices) {
+    std::lock_guard<std::mutex> lock(direct_mutex_);
+    for (const auto& [device_id, transport] : direct_devices_) {
+        devices[device_id] = transport && transport->alive() ? AdbDeviceStatus::DEVICE : AdbDeviceStatus::OFFLINE;
+    }
+}
+
+uint64_t ADBClient::track_devices(AdbDeviceCallback callback) {
+    std::call_once(tracking_started_, [this] {
+        // 设备离开 device 状态或 transport 变化后，预握手 socket 与 shell 会话都已失效
+        tracker_->subscribe([this](const AdbDeviceEvent& event) {
+            if (event.previous == AdbDeviceStatus::DEVICE) {
+                pool_.invalidate(event.serial);
+                close_shell_session(event.serial);
+            }
+        });
+        tracker_->start();
+    });
+    return tracker_->subscribe(std::move(callback));
+}
+
+void ADBClient::untrack_devices(uint64_t id) {
+    tracker_->unsubscribe(id);
+}
+
 bool ADBClient::connect(std::string_view ip, std::string_view port) {
     std::string cmd = std::format("host:connect:{}:{}", ip, port);
     std::string response = send_command(cmd);
+    // 重连后旧 transport 与 shell 会话失效
+    pool_.invalidate(std::format("{}:{}", ip, port));
+    close_shell_session(std::format("{}:{}", ip, port));
     if (response.find("connected") != std::string::npos) {
         return true;
     }
@@ -115,6 +352,9 @@ bool ADBClient::connect(std::string_view ip, std::string_view port) {
 bool ADBClient::disconnect(std::string_view ip, std::string_view port) {
     std::string cmd = std::format("host:disconnect:{}:{}", ip, port);
     std::string response = send_command(cmd);
+    // 设备已断开，池中为其预握手的 socket 与 shell 会话全部作废
+    pool_.invalidate(std::format("{}:{}", ip, port));
+    close_shell_session(std::format("{}:{}", ip, port));
     if (response.find("disconnected") != std::string::npos) {
         return true;
     }
@@ -127,32 +367,202 @@ std::string ADBClient::shell(std::string_view device_id, std::string_view comman
 }
 
 std::deque<std::string> ADBClient::shell_lines(std::string_view device_id, std::string_view command) {
-    std::string output = shell(device_id, command);
+    // 逐行接收，行尾的 \r 已由流去除，跳过空行
     std::deque<std::string> lines;
-    std::istringstream iss(output);
-    std::string line;
-    while (std::getline(iss, line)) {
-        // 移除行尾的\r（Android shell输出可能带\r\n）
+    shell_stream_lines(device_id, command, [&lines](std::string_view line) {
+        if (!line.empty()) {
+            lines.emplace_back(line);
+        }
+        return true;
+    });
+    return lines;
+}
+
+AdbShellStream ADBClient::open_shell_stream(std::string_view device_id, std::string_view command, size_t buffer_size) {
+    // 流的生命周期由调用方掌握，只对打开过程设默认超时
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+    AdbShellStream stream = open_shell_stream(device_id, command, buffer_size, &watchdog);
+    finish_call(watchdog, stream.ok() ? AdbError::NONE : AdbError::CONNECTION);
+    return stream;
+}
+
+AdbShellStream ADBClient::open_shell_stream(std::string_view device_id, std::string_view command, size_t buffer_size,
+                                            AdbWatchdog* watchdog) {
+    try {
+        std::string shell_cmd = std::format("shell:{}", command);
+        return AdbShellStream(open_service(device_id, shell_cmd, watchdog), buffer_size);
+    } catch (const std::exception&) {
+        return AdbShellStream();
+    }
+}
+
+bool ADBClient::shell_stream(std::string_view device_id, std::string_view command, const AdbChunkCallback& on_chunk) {
+    // logcat 等命令不会自行结束，不设默认超时
+    AdbWatchdog watchdog(io_context_, call_deadline(false), call_tokens());
+    AdbShellStream stream = open_shell_stream(device_id, command, AdbShellStream::DEFAULT_BUFFER_SIZE, &watchdog);
+    if (!stream.ok()) {
+        finish_call(watchdog, AdbError::CONNECTION);
+        return false;
+    }
+    auto watch = watchdog.watch([&stream] { stream.interrupt(); });
+    std::string_view chunk;
+    bool stopped = false; // 回调主动结束视为成功（close() 之后 ok() 为 false）
+    while (stream.next_chunk(chunk)) {
+        if (!on_chunk(chunk)) {
+            stopped = true;
+            stream.close();
+            break;
+        }
+    }
+    bool ok = (stopped || stream.ok()) && !watchdog.triggered();
+    finish_call(watchdog, ok ? AdbError::NONE : AdbError::CONNECTION);
+    return ok;
+}
+
+bool ADBClient::shell_stream_lines(std::string_view device_id, std::string_view command, const AdbLineCallback& on_line) {
+    // 在分块输出上切行，与 AdbShellStream::next_line 一致：去掉行尾 \r，超过缓冲区大小的行分段交出，
+    // 结尾没有换行的最后一行也交出
+    std::string pending; // 跨块的不完整行
+    bool stopped = false;
+    auto emit = [&](std::string_view line) {
         if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
+            line.remove_suffix(1);
         }
-        if (!line.empty()) {
-            lines.push_back(std::move(line));
+        stopped = !on_line(line);
+        return !stopped;
+    };
+    bool ok = shell_stream(device_id, command, [&](std::string_view chunk) {
+        while (!chunk.empty()) {
+            size_t newline = chunk.find('\n');
+            if (newline == std::string_view::npos) {
+                pending.append(chunk);
+                if (pending.size() < AdbShellStream::DEFAULT_BUFFER_SIZE) return true;
+                bool more = emit(pending);
+                pending.clear();
+                return more;
+            }
+            std::string_view line = chunk.substr(0, newline);
+            chunk.remove_prefix(newline + 1);
+            // 整行都在本块内时直接交出，不复制
+            bool more = true;
+            if (pending.empty()) {
+                more = emit(line);
+            } else {
+                pending.append(line);
+                more = emit(pending);
+                pending.clear();
+            }
+            if (!more) return false;
         }
+        return true;
+    });
+    if (!stopped && !pending.empty()) {
+        emit(pending);
     }
-    return lines;
+    return ok;
 }
 
-bool ADBClient::capture_screenshot(std::string_view device_id, std::string_view filename) {
-    // 优先用 exec-out:screencap -p 获取原始 PNG 数据
-    std::string png_data = send_device_command(device_id, "exec-out:screencap -p");
+std::shared_ptr<AdbShellSession> ADBClient::shell_session(std::string_view device_id) {
+    // session_mutex_ 只保护映射表：alive() 要等会话上正在进行的命令，建连与询问特性都是网络 I/O，
+    // 一律在锁外进行，避免一台设备的慢命令阻塞其他设备取会话
+    std::shared_ptr<AdbShellSession> cached;
+    {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        if (auto it = shell_sessions_.find(std::string(device_id)); it != shell_sessions_.end()) {
+            cached = it->second;
+        }
+    }
+    if (cached && cached->alive()) {
+        return cached;
+    }
 
-    // 如果 exec-out 不可用，再尝试 shell（兼容性兜底，但可能损坏）
-    if (png_data.empty()) {
-        png_data = shell(device_id, "screencap -p");
+    // 设备支持 shell_v2 时用 shell,v2,raw:（无 pty，stdout/stderr/退出码分帧），否则退回 exec:sh
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+    std::string features;
+    try {
+        // 直连设备的特性来自 CNXN 握手，无需询问 ADB Server
+        if (auto transport = direct_transport(device_id, &watchdog)) {
+            features = transport->features();
+        } else {
+            features = send_command(std::format("host-serial:{}:features", device_id));
+            if (interrupted(last_call_error)) {
+                return nullptr;
+            }
+        }
+    } catch (const std::exception&) {
+        finish_call(watchdog, AdbError::CONNECTION);
+        return nullptr;
     }
+    bool shell_v2 = features.find("shell_v2") != std::string::npos;
+    std::shared_ptr<AdbShellSession> session;
+    try {
+        session = std::make_shared<AdbShellSession>(
+            open_service(device_id, shell_v2 ? "shell,v2,raw:" : "exec:sh", &watchdog), shell_v2);
+    } catch (const std::exception&) {
+        finish_call(watchdog, AdbError::CONNECTION);
+        return nullptr;
+    }
+    finish_call(watchdog, AdbError::NONE);
+
+    // 只替换之前看到的失效会话；其他线程已先装入新会话时，本次打开的会话随返回值用完后关闭
+    std::shared_ptr<AdbShellSession> replaced;
+    {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        auto& slot = shell_sessions_[std::string(device_id)];
+        if (slot == cached) {
+            replaced = std::exchange(slot, session);
+        }
+    }
+    // 失效会话若在此释放最后一个引用，析构中的关闭也在锁外进行
+    return session;
+}
 
-    if (png_data.empty()) {
+AdbShellResult ADBClient::shell_run(std::string_view device_id, std::string_view command) {
+    // 会话失败后自身标记为不可用，下次调用 shell_session 时重开
+    if (auto session = shell_session(device_id)) {
+        AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+        auto watch = watchdog.watch([&session] { session->interrupt(); });
+        AdbShellResult result = session->run(command);
+        finish_call(watchdog, result.ok ? AdbError::NONE : AdbError::CONNECTION);
+        return result;
+    }
+    AdbShellResult result;
+    if (interrupted(last_call_error)) {
+        return result;
+    }
+    result.out = shell(device_id, command);
+    result.ok = last_call_error == AdbError::NONE;
+    return result;
+}
+
+void ADBClient::close_shell_session(std::string_view device_id) {
+    std::shared_ptr<AdbShellSession> session;
+    {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        auto it = shell_sessions_.find(std::string(device_id));
+        if (it == shell_sessions_.end()) return;
+        session = std::move(it->second);
+        shell_sessions_.erase(it);
+    }
+    // 其他线程仍在使用时由最后一个持有者析构关闭
+}
+
+std::optional<tcp::socket> ADBClient::exec_stream(std::string_view device_id, std::string_view command) {
+    // 只对打开过程设默认超时，之后的读写由调用方掌握
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+    try {
+        auto socket = open_service(device_id, std::format("exec:{}", command), &watchdog);
+        finish_call(watchdog, AdbError::NONE);
+        return socket;
+    } catch (const std::exception&) {
+        finish_call(watchdog, AdbError::CONNECTION);
+        return std::nullopt;
+    }
+}
+
+bool ADBClient::capture_screenshot(std::string_view device_id, std::string_view filename) {
+    std::string png_data;
+    if (!capture_png(device_id, png_data)) {
         return false;
     }
 
@@ -168,66 +578,183 @@ bool ADBClient::capture_screenshot(std::string_view device_id, std::string_view
     return file.good();
 }
 
-bool ADBClient::pull(std::string_view device_id, std::string_view remote_path, std::string_view local_path) {
-    // 使用shell的cat命令读取文件内容
-    std::string cmd = std::format("cat {}", remote_path);
-    std::string content = shell(device_id, cmd);
-
-    if (content.empty()) {
-        return false;
-    }
-
-    std::ofstream file(std::string(local_path), std::ios::binary);
-    if (!file) {
-        return false;
+namespace {
+
+// 把 socket 剩余数据按块写入输出流，返回字节数
+uint64_t drain_to_stream(tcp::socket& socket, std::ostream& out) {
+    uint64_t total = 0;
+    std::string buffer(ADB_SYNC_MAX_CHUNK, '\0');
+    boost::system::error_code ec;
+    while (true) {
+        size_t n = socket.read_some(boost::asio::buffer(buffer.data(), buffer.size()), ec);
+        if (n > 0) {
+            out.write(buffer.data(), static_cast<std::streamsize>(n));
+            if (!out) {
+                throw std::runtime_error("写入本地文件失败");
+            }
+            total += n;
+        }
+        if (ec == boost::asio::error::eof) break;
+        if (ec) throw boost::system::system_error(ec);
     }
-    file.write(content.data(), static_cast<std::streamsize>(content.size()));
-    return file.good();
+    return total;
 }
 
-bool ADBClient::push(std::string_view device_id, std::string_view local_path, std::string_view remote_path) {
-    // 读取本地文件
-    std::ifstream file(std::string(local_path), std::ios::binary);
-    if (!file) {
-        return false;
+// 把输入流剩余内容按块写入 socket，返回字节数
+uint64_t pump_from_stream(std::istream& in, tcp::socket& socket) {
+    uint64_t total = 0;
+    std::string buffer(ADB_SYNC_MAX_CHUNK, '\0');
+    while (in) {
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        auto n = static_cast<size_t>(in.gcount());
+        if (n == 0) break;
+        boost::asio::write(socket, boost::asio::buffer(buffer.data(), n));
+        total += n;
     }
+    return total;
+}
 
-    std::string content((std::istreambuf_iterator<char>(file)),
-                         std::istreambuf_iterator<char>());
+uint32_t local_mtime(const std::filesystem::path& path) {
+    std::error_code ec;
+    auto ftime = std::filesystem::last_write_time(path, ec);
+    if (ec) return 0;
+    auto sys = std::chrono::file_clock::to_sys(ftime);
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(sys.time_since_epoch()).count());
+}
 
-    // 使用shell写入
-    // 注意：这种方式对大文件效率较低，完整实现应使用sync协议
-    std::string cmd = std::format("cat > {}", remote_path);
+} // namespace
 
+AdbFileStat ADBClient::stat(std::string_view device_id, std::string_view remote_path) {
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
     try {
-        auto socket = connect_to_server();
+        AdbSyncConnection sync(open_service(device_id, "sync:", &watchdog));
+        auto watch = watchdog.watch([&sync] { sync.interrupt(); });
+        AdbFileStat result = sync.stat(remote_path);
+        finish_call(watchdog, AdbError::NONE);
+        return result;
+    } catch (const std::exception&) {
+        finish_call(watchdog, AdbError::CONNECTION);
+        return {};
+    }
+}
 
-        // 选择设备
-        std::string transport_cmd = std::format("host:transport:{}", device_id);
-        std::string request = std::format("{:04x}{}", transport_cmd.length(), transport_cmd);
-        boost::asio::write(socket, boost::asio::buffer(request));
+bool ADBClient::pull(std::string_view device_id, std::string_view remote_path, std::string_view local_path,
+                     AdbTransferStats* stats, bool resume) {
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+    AdbTransferStats result;
+    fs::path local(local_path);
 
-        char status[4];
-        boost::asio::read(socket, boost::asio::buffer(status, 4));
-        if (std::string_view(status, 4) != "OKAY") {
+    // 传输时长与文件大小相关，不设默认超时
+    AdbWatchdog watchdog(io_context_, call_deadline(false), call_tokens());
+    try {
+        AdbSyncConnection sync(open_service(device_id, "sync:", &watchdog));
+        auto watch = watchdog.watch([&sync] { sync.interrupt(); });
+        AdbFileStat remote = sync.stat(remote_path);
+        if (!remote.exists()) {
+            finish_call(watchdog, AdbError::REJECTED);
             return false;
         }
+        result.total_size = remote.size;
+
+        std::error_code ec;
+        uint64_t local_size = resume ? fs::file_size(local, ec) : 0;
+        if (ec) local_size = 0;
+
+        if (local_size > 0 && local_size <= remote.size) {
+            // 断点续传：sync RECV 不支持偏移，剩余部分用 tail -c 经 exec: 原样传回
+            result.resumed_from = local_size;
+            sync.quit();
+            if (local_size < remote.size) {
+                std::ofstream file(local, std::ios::binary | std::ios::app);
+                if (!file) {
+                    finish_call(watchdog, AdbError::IO);
+                    return false;
+                }
+                auto socket = open_service(device_id,
+                    std::format("exec:tail -c +{} {}", local_size + 1, shell_quote(remote_path)), &watchdog);
+                auto tail_watch = watchdog.watch(socket);
+                result.bytes = drain_to_stream(socket, file);
+            }
+        } else {
+            std::ofstream file(local, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                finish_call(watchdog, AdbError::IO);
+                return false;
+            }
+            result.bytes = sync.recv(remote_path, file);
+        }
+    } catch (const std::exception&) {
+        // 已写入的部分保留在本地，供下次续传
+        finish_call(watchdog, AdbError::CONNECTION);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (stats) *stats = result;
+        return false;
+    }
 
-        // 发送shell命令
-        std::string shell_cmd = std::format("shell:{}", cmd);
-        request = std::format("{:04x}{}", shell_cmd.length(), shell_cmd);
-        boost::asio::write(socket, boost::asio::buffer(request));
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) *stats = result;
 
-        boost::asio::read(socket, boost::asio::buffer(status, 4));
-        if (std::string_view(status, 4) != "OKAY") {
-            return false;
+    std::error_code ec;
+    bool ok = fs::file_size(local, ec) == result.total_size && !ec && !watchdog.triggered();
+    finish_call(watchdog, ok ? AdbError::NONE : AdbError::IO);
+    return ok;
+}
+
+bool ADBClient::push(std::string_view device_id, std::string_view local_path, std::string_view remote_path,
+                     AdbTransferStats* stats, bool resume) {
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+    AdbTransferStats result;
+    fs::path local(local_path);
+
+    std::ifstream file(local, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::error_code ec;
+    uint64_t local_size = fs::file_size(local, ec);
+    if (ec) {
+        return false;
+    }
+    result.total_size = local_size;
+
+    bool ok = false;
+    AdbWatchdog watchdog(io_context_, call_deadline(false), call_tokens());
+    try {
+        AdbSyncConnection sync(open_service(device_id, "sync:", &watchdog));
+        auto watch = watchdog.watch([&sync] { sync.interrupt(); });
+        AdbFileStat remote;
+        if (resume) {
+            remote = sync.stat(remote_path);
         }
 
-        // 发送文件内容
-        boost::asio::write(socket, boost::asio::buffer(content));
-        return true;
+        if (remote.exists() && remote.size > 0 && remote.size <= local_size) {
+            // 断点续传：SEND 只能整体覆盖，剩余部分经 exec:cat >> 追加
+            result.resumed_from = remote.size;
+            if (remote.size < local_size) {
+                file.seekg(static_cast<std::streamoff>(remote.size));
+                auto socket = open_service(device_id, std::format("exec:cat >> {}", shell_quote(remote_path)), &watchdog);
+                auto append_watch = watchdog.watch(socket);
+                result.bytes = pump_from_stream(file, socket);
+                // 关闭写端让 cat 结束，再等待远端关闭连接
+                socket.shutdown(tcp::socket::shutdown_send);
+                std::ostringstream discard;
+                drain_to_stream(socket, discard);
+            }
+            ok = sync.stat(remote_path).size == local_size;
+        } else {
+            // 普通文件，权限 0644
+            constexpr uint32_t mode = 0100644;
+            result.bytes = sync.send(remote_path, mode, local_mtime(local), file);
+            ok = true;
+        }
     } catch (const std::exception&) {
-        return false;
+        ok = false;
     }
-}
+    finish_call(watchdog, ok ? AdbError::NONE : AdbError::CONNECTION);
 
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) *stats = result;
+    return ok;
+}
@@ -0,0 +1,310 @@
+#include "ADBClient.hpp"
+#include "AdbFrameDecoder.hpp"
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::asio::ip::tcp;
+
+namespace {
+
+constexpr std::string_view ADB_HOST = "127.0.0.1";
+constexpr std::string_view ADB_PORT = "5037";
+
+void put_le32(char* dst, uint32_t value) {
+    dst[0] = static_cast<char>(value & 0xff);
+    dst[1] = static_cast<char>((value >> 8) & 0xff);
+    dst[2] = static_cast<char>((value >> 16) & 0xff);
+    dst[3] = static_cast<char>((value >> 24) & 0xff);
+}
+
+uint32_t get_le32(const char* src) {
+    auto b = reinterpret_cast<const unsigned char*>(src);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+// 发送 ADB 请求（4 位十六进制长度 + 内容）并确认 OKAY，失败抛出异常
+awaitable<void> async_request(tcp::socket& socket, std::string_view command) {
+    std::string request = std::format("{:04x}{}", command.length(), command);
+    co_await boost::asio::async_write(socket, boost::asio::buffer(request), use_awaitable);
+
+    char status[4];
+    co_await boost::asio::async_read(socket, boost::asio::buffer(status, 4), use_awaitable);
+    if (std::string_view(status, 4) != "OKAY") {
+        throw std::runtime_error(std::format("请求失败: {}", command));
+    }
+}
+
+// 读取直到对端关闭
+awaitable<std::string> async_read_all(tcp::socket& socket) {
+    std::string result;
+    char buffer[4096];
+    while (true) {
+        boost::system::error_code ec;
+        size_t n = co_await socket.async_read_some(boost::asio::buffer(buffer),
+                                                   boost::asio::redirect_error(use_awaitable, ec));
+        result.append(buffer, n);
+        if (ec == boost::asio::error::eof) break;
+        if (ec) throw boost::system::system_error(ec);
+    }
+    co_return result;
+}
+
+// sync 请求：4 字节 ID + 小端长度 + 负载
+awaitable<void> async_sync_request(tcp::socket& socket, std::string_view id, std::string_view payload) {
+    char header[8];
+    std::memcpy(header, id.data(), 4);
+    put_le32(header + 4, static_cast<uint32_t>(payload.size()));
+    std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(header, 8),
+        boost::asio::buffer(payload.data(), payload.size())
+    };
+    co_await boost::asio::async_write(socket, buffers, use_awaitable);
+}
+
+// 读取 SEND 结束后的状态，FAIL 时读出错误信息并抛出异常
+awaitable<void> async_sync_status(tcp::socket& socket) {
+    char header[8];
+    co_await boost::asio::async_read(socket, boost::asio::buffer(header, 8), use_awaitable);
+    std::string_view id(header, 4);
+    uint32_t length = get_le32(header + 4);
+    if (id == "FAIL") {
+        std::string message(length, '\0');
+        co_await boost::asio::async_read(socket, boost::asio::buffer(message.data(), length), use_awaitable);
+        throw std::runtime_error(std::format("sync 失败: {}", message));
+    }
+    if (id != "OKAY") {
+        throw std::runtime_error("sync 响应无效");
+    }
+}
+
+} // namespace
+
+awaitable<tcp::socket> ADBClient::async_open_service(std::string device_id, std::string service) {
+    std::shared_ptr<AdbdTransport> direct;
+    bool is_direct_device = false;
+    {
+        std::lock_guard<std::mutex> lock(direct_mutex_);
+        if (auto it = direct_devices_.find(device_id); it != direct_devices_.end()) {
+            is_direct_device = true;
+            direct = it->second;
+        }
+    }
+    if (is_direct_device) {
+        // 握手可能要等用户确认，不在事件循环上重连，由下一次阻塞调用负责
+        if (!direct || !direct->alive()) {
+            throw std::runtime_error(std::format("直连设备未连接: {}", device_id));
+        }
+        co_return co_await direct->async_open(std::move(service));
+    }
+
+    std::optional<tcp::socket> pooled = pool_.try_acquire(device_id, ADB_HOST, ADB_PORT);
+    tcp::socket socket = pooled ? std::move(*pooled) : tcp::socket(io_context_);
+    if (!pooled) {
+        // 未命中：异步建连并握手，不阻塞事件循环
+        auto endpoints = co_await pool_.async_resolve(std::string(ADB_HOST), std::string(ADB_PORT));
+        co_await boost::asio::async_connect(socket, endpoints, use_awaitable);
+        socket.set_option(tcp::no_delay(true));
+        std::string transport = std::format("host:transport:{}", device_id);
+        co_await async_request(socket, transport);
+    }
+    co_await async_request(socket, service);
+    co_return socket;
+}
+
+awaitable<std::map<std::string, AdbDeviceStatus>> ADBClient::async_list_devices() {
+    std::map<std::string, AdbDeviceStatus> devices;
+    try {
+        tcp::socket socket(io_context_);
+        auto endpoints = co_await pool_.async_resolve(std::string(ADB_HOST), std::string(ADB_PORT));
+        co_await boost::asio::async_connect(socket, endpoints, use_awaitable);
+        co_await async_request(socket, "host:devices");
+
+        char len_buf[4];
+        co_await boost::asio::async_read(socket, boost::asio::buffer(len_buf, 4), use_awaitable);
+        int len = std::stoi(std::string(len_buf, 4), nullptr, 16);
+        std::string payload(len, '\0');
+        co_await boost::asio::async_read(socket, boost::asio::buffer(payload.data(), len), use_awaitable);
+        devices = parse_device_list(payload);
+    } catch (const std::exception&) {
+        // ADB Server 不可用时仍列出直连设备
+    }
+    add_direct_devices(devices);
+    co_return devices;
+}
+
+awaitable<std::string> ADBClient::async_shell(std::string device_id, std::string command) {
+    try {
+        auto socket = co_await async_open_service(device_id, std::format("shell:{}", command));
+        co_return co_await async_read_all(socket);
+    } catch (const std::exception&) {
+        co_return std::string{};
+    }
+}
+
+awaitable<bool> ADBClient::async_capture_png(std::string device_id, std::string& out_png) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        auto socket = co_await async_open_service(device_id, AdbFrameDecoder::service(AdbCaptureMode::PNG));
+        out_png = co_await async_read_all(socket);
+    } catch (const std::exception&) {
+        out_png.clear();
+    }
+
+    AdbCaptureStats sample;
+    sample.wire_bytes = out_png.size();
+    sample.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record_capture(device_id, AdbCaptureMode::PNG, sample, !out_png.empty());
+    co_return !out_png.empty();
+}
+
+awaitable<bool> ADBClient::async_capture_screenshot(std::string device_id, std::string filename) {
+    std::string png_data;
+    if (!co_await async_capture_png(device_id, png_data)) {
+        co_return false;
+    }
+    std::ofstream file(std::format("{}/{}", work_dir_, filename), std::ios::binary);
+    if (!file) {
+        co_return false;
+    }
+    file.write(png_data.data(), static_cast<std::streamsize>(png_data.size()));
+    co_return file.good();
+}
+
+awaitable<bool> ADBClient::async_capture_raw(std::string device_id, AdbRawFrame& frame, AdbCaptureMode mode) {
+    auto start = std::chrono::steady_clock::now();
+    auto decoder = AdbFrameDecoder::create(mode, frame, cached_header_size(device_id));
+    if (!decoder) {
+        co_return false;
+    }
+    bool ok = false;
+    try {
+        auto socket = co_await async_open_service(device_id, AdbFrameDecoder::service(mode));
+        ok = true;
+        while (true) {
+            boost::system::error_code ec;
+            size_t n = co_await socket.async_read_some(decoder->prepare(), boost::asio::redirect_error(use_awaitable, ec));
+            if (n > 0 && !decoder->commit(n)) {
+                ok = false;
+                break;
+            }
+            if (ec == boost::asio::error::eof) break;
+            if (ec) throw boost::system::system_error(ec);
+        }
+        ok = ok && decoder->finish();
+    } catch (const std::exception&) {
+        ok = false;
+    }
+    finish_capture(device_id, mode, frame, *decoder, ok, std::chrono::steady_clock::now() - start);
+    co_return ok;
+}
+
+awaitable<bool> ADBClient::async_pull(std::string device_id, std::string remote_path, std::string local_path,
+                                      AdbTransferStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    AdbTransferStats result;
+    bool ok = false;
+    try {
+        auto socket = co_await async_open_service(device_id, "sync:");
+
+        co_await async_sync_request(socket, "STAT", remote_path);
+        char reply[16];
+        co_await boost::asio::async_read(socket, boost::asio::buffer(reply, 16), use_awaitable);
+        if (std::string_view(reply, 4) != "STAT" || get_le32(reply + 4) == 0) {
+            throw std::runtime_error("远端文件不存在");
+        }
+        result.total_size = get_le32(reply + 8);
+
+        std::ofstream file(local_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("无法打开本地文件");
+        }
+        co_await async_sync_request(socket, "RECV", remote_path);
+        std::string buffer(ADB_SYNC_MAX_CHUNK, '\0');
+        while (true) {
+            char header[8];
+            co_await boost::asio::async_read(socket, boost::asio::buffer(header, 8), use_awaitable);
+            std::string_view id(header, 4);
+            uint32_t length = get_le32(header + 4);
+            if (id == "DONE") break;
+            if (id != "DATA" && id != "FAIL") {
+                throw std::runtime_error("sync 响应无效");
+            }
+            if (length > ADB_SYNC_MAX_CHUNK) {
+                throw std::runtime_error("sync 数据包过大");
+            }
+            co_await boost::asio::async_read(socket, boost::asio::buffer(buffer.data(), length), use_awaitable);
+            if (id == "FAIL") {
+                throw std::runtime_error(std::format("sync 失败: {}", std::string_view(buffer.data(), length)));
+            }
+            file.write(buffer.data(), length);
+            if (!file) {
+                throw std::runtime_error("写入本地文件失败");
+            }
+            result.bytes += length;
+        }
+        co_await async_sync_request(socket, "QUIT", "");
+        ok = result.bytes == result.total_size;
+    } catch (const std::exception&) {
+        ok = false;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) *stats = result;
+    co_return ok;
+}
+
+awaitable<bool> ADBClient::async_push(std::string device_id, std::string local_path, std::string remote_path,
+                                      AdbTransferStats* stats) {
+    namespace fs = std::filesystem;
+    auto start = std::chrono::steady_clock::now();
+    AdbTransferStats result;
+
+    std::ifstream file(local_path, std::ios::binary);
+    std::error_code ec;
+    result.total_size = fs::file_size(local_path, ec);
+    if (!file || ec) {
+        co_return false;
+    }
+
+    bool ok = false;
+    try {
+        auto socket = co_await async_open_service(device_id, "sync:");
+
+        // 普通文件，权限 0644；mtime 取本地文件修改时间
+        constexpr uint32_t mode = 0100644;
+        auto ftime = fs::last_write_time(local_path, ec);
+        uint32_t mtime = ec ? 0 : static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::file_clock::to_sys(ftime).time_since_epoch()).count());
+
+        std::string send_arg = std::format("{},{}", remote_path, mode);
+        co_await async_sync_request(socket, "SEND", send_arg);
+        std::string buffer(ADB_SYNC_MAX_CHUNK, '\0');
+        while (file) {
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            auto n = static_cast<size_t>(file.gcount());
+            if (n == 0) break;
+            co_await async_sync_request(socket, "DATA", std::string_view(buffer.data(), n));
+            result.bytes += n;
+        }
+        char done[8];
+        std::memcpy(done, "DONE", 4);
+        put_le32(done + 4, mtime);
+        co_await boost::asio::async_write(socket, boost::asio::buffer(done, 8), use_awaitable);
+
+        co_await async_sync_status(socket);
+        co_await async_sync_request(socket, "QUIT", "");
+        ok = true;
+    } catch (const std::exception&) {
+        ok = false;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) *stats = result;
+    co_return ok;
+}
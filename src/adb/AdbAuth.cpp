@@ -0,0 +1,161 @@
+#include "../../include/adb/AdbAuth.hpp"
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <unistd.h>
+
+namespace {
+
+// Android RSAPublicKey 结构（adb/crypto/rsa_2048_key）：2048 位模数，各字段小端
+constexpr int ANDROID_PUBKEY_MODULUS_SIZE = 2048 / 8;
+constexpr int ANDROID_PUBKEY_WORDS = ANDROID_PUBKEY_MODULUS_SIZE / 4;
+constexpr size_t ANDROID_PUBKEY_ENCODED_SIZE = 4 + 4 + ANDROID_PUBKEY_MODULUS_SIZE * 2 + 4;
+
+// AUTH 令牌长度（即 SHA-1 摘要长度）
+constexpr size_t AUTH_TOKEN_SIZE = 20;
+
+using BnPtr = std::unique_ptr<BIGNUM, decltype(&BN_free)>;
+using BnCtxPtr = std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)>;
+
+void put_le32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+bool put_bn_le(std::string& out, const BIGNUM* bn) {
+    unsigned char buffer[ANDROID_PUBKEY_MODULUS_SIZE];
+    if (BN_bn2lebinpad(bn, buffer, sizeof(buffer)) != sizeof(buffer)) return false;
+    out.append(reinterpret_cast<const char*>(buffer), sizeof(buffer));
+    return true;
+}
+
+std::string base64(const std::string& data) {
+    std::string out(4 * ((data.size() + 2) / 3) + 1, '\0');
+    int n = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(out.data()),
+                            reinterpret_cast<const unsigned char*>(data.data()), static_cast<int>(data.size()));
+    out.resize(n > 0 ? static_cast<size_t>(n) : 0);
+    return out;
+}
+
+std::string user_at_host() {
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) != 0) {
+        std::snprintf(host, sizeof(host), "unknown");
+    }
+    const char* user = std::getenv("USER");
+    return std::format("{}@{}", user ? user : "unknown", host);
+}
+
+} // namespace
+
+AdbRsaKey::~AdbRsaKey() {
+    EVP_PKEY_free(key_);
+}
+
+std::string AdbRsaKey::default_path(std::string_view work_dir) {
+    namespace fs = std::filesystem;
+    if (const char* android_home = std::getenv("ANDROID_USER_HOME")) {
+        fs::path path = fs::path(android_home) / "adbkey";
+        if (fs::exists(path)) return path.string();
+    }
+    if (const char* home = std::getenv("HOME")) {
+        fs::path path = fs::path(home) / ".android" / "adbkey";
+        if (fs::exists(path)) return path.string();
+    }
+    return (fs::path(work_dir) / "adbkey").string();
+}
+
+std::shared_ptr<AdbRsaKey> AdbRsaKey::load_or_create(const std::string& path) {
+    if (FILE* file = std::fopen(path.c_str(), "r")) {
+        EVP_PKEY* key = PEM_read_PrivateKey(file, nullptr, nullptr, nullptr);
+        std::fclose(file);
+        if (!key) return nullptr;
+        if (EVP_PKEY_get_base_id(key) != EVP_PKEY_RSA || EVP_PKEY_get_bits(key) != 2048) {
+            // adbd 只接受 2048 位 RSA
+            EVP_PKEY_free(key);
+            return nullptr;
+        }
+        return std::shared_ptr<AdbRsaKey>(new AdbRsaKey(key));
+    }
+
+    EVP_PKEY* key = EVP_RSA_gen(2048);
+    if (!key) return nullptr;
+    std::shared_ptr<AdbRsaKey> result(new AdbRsaKey(key));
+
+    std::error_code ec;
+    auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return nullptr;
+    bool written = PEM_write_PrivateKey(file, key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    std::fclose(file);
+    if (!written) return nullptr;
+    std::filesystem::permissions(path, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+                                 std::filesystem::perm_options::replace, ec);
+    std::ofstream(path + ".pub") << result->public_key() << "\n";
+    return result;
+}
+
+std::string AdbRsaKey::sign(std::string_view token) const {
+    if (token.size() != AUTH_TOKEN_SIZE) return "";
+    // 令牌直接当作 SHA-1 摘要做 PKCS#1 v1.5 签名（adbd 以 RSA_verify(NID_sha1, ...) 校验）
+    std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new(key_, nullptr), EVP_PKEY_CTX_free);
+    if (!ctx || EVP_PKEY_sign_init(ctx.get()) <= 0 ||
+        EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING) <= 0 ||
+        EVP_PKEY_CTX_set_signature_md(ctx.get(), EVP_sha1()) <= 0) {
+        return "";
+    }
+    size_t length = 0;
+    auto input = reinterpret_cast<const unsigned char*>(token.data());
+    if (EVP_PKEY_sign(ctx.get(), nullptr, &length, input, token.size()) <= 0) return "";
+    std::string signature(length, '\0');
+    if (EVP_PKEY_sign(ctx.get(), reinterpret_cast<unsigned char*>(signature.data()), &length, input, token.size()) <= 0) {
+        return "";
+    }
+    signature.resize(length);
+    return signature;
+}
+
+std::string AdbRsaKey::public_key() const {
+    BIGNUM* n_raw = nullptr;
+    BIGNUM* e_raw = nullptr;
+    if (!EVP_PKEY_get_bn_param(key_, OSSL_PKEY_PARAM_RSA_N, &n_raw) ||
+        !EVP_PKEY_get_bn_param(key_, OSSL_PKEY_PARAM_RSA_E, &e_raw)) {
+        BN_free(n_raw);
+        return "";
+    }
+    BnPtr n(n_raw, BN_free);
+    BnPtr e(e_raw, BN_free);
+    BnCtxPtr ctx(BN_CTX_new(), BN_CTX_free);
+    BnPtr r32(BN_new(), BN_free);
+    BnPtr n0inv(BN_new(), BN_free);
+    BnPtr rr(BN_new(), BN_free);
+    if (!ctx || !r32 || !n0inv || !rr) return "";
+
+    // n0inv = -1 / n[0] mod 2^32
+    BN_set_bit(r32.get(), 32);
+    BN_mod(n0inv.get(), n.get(), r32.get(), ctx.get());
+    BN_mod_inverse(n0inv.get(), n0inv.get(), r32.get(), ctx.get());
+    BN_sub(n0inv.get(), r32.get(), n0inv.get());
+    // rr = (2^2048)^2 mod n
+    BN_set_bit(rr.get(), ANDROID_PUBKEY_MODULUS_SIZE * 8);
+    BN_mod_sqr(rr.get(), rr.get(), n.get(), ctx.get());
+
+    std::string encoded;
+    encoded.reserve(ANDROID_PUBKEY_ENCODED_SIZE);
+    put_le32(encoded, ANDROID_PUBKEY_WORDS);
+    put_le32(encoded, static_cast<uint32_t>(BN_get_word(n0inv.get())));
+    if (!put_bn_le(encoded, n.get()) || !put_bn_le(encoded, rr.get())) return "";
+    put_le32(encoded, static_cast<uint32_t>(BN_get_word(e.get())));
+    return std::format("{} {}", base64(encoded), user_at_host());
+}
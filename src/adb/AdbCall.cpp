@@ -0,0 +1,157 @@
+#include "../../include/adb/AdbCall.hpp"
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+thread_local const AdbCallScope* current_scope = nullptr;
+
+} // namespace
+
+std::string_view adbErrorToString(AdbError error) {
+    switch (error) {
+        case AdbError::NONE:       return "成功";
+        case AdbError::TIMEOUT:    return "超时";
+        case AdbError::CANCELLED:  return "已取消";
+        case AdbError::CONNECTION: return "连接失败";
+        case AdbError::REJECTED:   return "请求被拒绝";
+        case AdbError::IO:         return "读写失败";
+    }
+    return "未知错误";
+}
+
+// ========== AdbCancelToken ==========
+
+void AdbCancelToken::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_) return;
+    cancelled_ = true;
+    for (auto& [id, interrupt] : interrupts_) {
+        interrupt();
+    }
+}
+
+bool AdbCancelToken::cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cancelled_;
+}
+
+void AdbCancelToken::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = false;
+}
+
+uint64_t AdbCancelToken::bind(std::function<void()> interrupt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_) {
+        interrupt();
+    }
+    uint64_t id = next_id_++;
+    interrupts_.emplace(id, std::move(interrupt));
+    return id;
+}
+
+void AdbCancelToken::unbind(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    interrupts_.erase(id);
+}
+
+// ========== AdbCallScope ==========
+
+AdbCallScope::AdbCallScope(const AdbCallOptions& options)
+    : deadline_(options.timeout.count() > 0 ? std::chrono::steady_clock::now() + options.timeout
+                                            : std::chrono::steady_clock::time_point::max())
+    , cancel_(options.cancel)
+    , outer_(current_scope)
+{
+    // 嵌套作用域不能放宽外层的截止时间
+    if (outer_ && outer_->deadline_ < deadline_) {
+        deadline_ = outer_->deadline_;
+    }
+    current_scope = this;
+}
+
+AdbCallScope::~AdbCallScope() {
+    current_scope = outer_;
+}
+
+const AdbCallScope* AdbCallScope::current() {
+    return current_scope;
+}
+
+// ========== AdbWatchdog ==========
+
+void AdbWatchdog::State::trigger(AdbError why) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (reason != AdbError::NONE) return;
+    reason = why;
+    if (interrupt) interrupt();
+}
+
+AdbWatchdog::AdbWatchdog(boost::asio::io_context& io_context, std::chrono::steady_clock::time_point deadline,
+                         std::vector<std::shared_ptr<AdbCancelToken>> tokens)
+    : io_context_(io_context)
+    , state_(std::make_shared<State>(io_context))
+{
+    for (auto& token : tokens) {
+        if (!token) continue;
+        std::weak_ptr<State> weak = state_;
+        uint64_t id = token->bind([weak] {
+            if (auto state = weak.lock()) state->trigger(AdbError::CANCELLED);
+        });
+        bindings_.emplace_back(std::move(token), id);
+    }
+    if (deadline != std::chrono::steady_clock::time_point::max()) {
+        has_deadline_ = true;
+        if (deadline <= std::chrono::steady_clock::now()) {
+            state_->trigger(AdbError::TIMEOUT);
+        } else {
+            // 定时器在连接池的后台线程上到期
+            state_->timer.expires_at(deadline);
+            state_->timer.async_wait([state = state_](const boost::system::error_code& ec) {
+                if (!ec) state->trigger(AdbError::TIMEOUT);
+            });
+        }
+    }
+}
+
+AdbWatchdog::~AdbWatchdog() {
+    for (auto& [token, id] : bindings_) {
+        token->unbind(id);
+    }
+    release();
+    if (has_deadline_) {
+        // 定时器只在后台线程上操作，回调持有 state 直到取消完成
+        boost::asio::post(io_context_, [state = state_] { state->timer.cancel(); });
+    }
+}
+
+AdbWatchdog::Watch AdbWatchdog::watch(tcp::socket& socket) {
+    return watch([&socket] {
+        // 只 shutdown 不 close：fd 仍归调用线程所有，阻塞中的读写立即返回
+        boost::system::error_code ec;
+        socket.shutdown(tcp::socket::shutdown_both, ec);
+    });
+}
+
+AdbWatchdog::Watch AdbWatchdog::watch(std::function<void()> interrupt) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    std::function<void()> previous = std::exchange(state_->interrupt, std::move(interrupt));
+    if (state_->reason != AdbError::NONE) {
+        state_->interrupt();
+    }
+    return Watch(this, std::move(previous));
+}
+
+void AdbWatchdog::restore(std::function<void()> interrupt) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->interrupt = std::move(interrupt);
+    if (state_->interrupt && state_->reason != AdbError::NONE) {
+        state_->interrupt();
+    }
+}
+
+AdbError AdbWatchdog::reason() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->reason;
+}
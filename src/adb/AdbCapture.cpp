@@ -0,0 +1,266 @@
+#include "ADBClient.hpp"
+#include "AdbFrameDecoder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <unistd.h>
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+// 局部截取连续失败（短读且几何信息未变）多少次后认定设备不支持，改走整帧
+constexpr int PARTIAL_FAILURE_LIMIT = 3;
+
+// 多区间截取的设备临时文件序号，与进程号一起保证并发调用互不覆盖
+std::atomic<uint64_t> partial_file_seq{0};
+
+// 读取直到填满或对端关闭，返回实际读取字节数
+size_t read_until_eof(tcp::socket& socket, uint8_t* data, size_t size) {
+    boost::system::error_code ec;
+    size_t n = boost::asio::read(socket, boost::asio::buffer(data, size), ec);
+    if (ec && ec != boost::asio::error::eof) {
+        throw boost::system::system_error(ec);
+    }
+    return n;
+}
+
+// 阻塞读取 socket 直到对端关闭，数据交给解码器
+bool run_decoder(tcp::socket& socket, AdbFrameDecoder& decoder) {
+    boost::system::error_code ec;
+    while (true) {
+        size_t n = socket.read_some(decoder.prepare(), ec);
+        if (n > 0 && !decoder.commit(n)) return false;
+        if (ec == boost::asio::error::eof) break;
+        if (ec) throw boost::system::system_error(ec);
+    }
+    return decoder.finish();
+}
+
+} // namespace
+
+bool ADBClient::capture_png(std::string_view device_id, std::string& out_png) {
+    auto start = std::chrono::steady_clock::now();
+
+    // 优先用 exec-out:screencap -p 获取原始 PNG 数据
+    out_png = send_device_command(device_id, "exec-out:screencap -p");
+
+    // 如果 exec-out 不可用，再尝试 shell（兼容性兜底，但可能损坏）；超时或取消时不再重试
+    if (out_png.empty() && !interrupted(last_error())) {
+        out_png = shell(device_id, "screencap -p");
+    }
+
+    AdbCaptureStats sample;
+    sample.wire_bytes = out_png.size();
+    sample.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    record_capture(device_id, AdbCaptureMode::PNG, sample, !out_png.empty());
+    return !out_png.empty();
+}
+
+bool ADBClient::capture_raw(std::string_view device_id, AdbRawFrame& frame, AdbCaptureMode mode) {
+    auto start = std::chrono::steady_clock::now();
+    auto decoder = AdbFrameDecoder::create(mode, frame, cached_header_size(device_id));
+    if (!decoder) {
+        return false;
+    }
+    bool ok = false;
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+    try {
+        auto socket = open_service(device_id, AdbFrameDecoder::service(mode), &watchdog);
+        auto watch = watchdog.watch(socket);
+        ok = run_decoder(socket, *decoder) && !watchdog.triggered();
+    } catch (const std::exception&) {
+        ok = false;
+    }
+    finish_call(watchdog, ok ? AdbError::NONE : AdbError::CONNECTION);
+    finish_capture(device_id, mode, frame, *decoder, ok, std::chrono::steady_clock::now() - start);
+    return ok;
+}
+
+void ADBClient::finish_capture(std::string_view device_id, AdbCaptureMode mode, AdbRawFrame& frame,
+                               const AdbFrameDecoder& decoder, bool ok, std::chrono::steady_clock::duration elapsed) {
+    AdbCaptureStats sample;
+    sample.wire_bytes = decoder.wire_bytes();
+    sample.decode_seconds = decoder.decode_seconds();
+    sample.total_seconds = std::chrono::duration<double>(elapsed).count();
+    if (ok) {
+        frame.valid_rows.clear();
+        sample.pixel_bytes = frame.pixels.size();
+        if (mode != AdbCaptureMode::FRAMEBUFFER) {
+            cache_geometry(device_id, frame, decoder.header_size());
+        }
+    }
+    record_capture(device_id, mode, sample, ok);
+}
+
+void ADBClient::set_capture_mode(std::string_view device_id, AdbCaptureMode mode) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    capture_modes_[std::string(device_id)] = mode;
+}
+
+AdbCaptureMode ADBClient::capture_mode(std::string_view device_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = capture_modes_.find(std::string(device_id));
+    return it != capture_modes_.end() ? it->second : AdbCaptureMode::PNG;
+}
+
+std::map<AdbCaptureMode, AdbCaptureStats> ADBClient::capture_stats(std::string_view device_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = capture_stats_.find(std::string(device_id));
+    return it != capture_stats_.end() ? it->second : std::map<AdbCaptureMode, AdbCaptureStats>{};
+}
+
+void ADBClient::record_capture(std::string_view device_id, AdbCaptureMode mode, const AdbCaptureStats& sample, bool ok) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto& stats = capture_stats_[std::string(device_id)][mode];
+    if (!ok) {
+        stats.failures++;
+        return;
+    }
+    stats.frames++;
+    stats.wire_bytes += sample.wire_bytes;
+    stats.pixel_bytes += sample.pixel_bytes;
+    stats.total_seconds += sample.total_seconds;
+    stats.decode_seconds += sample.decode_seconds;
+}
+
+size_t ADBClient::cached_header_size(std::string_view device_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = screen_geometry_.find(std::string(device_id));
+    return it != screen_geometry_.end() ? it->second.header_size : 0;
+}
+
+void ADBClient::cache_geometry(std::string_view device_id, const AdbRawFrame& frame, size_t header_size) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    screen_geometry_[std::string(device_id)] = {frame.width, frame.height, frame.format, header_size};
+}
+
+std::optional<AdbScreenGeometry> ADBClient::cached_geometry(std::string_view device_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = screen_geometry_.find(std::string(device_id));
+    if (it == screen_geometry_.end()) return std::nullopt;
+    return it->second;
+}
+
+bool ADBClient::capture_rows(std::string_view device_id, const std::vector<AdbRowRange>& rows, AdbRawFrame& frame) {
+    auto geometry = cached_geometry(device_id);
+    bool unsupported = false;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        unsupported = partial_unsupported_.count(std::string(device_id)) > 0;
+    }
+    if (!geometry || unsupported) {
+        // 尚无几何信息（首次截图）或设备不支持局部截取时，整帧截图
+        return capture_raw(device_id, frame, AdbCaptureMode::RAW);
+    }
+
+    frame.width = geometry->width;
+    frame.height = geometry->height;
+    frame.format = geometry->format;
+    size_t row_bytes = frame.row_bytes();
+    if (row_bytes == 0) {
+        return false;
+    }
+
+    // 裁剪到屏幕范围、排序并合并相邻区间（间隔很小时合并比多跑一次 dd 划算）
+    constexpr uint32_t MERGE_GAP_ROWS = 16;
+    std::vector<AdbRowRange> ranges;
+    for (const auto& r : rows) {
+        if (r.first >= frame.height || r.count == 0) continue;
+        ranges.push_back({r.first, std::min(r.count, frame.height - r.first)});
+    }
+    if (ranges.empty()) {
+        return false;
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const AdbRowRange& a, const AdbRowRange& b) {
+        return a.first < b.first;
+    });
+    std::vector<AdbRowRange> merged{ranges.front()};
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        auto& last = merged.back();
+        uint32_t last_end = last.first + last.count;
+        if (ranges[i].first <= last_end + MERGE_GAP_ROWS) {
+            last.count = std::max(last_end, ranges[i].first + ranges[i].count) - last.first;
+        } else {
+            merged.push_back(ranges[i]);
+        }
+    }
+
+    // 单个区间直接从管道截取；多个区间先落到设备临时文件再逐段读取
+    auto dd = [&](std::string_view input, const AdbRowRange& r) {
+        return std::format("dd {}bs=65536 iflag=skip_bytes,count_bytes skip={} count={} 2>/dev/null",
+                           input, geometry->header_size + r.first * row_bytes, r.count * row_bytes);
+    };
+    std::string command;
+    if (merged.size() == 1) {
+        command = std::format("exec-out:screencap | {}", dd("", merged.front()));
+    } else {
+        // 临时文件按调用区分，结束后删除；保留 && 链的退出码
+        std::string tmp = std::format("/data/local/tmp/.abot_partial_{}_{}.raw", ::getpid(), partial_file_seq++);
+        command = std::format("exec-out:screencap {}", tmp);
+        for (const auto& r : merged) {
+            command += std::format(" && {}", dd(std::format("if={} ", tmp), r));
+        }
+        command += std::format("; s=$?; rm -f {}; exit $s", tmp);
+    }
+
+    bool ok = false;
+    bool short_read = false; // 连接正常关闭但数据不足，可能是 dd 不支持或几何信息有误
+    AdbWatchdog watchdog(io_context_, call_deadline(true), call_tokens());
+    try {
+        auto socket = open_service(device_id, command, &watchdog);
+        auto watch = watchdog.watch(socket);
+        frame.pixels.resize(frame.frame_bytes());
+        ok = true;
+        for (const auto& r : merged) {
+            size_t want = r.count * row_bytes;
+            size_t n = read_until_eof(socket, frame.pixels.data() + r.first * row_bytes, want);
+            if (n != want) {
+                ok = false;
+                short_read = true;
+                break;
+            }
+        }
+    } catch (const std::exception&) {
+        ok = false;
+    }
+    finish_call(watchdog, ok ? AdbError::NONE : AdbError::CONNECTION);
+
+    if (ok) {
+        // 缓冲区跨帧复用，区间外的行还是上一帧的内容：清零，避免被当作当前画面读取
+        uint32_t next = 0;
+        for (const auto& r : merged) {
+            std::fill(frame.pixels.begin() + next * row_bytes, frame.pixels.begin() + r.first * row_bytes, 0);
+            next = r.first + r.count;
+        }
+        std::fill(frame.pixels.begin() + next * row_bytes, frame.pixels.end(), 0);
+        frame.valid_rows = std::move(merged);
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        partial_failures_.erase(std::string(device_id));
+        return true;
+    }
+    // 超时或取消不说明几何信息有误，直接失败
+    if (interrupted(last_error())) {
+        return false;
+    }
+
+    // 失败可能是屏幕旋转或分辨率变化：整帧重新获取几何信息。
+    // 若几何信息没变且连续多次短读，说明设备不支持局部截取（如 dd 不支持 skip_bytes），之后直接走整帧；
+    // 连接被重置等异常可能只是偶发，不计数，下次照常尝试局部截取
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        screen_geometry_.erase(std::string(device_id));
+    }
+    if (!capture_raw(device_id, frame, AdbCaptureMode::RAW)) {
+        return false;
+    }
+    if (short_read && frame.width == geometry->width && frame.height == geometry->height) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        if (++partial_failures_[std::string(device_id)] >= PARTIAL_FAILURE_LIMIT) {
+            partial_unsupported_.insert(std::string(device_id));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,203 @@
+#include "../../include/adb/AdbConnectionPool.hpp"
+#include <format>
+#include <memory>
+#include <stdexcept>
+
+using boost::asio::ip::tcp;
+
+AdbConnectionPool::AdbConnectionPool(boost::asio::io_context& io_context,
+                                     size_t spare_per_device,
+                                     std::chrono::seconds max_idle)
+    : io_context_(io_context)
+    , work_guard_(boost::asio::make_work_guard(io_context))
+    , spare_per_device_(spare_per_device)
+    , max_idle_(max_idle)
+{
+    // 后台线程驱动预热握手与协程接口；阻塞接口的读写仍在调用线程同步进行
+    worker_ = std::thread([this] { io_context_.run(); });
+}
+
+AdbConnectionPool::~AdbConnectionPool() {
+    work_guard_.reset();
+    io_context_.stop();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+tcp::resolver::results_type AdbConnectionPool::resolve(std::string_view host, std::string_view port) {
+    std::string key = std::format("{}:{}", host, port);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = endpoints_.find(key);
+        if (it != endpoints_.end()) {
+            stats_.endpoint_hits++;
+            return it->second;
+        }
+        stats_.endpoint_misses++;
+    }
+    // 解析可能阻塞较久，不持锁进行，避免卡住其他设备的取连接；每次用独立的 resolver，可并发调用
+    tcp::resolver resolver(io_context_);
+    auto endpoints = resolver.resolve(host, port);
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoints_.emplace(std::move(key), endpoints);
+    return endpoints;
+}
+
+boost::asio::awaitable<tcp::resolver::results_type> AdbConnectionPool::async_resolve(std::string host, std::string port) {
+    std::string key = std::format("{}:{}", host, port);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = endpoints_.find(key);
+        if (it != endpoints_.end()) {
+            stats_.endpoint_hits++;
+            co_return it->second;
+        }
+        stats_.endpoint_misses++;
+    }
+    tcp::resolver resolver(io_context_);
+    auto endpoints = co_await resolver.async_resolve(host, port, boost::asio::use_awaitable);
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoints_.emplace(std::move(key), endpoints);
+    co_return endpoints;
+}
+
+tcp::socket AdbConnectionPool::connect(std::string_view host, std::string_view port) {
+    tcp::socket socket(io_context_);
+    boost::asio::connect(socket, resolve(host, port));
+    socket.set_option(tcp::no_delay(true));
+    return socket;
+}
+
+tcp::socket AdbConnectionPool::handshake(std::string_view device_id, std::string_view host, std::string_view port) {
+    auto socket = connect(host, port);
+    request_transport(socket, device_id);
+    return socket;
+}
+
+void AdbConnectionPool::request_transport(tcp::socket& socket, std::string_view device_id) {
+    std::string transport_cmd = std::format("host:transport:{}", device_id);
+    std::string request = std::format("{:04x}{}", transport_cmd.length(), transport_cmd);
+    boost::asio::write(socket, boost::asio::buffer(request));
+
+    char status[4];
+    boost::asio::read(socket, boost::asio::buffer(status, 4));
+    if (std::string_view(status, 4) != "OKAY") {
+        throw std::runtime_error(std::format("host:transport:{} 失败", device_id));
+    }
+}
+
+bool AdbConnectionPool::is_alive(tcp::socket& socket) {
+    // 非阻塞 peek：would_block 说明连接仍在且没有多余数据
+    boost::system::error_code ec;
+    socket.non_blocking(true, ec);
+    if (ec) return false;
+    char probe;
+    socket.receive(boost::asio::buffer(&probe, 1), tcp::socket::message_peek, ec);
+    bool alive = (ec == boost::asio::error::would_block);
+    socket.non_blocking(false, ec);
+    return alive && !ec;
+}
+
+std::optional<tcp::socket> AdbConnectionPool::try_acquire(std::string_view device_id, std::string_view host, std::string_view port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& pool = devices_[std::string(device_id)];
+    pool.host = host;
+    pool.port = port;
+
+    auto now = std::chrono::steady_clock::now();
+    while (!pool.idle.empty()) {
+        IdleSocket entry = std::move(pool.idle.front());
+        pool.idle.pop_front();
+        if (now - entry.since > max_idle_ || !is_alive(entry.socket)) {
+            stats_.stale_dropped++;
+            continue;
+        }
+        stats_.transport_hits++;
+        schedule_warmup(std::string(device_id), pool);
+        return std::move(entry.socket);
+    }
+    stats_.transport_misses++;
+    schedule_warmup(std::string(device_id), pool);
+    return std::nullopt;
+}
+
+tcp::socket AdbConnectionPool::acquire_transport(std::string_view device_id, std::string_view host, std::string_view port) {
+    if (auto socket = try_acquire(device_id, host, port)) {
+        return std::move(*socket);
+    }
+    // 未命中：在调用线程同步握手，不持锁
+    return handshake(device_id, host, port);
+}
+
+void AdbConnectionPool::schedule_warmup(const std::string& device_id, DevicePool& pool) {
+    while (pool.idle.size() + pool.warming < spare_per_device_) {
+        pool.warming++;
+
+        struct WarmupState {
+            tcp::socket socket;
+            std::string device_id;
+            std::string request;
+            uint64_t generation;
+            char status[4];
+        };
+        std::string transport_cmd = std::format("host:transport:{}", device_id);
+        auto state = std::make_shared<WarmupState>(WarmupState{
+            tcp::socket(io_context_),
+            device_id,
+            std::format("{:04x}{}", transport_cmd.length(), transport_cmd),
+            pool.generation,
+            {}
+        });
+
+        auto finish = [this, state](bool ok) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = devices_.find(state->device_id);
+            if (it == devices_.end()) return;
+            auto& device_pool = it->second;
+            if (device_pool.warming > 0) device_pool.warming--;
+            if (ok && state->generation == device_pool.generation) {
+                device_pool.idle.push_back({std::move(state->socket), std::chrono::steady_clock::now()});
+                stats_.warmed++;
+            }
+        };
+
+        tcp::resolver::results_type endpoints;
+        auto ep = endpoints_.find(std::format("{}:{}", pool.host, pool.port));
+        if (ep == endpoints_.end()) {
+            // 端点尚未解析过（首次命令会在调用线程解析），本次不预热
+            pool.warming--;
+            return;
+        }
+        endpoints = ep->second;
+
+        boost::asio::async_connect(state->socket, endpoints,
+            [state, finish](const boost::system::error_code& ec, const tcp::endpoint&) {
+                if (ec) return finish(false);
+                boost::system::error_code opt_ec;
+                state->socket.set_option(tcp::no_delay(true), opt_ec);
+                boost::asio::async_write(state->socket, boost::asio::buffer(state->request),
+                    [state, finish](const boost::system::error_code& ec, size_t) {
+                        if (ec) return finish(false);
+                        boost::asio::async_read(state->socket, boost::asio::buffer(state->status, 4),
+                            [state, finish](const boost::system::error_code& ec, size_t) {
+                                finish(!ec && std::string_view(state->status, 4) == "OKAY");
+                            });
+                    });
+            });
+    }
+}
+
+void AdbConnectionPool::invalidate(std::string_view device_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = devices_.find(std::string(device_id));
+    if (it == devices_.end()) return;
+    stats_.stale_dropped += it->second.idle.size();
+    it->second.idle.clear();
+    it->second.generation++;
+}
+
+AdbPoolStats AdbConnectionPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
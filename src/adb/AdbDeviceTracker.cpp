@@ -0,0 +1,260 @@
+#include "../../include/adb/AdbDeviceTracker.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+
+using boost::asio::awaitable;
+using boost::asio::use_awaitable;
+using boost::asio::ip::tcp;
+
+namespace {
+
+// 重连退避：首次 200 ms，逐次翻倍，上限 5 s
+constexpr auto RETRY_INITIAL = std::chrono::milliseconds(200);
+constexpr auto RETRY_MAX = std::chrono::milliseconds(5000);
+
+// 读取一条 4 位十六进制长度前缀的消息
+awaitable<std::string> read_message(tcp::socket& socket) {
+    char length_hex[4];
+    co_await boost::asio::async_read(socket, boost::asio::buffer(length_hex, 4), use_awaitable);
+    size_t length = 0;
+    auto [ptr, ec] = std::from_chars(length_hex, length_hex + 4, length, 16);
+    if (ec != std::errc() || ptr != length_hex + 4) {
+        throw std::runtime_error("track-devices 消息长度无效");
+    }
+    std::string payload(length, '\0');
+    if (length > 0) {
+        co_await boost::asio::async_read(socket, boost::asio::buffer(payload.data(), length), use_awaitable);
+    }
+    co_return payload;
+}
+
+// 发送请求并读取 OKAY/FAIL，FAIL 时返回 false
+awaitable<bool> request(tcp::socket& socket, std::string command) {
+    std::string data = std::format("{:04x}{}", command.length(), command);
+    co_await boost::asio::async_write(socket, boost::asio::buffer(data), use_awaitable);
+    char status[4];
+    co_await boost::asio::async_read(socket, boost::asio::buffer(status, 4), use_awaitable);
+    if (std::string_view(status, 4) == "OKAY") co_return true;
+    // FAIL 后跟一条错误消息，这里不关心内容
+    co_await read_message(socket);
+    co_return false;
+}
+
+} // namespace
+
+AdbDeviceTracker::AdbDeviceTracker(std::string host, std::string port)
+    : host_(std::move(host))
+    , port_(std::move(port))
+    , io_context_()
+    , retry_timer_(io_context_)
+    , table_(std::make_shared<const AdbDeviceTable>())
+{
+}
+
+AdbDeviceTracker::~AdbDeviceTracker() {
+    stop();
+}
+
+void AdbDeviceTracker::start() {
+    if (started_) return;
+    started_ = true;
+    io_context_.restart();
+    boost::asio::co_spawn(io_context_, run(), boost::asio::detached);
+    worker_ = std::thread([this] { io_context_.run(); });
+}
+
+void AdbDeviceTracker::stop() {
+    if (!started_) return;
+    // 在跟踪线程上取消连接与重连定时器，协程退出后 run() 自然返回
+    boost::asio::post(io_context_, [this] {
+        stopping_ = true;
+        retry_timer_.cancel();
+        if (socket_) {
+            boost::system::error_code ec;
+            socket_->cancel(ec);
+            socket_->close(ec);
+        }
+    });
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    started_ = false;
+    stopping_ = false;
+    connected_.store(false, std::memory_order_release);
+}
+
+uint64_t AdbDeviceTracker::subscribe(AdbDeviceCallback callback) {
+    std::lock_guard<std::mutex> lock(subscriber_mutex_);
+    uint64_t id = next_id_++;
+    subscribers_.emplace(id, std::make_shared<AdbDeviceCallback>(std::move(callback)));
+    return id;
+}
+
+void AdbDeviceTracker::unsubscribe(uint64_t id) {
+    {
+        std::lock_guard<std::mutex> lock(subscriber_mutex_);
+        subscribers_.erase(id);
+    }
+    // 等待正在进行的一轮回调结束（在回调内调用时为重入，直接通过）
+    std::lock_guard<std::recursive_mutex> wait(callback_mutex_);
+}
+
+AdbDeviceTable AdbDeviceTracker::parse_device_table(std::string_view payload) {
+    // devices:    "<serial>\t<state>"
+    // devices -l: "<serial> <空格对齐> <state> [usb:..] product:.. model:.. device:.. transport_id:N"
+    AdbDeviceTable table;
+    std::istringstream iss{std::string(payload)};
+    std::string line;
+    while (std::getline(iss, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        AdbDeviceInfo info;
+        std::string_view rest;
+        auto tab = line.find('\t');
+        if (tab != std::string::npos) {
+            info.serial = line.substr(0, tab);
+            rest = std::string_view(line).substr(tab + 1);
+        } else {
+            auto space = line.find(' ');
+            if (space == std::string::npos) continue;
+            info.serial = line.substr(0, space);
+            rest = std::string_view(line).substr(space);
+        }
+        if (info.serial.empty()) continue;
+
+        auto start = rest.find_first_not_of(' ');
+        if (start == std::string_view::npos) continue;
+        rest.remove_prefix(start);
+        // "no permissions" 含空格，其后还跟着说明文字
+        if (rest.starts_with("no permissions")) {
+            info.status = AdbDeviceStatus::NO_PERMISSIONS;
+            table[info.serial] = std::move(info);
+            continue;
+        }
+        auto end = rest.find(' ');
+        info.status = stringToAdbDeviceStatus(rest.substr(0, end));
+
+        while (end != std::string_view::npos) {
+            rest.remove_prefix(end + 1);
+            end = rest.find(' ');
+            std::string_view field = rest.substr(0, end);
+            auto colon = field.find(':');
+            if (colon == std::string_view::npos) continue;
+            std::string_view key = field.substr(0, colon);
+            std::string_view value = field.substr(colon + 1);
+            if (key == "product") info.product = value;
+            else if (key == "model") info.model = value;
+            else if (key == "device") info.device = value;
+            else if (key == "transport_id") std::from_chars(value.data(), value.data() + value.size(), info.transport_id);
+        }
+        table[info.serial] = std::move(info);
+    }
+    return table;
+}
+
+void AdbDeviceTracker::apply(AdbDeviceTable table) {
+    auto next = std::make_shared<const AdbDeviceTable>(std::move(table));
+    auto previous = table_.exchange(next, std::memory_order_acq_rel);
+    updates_.fetch_add(1, std::memory_order_relaxed);
+
+    // 两个有序表归并比较，得到新增、移除与状态变化
+    std::vector<AdbDeviceEvent> events;
+    auto old_it = previous->begin();
+    auto new_it = next->begin();
+    while (old_it != previous->end() || new_it != next->end()) {
+        if (new_it == next->end() || (old_it != previous->end() && old_it->first < new_it->first)) {
+            events.push_back({old_it->first, old_it->second.status, std::nullopt, old_it->second});
+            ++old_it;
+        } else if (old_it == previous->end() || new_it->first < old_it->first) {
+            events.push_back({new_it->first, std::nullopt, new_it->second.status, new_it->second});
+            ++new_it;
+        } else {
+            // transport_id 变化说明设备断开后又重新连上，即使两次推送间状态相同也需要通知
+            if (old_it->second.status != new_it->second.status ||
+                old_it->second.transport_id != new_it->second.transport_id) {
+                events.push_back({new_it->first, old_it->second.status, new_it->second.status, new_it->second});
+            }
+            ++old_it;
+            ++new_it;
+        }
+    }
+    if (events.empty()) return;
+
+    std::lock_guard<std::recursive_mutex> guard(callback_mutex_);
+    std::vector<std::pair<uint64_t, std::shared_ptr<AdbDeviceCallback>>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(subscriber_mutex_);
+        callbacks.assign(subscribers_.begin(), subscribers_.end());
+    }
+    for (const auto& event : events) {
+        for (const auto& [id, callback] : callbacks) {
+            {
+                // 前一个回调中可能取消了后面的订阅
+                std::lock_guard<std::mutex> lock(subscriber_mutex_);
+                if (!subscribers_.contains(id)) continue;
+            }
+            try {
+                (*callback)(event);
+            } catch (const std::exception&) {
+                // 回调异常不影响跟踪
+            }
+        }
+    }
+}
+
+awaitable<void> AdbDeviceTracker::track_once() {
+    tcp::resolver resolver(io_context_);
+    auto endpoints = co_await resolver.async_resolve(host_, port_, use_awaitable);
+    if (stopping_) co_return;
+    socket_.emplace(io_context_);
+    co_await boost::asio::async_connect(*socket_, endpoints, use_awaitable);
+    socket_->set_option(tcp::no_delay(true));
+
+    // 旧版 ADB Server 不支持 -l，退回短格式
+    // 参数先绑定到具名变量：GCC 12 对 co_await 表达式中的临时对象处理有误
+    std::string long_format = "host:track-devices-l";
+    if (!co_await request(*socket_, long_format)) {
+        std::string short_format = "host:track-devices";
+        socket_.emplace(io_context_);
+        co_await boost::asio::async_connect(*socket_, endpoints, use_awaitable);
+        if (!co_await request(*socket_, short_format)) {
+            throw std::runtime_error("ADB Server 不支持 track-devices");
+        }
+    }
+
+    // 每条推送都是完整的设备列表，连接建立后立即推送一次
+    while (!stopping_) {
+        std::string payload = co_await read_message(*socket_);
+        connected_.store(true, std::memory_order_release);
+        apply(parse_device_table(payload));
+    }
+}
+
+awaitable<void> AdbDeviceTracker::run() {
+    auto delay = std::chrono::milliseconds(RETRY_INITIAL);
+    while (!stopping_) {
+        try {
+            co_await track_once();
+        } catch (const std::exception&) {
+            // 连接失败或断开，下面统一处理
+        }
+        socket_.reset();
+        if (stopping_) break;
+
+        // 成功收到过推送说明是连接中途断开，从头开始退避
+        if (connected_.exchange(false, std::memory_order_acq_rel)) {
+            delay = RETRY_INITIAL;
+        }
+        // 与 ADB Server 失联：设备均不可达，清空设备表并通知
+        if (!table_.load(std::memory_order_acquire)->empty()) {
+            apply({});
+        }
+        retry_timer_.expires_after(delay);
+        boost::system::error_code ec;
+        co_await retry_timer_.async_wait(boost::asio::redirect_error(use_awaitable, ec));
+        delay = std::min<std::chrono::milliseconds>(delay * 2, RETRY_MAX);
+    }
+}
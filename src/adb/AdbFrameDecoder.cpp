@@ -0,0 +1,250 @@
+#include "../../include/adb/AdbFrameDecoder.hpp"
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+
+// 头部尺寸合法性上限，防止异常数据触发超大分配
+constexpr uint32_t ADB_MAX_FRAME_SIDE = 16384;
+
+// screencap 原始头部：width, height, format，Android 9 起追加 colorspace
+constexpr size_t SCREENCAP_BASE_HEADER = 12;
+
+// gzip 输入分块大小
+constexpr size_t GZIP_INPUT_CHUNK = 64 * 1024;
+
+uint32_t get_le32(const uint8_t* src) {
+    return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8) |
+           (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+}
+
+// screencap 原始输出：头部 + 像素，像素直接读入帧缓冲
+class ScreencapRawDecoder : public AdbFrameDecoder {
+public:
+    ScreencapRawDecoder(AdbRawFrame& frame, size_t known_header_size)
+        : frame_(frame)
+        , known_header_(known_header_size)
+        , header_target_(known_header_size != 0 ? known_header_size : SCREENCAP_BASE_HEADER) {}
+
+    boost::asio::mutable_buffer prepare() override {
+        if (!in_pixels_) {
+            return boost::asio::buffer(header_ + header_got_, header_target_ - header_got_);
+        }
+        if (pixel_got_ < pixel_target_) {
+            return boost::asio::buffer(frame_.pixels.data() + pixel_got_, pixel_target_ - pixel_got_);
+        }
+        // 像素已满，若还有数据说明多于头部声明
+        return boost::asio::buffer(overflow_, sizeof(overflow_));
+    }
+
+    bool commit(size_t n) override {
+        wire_bytes_ += n;
+        if (!in_pixels_) {
+            header_got_ += n;
+            if (header_got_ < header_target_) return true;
+            frame_.width = get_le32(header_);
+            frame_.height = get_le32(header_ + 4);
+            frame_.format = static_cast<AdbPixelFormat>(get_le32(header_ + 8));
+            if (frame_.width > ADB_MAX_FRAME_SIDE || frame_.height > ADB_MAX_FRAME_SIDE) return false;
+            frame_bytes_ = frame_.frame_bytes();
+            if (frame_bytes_ == 0) return false;
+            // 头部长度未知：多留 4 字节，结束时按实际长度判断是否带 colorspace
+            pixel_target_ = known_header_ != 0 ? frame_bytes_ : frame_bytes_ + 4;
+            frame_.pixels.resize(pixel_target_);
+            in_pixels_ = true;
+            return true;
+        }
+        if (pixel_got_ >= pixel_target_) return false;
+        pixel_got_ += n;
+        return true;
+    }
+
+    bool finish() override {
+        if (!in_pixels_) return false;
+        if (known_header_ != 0) {
+            header_size_ = known_header_;
+            return pixel_got_ == frame_bytes_;
+        }
+        header_size_ = SCREENCAP_BASE_HEADER;
+        if (pixel_got_ == frame_bytes_ + 4) {
+            header_size_ += 4;
+            std::memmove(frame_.pixels.data(), frame_.pixels.data() + 4, frame_bytes_);
+        } else if (pixel_got_ != frame_bytes_) {
+            return false;
+        }
+        frame_.pixels.resize(frame_bytes_);
+        return true;
+    }
+
+private:
+    AdbRawFrame& frame_;
+    size_t known_header_;
+    uint8_t header_[SCREENCAP_BASE_HEADER + 4];
+    size_t header_target_;
+    size_t header_got_ = 0;
+    bool in_pixels_ = false;
+    size_t frame_bytes_ = 0;
+    size_t pixel_target_ = 0;
+    size_t pixel_got_ = 0;
+    uint8_t overflow_[1];
+};
+
+// gzip 压缩的 screencap 输出：边收边解压，解压结果交给原始解码器写入帧缓冲
+class ScreencapGzipDecoder : public AdbFrameDecoder {
+public:
+    ScreencapGzipDecoder(AdbRawFrame& frame, size_t known_header_size)
+        : inner_(frame, known_header_size)
+        , input_(GZIP_INPUT_CHUNK) {
+        // 16 + MAX_WBITS：按 gzip 格式解析
+        ok_ = inflateInit2(&zs_, 16 + MAX_WBITS) == Z_OK;
+    }
+
+    ~ScreencapGzipDecoder() override {
+        if (ok_) inflateEnd(&zs_);
+    }
+
+    boost::asio::mutable_buffer prepare() override {
+        return boost::asio::buffer(input_.data(), input_.size());
+    }
+
+    bool commit(size_t n) override {
+        if (!ok_) return false;
+        wire_bytes_ += n;
+        if (stream_end_) return true; // 忽略 gzip 流之后的多余数据
+
+        auto start = std::chrono::steady_clock::now();
+        zs_.next_in = input_.data();
+        zs_.avail_in = static_cast<uInt>(n);
+        bool ok = true;
+        while (true) {
+            auto out = inner_.prepare();
+            zs_.next_out = static_cast<Bytef*>(out.data());
+            zs_.avail_out = static_cast<uInt>(out.size());
+            int ret = inflate(&zs_, Z_NO_FLUSH);
+            size_t produced = out.size() - zs_.avail_out;
+            if (produced > 0 && !inner_.commit(produced)) {
+                ok = false;
+                break;
+            }
+            if (ret == Z_STREAM_END) {
+                stream_end_ = true;
+                break;
+            }
+            if (ret == Z_BUF_ERROR) break; // 需要更多输入
+            if (ret != Z_OK) {
+                ok = false;
+                break;
+            }
+            // 输入耗尽且输出未写满，说明没有待输出数据
+            if (zs_.avail_in == 0 && zs_.avail_out > 0) break;
+        }
+        decode_time_ += std::chrono::steady_clock::now() - start;
+        return ok;
+    }
+
+    bool finish() override {
+        bool ok = ok_ && stream_end_ && inner_.finish();
+        header_size_ = inner_.header_size();
+        return ok;
+    }
+
+private:
+    ScreencapRawDecoder inner_;
+    std::vector<uint8_t> input_;
+    z_stream zs_{};
+    bool ok_ = false;
+    bool stream_end_ = false;
+};
+
+// framebuffer: 服务输出：version + 头部字段 + 像素
+class FramebufferDecoder : public AdbFrameDecoder {
+public:
+    explicit FramebufferDecoder(AdbRawFrame& frame) : frame_(frame) {}
+
+    boost::asio::mutable_buffer prepare() override {
+        if (!in_pixels_) {
+            return boost::asio::buffer(header_ + header_got_, header_target_ - header_got_);
+        }
+        if (pixel_got_ < frame_bytes_) {
+            return boost::asio::buffer(frame_.pixels.data() + pixel_got_, frame_bytes_ - pixel_got_);
+        }
+        return boost::asio::buffer(overflow_, sizeof(overflow_));
+    }
+
+    bool commit(size_t n) override {
+        wire_bytes_ += n;
+        if (in_pixels_) {
+            if (pixel_got_ >= frame_bytes_) return false;
+            pixel_got_ += n;
+            return true;
+        }
+        header_got_ += n;
+        if (header_got_ < header_target_) return true;
+        if (header_target_ == 4) {
+            // v1: bpp, size, width, height, 4 组 (offset, length)；v2 在 bpp 后多一个 colorspace
+            version_ = get_le32(header_);
+            header_target_ = 4 + (version_ == 2 ? 13 : 12) * 4;
+            return true;
+        }
+        const uint8_t* p = header_ + 4;
+        uint32_t bpp = get_le32(p); p += 4;
+        if (version_ == 2) p += 4;
+        uint32_t size = get_le32(p); p += 4;
+        frame_.width = get_le32(p); p += 4;
+        frame_.height = get_le32(p); p += 4;
+        uint32_t red_offset = get_le32(p);
+        switch (bpp) {
+            case 32: frame_.format = red_offset == 0 ? AdbPixelFormat::RGBA_8888 : AdbPixelFormat::BGRA_8888; break;
+            case 24: frame_.format = AdbPixelFormat::RGB_888; break;
+            case 16: frame_.format = AdbPixelFormat::RGB_565; break;
+            default: return false;
+        }
+        if (frame_.width > ADB_MAX_FRAME_SIDE || frame_.height > ADB_MAX_FRAME_SIDE || size != frame_.frame_bytes()) {
+            return false;
+        }
+        frame_bytes_ = size;
+        frame_.pixels.resize(size);
+        in_pixels_ = true;
+        return true;
+    }
+
+    bool finish() override {
+        return in_pixels_ && pixel_got_ == frame_bytes_;
+    }
+
+private:
+    AdbRawFrame& frame_;
+    uint8_t header_[4 + 13 * 4];
+    size_t header_target_ = 4;
+    size_t header_got_ = 0;
+    uint32_t version_ = 0;
+    bool in_pixels_ = false;
+    size_t frame_bytes_ = 0;
+    size_t pixel_got_ = 0;
+    uint8_t overflow_[1];
+};
+
+} // namespace
+
+std::unique_ptr<AdbFrameDecoder> AdbFrameDecoder::create(AdbCaptureMode mode, AdbRawFrame& frame, size_t known_header_size) {
+    switch (mode) {
+        case AdbCaptureMode::RAW:
+            return std::make_unique<ScreencapRawDecoder>(frame, known_header_size);
+        case AdbCaptureMode::GZIP_RAW:
+            return std::make_unique<ScreencapGzipDecoder>(frame, known_header_size);
+        case AdbCaptureMode::FRAMEBUFFER:
+            return std::make_unique<FramebufferDecoder>(frame);
+        default:
+            return nullptr;
+    }
+}
+
+const char* AdbFrameDecoder::service(AdbCaptureMode mode) {
+    switch (mode) {
+        case AdbCaptureMode::RAW: return "exec-out:screencap";
+        case AdbCaptureMode::GZIP_RAW: return "exec-out:screencap | gzip -1";
+        case AdbCaptureMode::FRAMEBUFFER: return "framebuffer:";
+        case AdbCaptureMode::PNG: return "exec-out:screencap -p";
+    }
+    return "";
+}
@@ -0,0 +1,182 @@
+#include "../../include/adb/AdbShellSession.hpp"
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <random>
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+// 读缓冲区大小
+constexpr size_t SHELL_READ_CHUNK = 16 * 1024;
+
+void put_le32(char* dst, uint32_t value) {
+    dst[0] = static_cast<char>(value & 0xff);
+    dst[1] = static_cast<char>((value >> 8) & 0xff);
+    dst[2] = static_cast<char>((value >> 16) & 0xff);
+    dst[3] = static_cast<char>((value >> 24) & 0xff);
+}
+
+uint32_t get_le32(const char* src) {
+    auto b = reinterpret_cast<const unsigned char*>(src);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+} // namespace
+
+AdbShellSession::AdbShellSession(tcp::socket socket, bool shell_v2)
+    : socket_(std::move(socket))
+    , shell_v2_(shell_v2)
+    , nonce_(std::random_device{}())
+{
+    buffer_.resize(SHELL_READ_CHUNK);
+    if (!shell_v2_) {
+        // exec: 只有一路输出，标准错误并入标准输出
+        try {
+            write_stdin("exec 2>&1\n");
+        } catch (const std::exception&) {
+            alive_ = false;
+        }
+    }
+}
+
+AdbShellSession::~AdbShellSession() {
+    close();
+}
+
+void AdbShellSession::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!socket_.is_open()) return;
+    boost::system::error_code ec;
+    if (alive_ && shell_v2_) {
+        char packet[5] = {static_cast<char>(CLOSE_STDIN), 0, 0, 0, 0};
+        boost::asio::write(socket_, boost::asio::buffer(packet, 5), ec);
+    }
+    socket_.shutdown(tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+    alive_ = false;
+}
+
+void AdbShellSession::interrupt() {
+    // 不取 mutex_：run() 正持有它阻塞在读上，shutdown 让读立即返回
+    boost::system::error_code ec;
+    socket_.shutdown(tcp::socket::shutdown_both, ec);
+}
+
+bool AdbShellSession::alive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!alive_ || !socket_.is_open()) return false;
+    // 非阻塞 peek：would_block（无数据）或读到数据都说明连接仍在
+    boost::system::error_code ec;
+    socket_.non_blocking(true, ec);
+    if (ec) {
+        alive_ = false;
+        return false;
+    }
+    char probe;
+    size_t n = socket_.receive(boost::asio::buffer(&probe, 1), tcp::socket::message_peek, ec);
+    alive_ = (ec == boost::asio::error::would_block) || (!ec && n > 0);
+    socket_.non_blocking(false, ec);
+    return alive_;
+}
+
+void AdbShellSession::write_stdin(std::string_view data) {
+    if (!shell_v2_) {
+        boost::asio::write(socket_, boost::asio::buffer(data.data(), data.size()));
+        return;
+    }
+    char header[5];
+    header[0] = static_cast<char>(STDIN);
+    put_le32(header + 1, static_cast<uint32_t>(data.size()));
+    std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(header, 5),
+        boost::asio::buffer(data.data(), data.size())
+    };
+    boost::asio::write(socket_, buffers);
+}
+
+bool AdbShellSession::read_more() {
+    if (!shell_v2_) {
+        boost::system::error_code ec;
+        size_t n = socket_.read_some(boost::asio::buffer(buffer_), ec);
+        out_.append(buffer_.data(), n);
+        return !ec;
+    }
+
+    char header[5];
+    boost::system::error_code ec;
+    boost::asio::read(socket_, boost::asio::buffer(header, 5), ec);
+    if (ec) return false;
+    uint32_t length = get_le32(header + 1);
+    if (length > buffer_.size()) {
+        buffer_.resize(length);
+    }
+    boost::asio::read(socket_, boost::asio::buffer(buffer_.data(), length), ec);
+    if (ec) return false;
+
+    switch (static_cast<uint8_t>(header[0])) {
+        case STDOUT: out_.append(buffer_.data(), length); return true;
+        case STDERR: err_.append(buffer_.data(), length); return true;
+        case EXIT: return false; // shell 进程已退出
+        default: return true;    // 忽略其他类型
+    }
+}
+
+bool AdbShellSession::take_until_marker(std::string& buffer, std::string_view marker, std::string& before, int* exit_code) {
+    size_t pos = buffer.find(marker);
+    if (pos == std::string::npos) return false;
+    size_t eol = buffer.find('\n', pos + marker.size());
+    if (eol == std::string::npos) return false;
+    if (exit_code) {
+        const char* first = buffer.data() + pos + marker.size();
+        std::from_chars(first, buffer.data() + eol, *exit_code);
+    }
+    before.assign(buffer, 0, pos);
+    buffer.erase(0, eol + 1);
+    return true;
+}
+
+AdbShellResult AdbShellSession::run(std::string_view command) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AdbShellResult result;
+    if (!alive_) return result;
+    if (command.find_first_not_of(" \t\r\n") == std::string_view::npos) {
+        result.ok = true;
+        result.exit_code = 0;
+        return result;
+    }
+
+    std::string marker = std::format("__ABOT_{:08x}_{}__", nonce_, sequence_++);
+    // 命令放在 { } 中整体重定向 stdin；标准错误也写一次标记，确保该命令的 stderr 已全部读到
+    std::string script = std::format("{{ {}\n}} </dev/null\necho {}$?\n", command, marker);
+    if (shell_v2_) {
+        script += std::format("echo {} >&2\n", marker);
+    }
+
+    try {
+        write_stdin(script);
+    } catch (const std::exception&) {
+        alive_ = false;
+        return result;
+    }
+
+    bool out_done = false;
+    bool err_done = !shell_v2_;
+    while (true) {
+        out_done = out_done || take_until_marker(out_, marker, result.out, &result.exit_code);
+        err_done = err_done || take_until_marker(err_, marker, result.err, nullptr);
+        if (out_done && err_done) break;
+        if (!read_more()) {
+            // 会话中途结束（命令中有 exit 或语法错误等），返回已收到的部分输出
+            alive_ = false;
+            if (!out_done) result.out = std::move(out_);
+            if (!err_done) result.err = std::move(err_);
+            return result;
+        }
+    }
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,91 @@
+#include "../../include/adb/AdbShellStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+using boost::asio::ip::tcp;
+
+AdbShellStream::AdbShellStream(tcp::socket socket, size_t buffer_size)
+    : socket_(std::move(socket))
+    , buffer_(std::max<size_t>(buffer_size, 256))
+{
+}
+
+AdbShellStream::~AdbShellStream() {
+    close();
+}
+
+void AdbShellStream::close() {
+    // 不释放 socket_：看门狗线程可能同时调用 interrupt()
+    if (!socket_ || closed_) return;
+    boost::system::error_code ec;
+    socket_->shutdown(tcp::socket::shutdown_both, ec);
+    socket_->close(ec);
+    closed_ = true;
+    eof_ = true;
+    begin_ = end_ = 0;
+}
+
+void AdbShellStream::interrupt() {
+    if (!socket_) return;
+    boost::system::error_code ec;
+    socket_->shutdown(tcp::socket::shutdown_both, ec);
+}
+
+bool AdbShellStream::fill() {
+    if (!socket_ || eof_ || error_) return false;
+    // 已消费的部分移到缓冲区开头，腾出尾部空间
+    if (begin_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    if (end_ == buffer_.size()) return true;
+
+    boost::system::error_code ec;
+    size_t n = socket_->read_some(boost::asio::buffer(buffer_.data() + end_, buffer_.size() - end_), ec);
+    end_ += n;
+    if (ec == boost::asio::error::eof) {
+        eof_ = true;
+    } else if (ec) {
+        error_ = true;
+    }
+    return n > 0;
+}
+
+bool AdbShellStream::next_chunk(std::string_view& chunk) {
+    if (begin_ == end_) {
+        begin_ = end_ = 0;
+        if (!fill()) return false;
+    }
+    chunk = std::string_view(buffer_.data() + begin_, end_ - begin_);
+    begin_ = end_;
+    return true;
+}
+
+bool AdbShellStream::next_line(std::string_view& line) {
+    while (true) {
+        const char* data = buffer_.data();
+        auto newline = std::find(data + begin_, data + end_, '\n');
+        size_t length = 0;
+        size_t consumed = 0;
+        if (newline != data + end_) {
+            length = newline - (data + begin_);
+            consumed = length + 1;
+        } else if ((begin_ == 0 && end_ == buffer_.size()) || ((eof_ || error_) && begin_ < end_)) {
+            // 缓冲区已满仍无换行，或流结束时的最后一行（无换行结尾）
+            length = end_ - begin_;
+            consumed = length;
+        } else {
+            if (!fill() && begin_ == end_) return false;
+            continue;
+        }
+
+        // pty 输出的行尾为 \r\n
+        if (length > 0 && data[begin_ + length - 1] == '\r') {
+            length--;
+        }
+        line = std::string_view(data + begin_, length);
+        begin_ += consumed;
+        return true;
+    }
+}
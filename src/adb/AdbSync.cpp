@@ -0,0 +1,158 @@
+#include "../../include/adb/AdbSync.hpp"
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+namespace {
+
+// sync 协议中的整数均为小端序
+void put_le32(char* dst, uint32_t value) {
+    dst[0] = static_cast<char>(value & 0xff);
+    dst[1] = static_cast<char>((value >> 8) & 0xff);
+    dst[2] = static_cast<char>((value >> 16) & 0xff);
+    dst[3] = static_cast<char>((value >> 24) & 0xff);
+}
+
+uint32_t get_le32(const char* src) {
+    auto b = reinterpret_cast<const unsigned char*>(src);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+} // namespace
+
+AdbSyncConnection::AdbSyncConnection(boost::asio::ip::tcp::socket socket)
+    : socket_(std::move(socket))
+{
+    buffer_.resize(ADB_SYNC_MAX_CHUNK);
+}
+
+AdbSyncConnection::~AdbSyncConnection() {
+    if (!closed_) {
+        try {
+            quit();
+        } catch (const std::exception&) {
+            // 连接已损坏，直接关闭
+        }
+    }
+}
+
+void AdbSyncConnection::write_header(std::string_view id, uint32_t value) {
+    char header[8];
+    std::memcpy(header, id.data(), 4);
+    put_le32(header + 4, value);
+    boost::asio::write(socket_, boost::asio::buffer(header, 8));
+}
+
+void AdbSyncConnection::write_request(std::string_view id, std::string_view payload) {
+    char header[8];
+    std::memcpy(header, id.data(), 4);
+    put_le32(header + 4, static_cast<uint32_t>(payload.size()));
+    std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(header, 8),
+        boost::asio::buffer(payload.data(), payload.size())
+    };
+    boost::asio::write(socket_, buffers);
+}
+
+void AdbSyncConnection::read_header(char id[4], uint32_t& value) {
+    char header[8];
+    boost::asio::read(socket_, boost::asio::buffer(header, 8));
+    std::memcpy(id, header, 4);
+    value = get_le32(header + 4);
+}
+
+std::string AdbSyncConnection::read_fail_message(uint32_t length) {
+    std::string message(length, '\0');
+    boost::asio::read(socket_, boost::asio::buffer(message.data(), length));
+    return message;
+}
+
+AdbFileStat AdbSyncConnection::stat(std::string_view remote_path) {
+    write_request("STAT", remote_path);
+
+    char reply[16];
+    boost::asio::read(socket_, boost::asio::buffer(reply, 16));
+    if (std::string_view(reply, 4) != "STAT") {
+        throw std::runtime_error("sync STAT 响应无效");
+    }
+    AdbFileStat st;
+    st.mode = get_le32(reply + 4);
+    st.size = get_le32(reply + 8);
+    st.mtime = get_le32(reply + 12);
+    return st;
+}
+
+uint64_t AdbSyncConnection::recv(std::string_view remote_path, std::ostream& out) {
+    write_request("RECV", remote_path);
+
+    uint64_t total = 0;
+    char id[4];
+    uint32_t length = 0;
+    while (true) {
+        read_header(id, length);
+        std::string_view tag(id, 4);
+        if (tag == "DATA") {
+            if (length > ADB_SYNC_MAX_CHUNK) {
+                throw std::runtime_error("sync DATA 分块超长");
+            }
+            boost::asio::read(socket_, boost::asio::buffer(buffer_.data(), length));
+            out.write(buffer_.data(), length);
+            if (!out) {
+                throw std::runtime_error("写入本地文件失败");
+            }
+            total += length;
+        } else if (tag == "DONE") {
+            return total;
+        } else if (tag == "FAIL") {
+            throw std::runtime_error(std::format("sync RECV 失败: {}", read_fail_message(length)));
+        } else {
+            throw std::runtime_error("sync RECV 响应无效");
+        }
+    }
+}
+
+uint64_t AdbSyncConnection::send(std::string_view remote_path, uint32_t mode, uint32_t mtime, std::istream& in) {
+    write_request("SEND", std::format("{},{}", remote_path, mode));
+
+    uint64_t total = 0;
+    char header[8];
+    std::memcpy(header, "DATA", 4);
+    while (in) {
+        in.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        auto n = static_cast<size_t>(in.gcount());
+        if (n == 0) break;
+        put_le32(header + 4, static_cast<uint32_t>(n));
+        std::array<boost::asio::const_buffer, 2> buffers = {
+            boost::asio::buffer(header, 8),
+            boost::asio::buffer(buffer_.data(), n)
+        };
+        boost::asio::write(socket_, buffers);
+        total += n;
+    }
+    write_header("DONE", mtime);
+
+    char id[4];
+    uint32_t length = 0;
+    read_header(id, length);
+    if (std::string_view(id, 4) == "FAIL") {
+        throw std::runtime_error(std::format("sync SEND 失败: {}", read_fail_message(length)));
+    }
+    if (std::string_view(id, 4) != "OKAY") {
+        throw std::runtime_error("sync SEND 响应无效");
+    }
+    return total;
+}
+
+void AdbSyncConnection::interrupt() {
+    boost::system::error_code ec;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+}
+
+void AdbSyncConnection::quit() {
+    closed_ = true;
+    write_header("QUIT", 0);
+    boost::system::error_code ec;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+    socket_.close(ec);
+}
@@ -0,0 +1,355 @@
+#include "../../include/adb/AdbTouchInjector.hpp"
+#include "../../include/adb/ADBClient.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <sstream>
+#include <thread>
+
+using boost::asio::ip::tcp;
+
+namespace {
+
+// linux/input-event-codes.h
+constexpr uint16_t EV_SYN = 0x00;
+constexpr uint16_t EV_KEY = 0x01;
+constexpr uint16_t EV_ABS = 0x03;
+constexpr uint16_t SYN_REPORT = 0;
+constexpr uint16_t SYN_MT_REPORT = 2;
+constexpr uint16_t BTN_TOUCH = 0x14a;
+constexpr uint16_t ABS_MT_SLOT = 0x2f;
+constexpr uint16_t ABS_MT_TOUCH_MAJOR = 0x30;
+constexpr uint16_t ABS_MT_POSITION_X = 0x35;
+constexpr uint16_t ABS_MT_POSITION_Y = 0x36;
+constexpr uint16_t ABS_MT_TRACKING_ID = 0x39;
+constexpr uint16_t ABS_MT_PRESSURE = 0x3a;
+
+// A 类多点协议没有 slot，最多同时跟踪的触点数
+constexpr int PROTOCOL_A_MAX_POINTERS = 10;
+
+// 在行中查找 "<key> ... min a, max b"，key 后须紧跟空白或冒号
+bool parse_abs_range(std::string_view line, std::string_view key, int32_t& min, int32_t& max) {
+    size_t pos = line.find(key);
+    if (pos == std::string_view::npos) return false;
+    size_t end = pos + key.size();
+    if (end < line.size() && line[end] != ' ' && line[end] != ':') return false;
+    auto number_after = [&](std::string_view label, int32_t& out) {
+        size_t at = line.find(label, end);
+        if (at == std::string_view::npos) return false;
+        const char* first = line.data() + at + label.size();
+        return std::from_chars(first, line.data() + line.size(), out).ec == std::errc{};
+    };
+    return number_after("min ", min) && number_after("max ", max);
+}
+
+} // namespace
+
+AdbTouchInjector::AdbTouchInjector(ADBClient& adb, std::string device_id)
+    : adb_(adb)
+    , device_id_(std::move(device_id))
+{
+}
+
+AdbTouchInjector::~AdbTouchInjector() {
+    if (channel_) {
+        boost::system::error_code ec;
+        channel_->shutdown(tcp::socket::shutdown_both, ec);
+        channel_->close(ec);
+    }
+}
+
+std::optional<AdbTouchDevice> AdbTouchInjector::parse_getevent(std::string_view output) {
+    std::vector<AdbTouchDevice> devices;
+    std::istringstream iss{std::string(output)};
+    std::string line;
+    while (std::getline(iss, line)) {
+        if (line.starts_with("add device")) {
+            AdbTouchDevice device;
+            size_t colon = line.find(": ");
+            if (colon != std::string::npos) {
+                device.path = line.substr(colon + 2);
+                while (!device.path.empty() && std::isspace(static_cast<unsigned char>(device.path.back()))) {
+                    device.path.pop_back();
+                }
+            }
+            devices.push_back(std::move(device));
+            continue;
+        }
+        if (devices.empty()) continue;
+        auto& device = devices.back();
+
+        size_t name_pos = line.find("name:");
+        if (name_pos != std::string::npos) {
+            size_t open = line.find('"', name_pos);
+            size_t close = line.rfind('"');
+            if (open != std::string::npos && close > open) {
+                device.name = line.substr(open + 1, close - open - 1);
+            }
+            continue;
+        }
+        if (line.find("BTN_TOUCH") != std::string::npos) {
+            device.has_btn_touch = true;
+        }
+        int32_t min = 0, max = 0;
+        if (parse_abs_range(line, "ABS_MT_POSITION_X", min, max)) {
+            device.x_min = min;
+            device.x_max = max;
+        } else if (parse_abs_range(line, "ABS_MT_POSITION_Y", min, max)) {
+            device.y_min = min;
+            device.y_max = max;
+        } else if (parse_abs_range(line, "ABS_MT_SLOT", min, max)) {
+            device.slot_max = max;
+        } else if (parse_abs_range(line, "ABS_MT_TRACKING_ID", min, max)) {
+            device.tracking_max = max;
+        } else if (parse_abs_range(line, "ABS_MT_PRESSURE", min, max)) {
+            device.pressure_max = max;
+        } else if (parse_abs_range(line, "ABS_MT_TOUCH_MAJOR", min, max)) {
+            device.touch_major_max = max;
+        }
+    }
+    for (auto& device : devices) {
+        if (!device.path.empty() && device.x_max > device.x_min && device.y_max > device.y_min) {
+            return device;
+        }
+    }
+    return std::nullopt;
+}
+
+bool AdbTouchInjector::init() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_ = false;
+
+        auto touch = parse_getevent(adb_.shell_run(device_id_, "getevent -lp").out);
+        if (!touch) {
+            return false;
+        }
+        touch_ = *touch;
+
+        // shell 用户需要对触摸节点有写权限（通常属于 input 组）
+        auto writable = adb_.shell_run(device_id_, std::format("test -w {}", touch_.path));
+        if (!writable.ok || writable.exit_code != 0) {
+            return false;
+        }
+
+        // wm size 为自然方向尺寸；有 Override size 时截图按覆盖后的分辨率输出
+        std::string wm = adb_.shell_run(device_id_, "wm size").out;
+        for (std::string_view label : {"Physical size: ", "Override size: "}) {
+            size_t pos = wm.find(label);
+            if (pos == std::string::npos) continue;
+            const char* first = wm.data() + pos + label.size();
+            const char* last = wm.data() + wm.size();
+            auto [x_end, ec] = std::from_chars(first, last, natural_width_);
+            if (ec == std::errc{} && x_end < last && *x_end == 'x') {
+                std::from_chars(x_end + 1, last, natural_height_);
+            }
+        }
+        if (natural_width_ <= 0 || natural_height_ <= 0) {
+            return false;
+        }
+
+        // input_event 含 struct timeval，大小取决于写入进程（cat）的用户态位数
+        std::string abi = adb_.shell_run(device_id_, "getprop ro.product.cpu.abi").out;
+        event_size_ = abi.find("64") != std::string::npos ? 24 : 16;
+
+        contacts_.assign(touch_.slot_max >= 0 ? touch_.slot_max + 1 : PROTOCOL_A_MAX_POINTERS, std::nullopt);
+        if (!open_channel()) {
+            return false;
+        }
+        ready_ = true;
+    }
+    refresh_rotation();
+    return true;
+}
+
+bool AdbTouchInjector::open_channel() {
+    channel_ = adb_.exec_stream(device_id_, std::format("cat > {}", touch_.path));
+    return channel_.has_value();
+}
+
+void AdbTouchInjector::refresh_rotation() {
+    std::string output = adb_.shell_run(device_id_, "dumpsys input | grep -m 1 SurfaceOrientation").out;
+    size_t pos = output.find("SurfaceOrientation:");
+    int rotation = 0;
+    if (pos != std::string::npos) {
+        size_t digit = output.find_first_of("0123", pos);
+        if (digit != std::string::npos) {
+            rotation = output[digit] - '0';
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    rotation_ = rotation;
+}
+
+void AdbTouchInjector::update_display_size(int width, int height) {
+    bool refresh = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ready_ || width == height) return;
+        int display_w = rotation_ % 2 ? natural_height_ : natural_width_;
+        int display_h = rotation_ % 2 ? natural_width_ : natural_height_;
+        refresh = (width > height) != (display_w > display_h);
+    }
+    if (refresh) {
+        refresh_rotation();
+    }
+}
+
+std::pair<int32_t, int32_t> AdbTouchInjector::map_point(int x, int y) const {
+    // 与 InputReader 的方向变换互逆：显示坐标还原为自然方向坐标
+    int w = natural_width_;
+    int h = natural_height_;
+    int nx = x, ny = y;
+    switch (rotation_) {
+        case 1: nx = w - 1 - y; ny = x; break;
+        case 2: nx = w - 1 - x; ny = h - 1 - y; break;
+        case 3: nx = y; ny = h - 1 - x; break;
+        default: break;
+    }
+    nx = std::clamp(nx, 0, w - 1);
+    ny = std::clamp(ny, 0, h - 1);
+    auto scale = [](int v, int size, int32_t min, int32_t max) {
+        int64_t range = static_cast<int64_t>(max) - min + 1;
+        return static_cast<int32_t>(std::min<int64_t>(max, min + v * range / size));
+    };
+    return {scale(nx, w, touch_.x_min, touch_.x_max), scale(ny, h, touch_.y_min, touch_.y_max)};
+}
+
+void AdbTouchInjector::append_event(std::string& out, uint16_t type, uint16_t code, int32_t value) const {
+    // struct input_event：时间戳由内核在注入时填写，这里置零；Android 设备均为小端
+    out.append(event_size_ - 8, '\0');
+    char tail[8] = {
+        static_cast<char>(type & 0xff), static_cast<char>(type >> 8),
+        static_cast<char>(code & 0xff), static_cast<char>(code >> 8),
+        static_cast<char>(value & 0xff), static_cast<char>((value >> 8) & 0xff),
+        static_cast<char>((value >> 16) & 0xff), static_cast<char>((value >> 24) & 0xff),
+    };
+    out.append(tail, 8);
+}
+
+void AdbTouchInjector::append_frame(std::string& out, int pointer, bool down_changed) {
+    bool any_down = std::any_of(contacts_.begin(), contacts_.end(), [](const auto& c) { return c.has_value(); });
+    auto append_position = [&](const std::pair<int32_t, int32_t>& pos) {
+        append_event(out, EV_ABS, ABS_MT_POSITION_X, pos.first);
+        append_event(out, EV_ABS, ABS_MT_POSITION_Y, pos.second);
+        if (touch_.touch_major_max > 0) {
+            append_event(out, EV_ABS, ABS_MT_TOUCH_MAJOR, std::max(1, touch_.touch_major_max / 16));
+        }
+        if (touch_.pressure_max > 0) {
+            append_event(out, EV_ABS, ABS_MT_PRESSURE, std::max(1, touch_.pressure_max / 2));
+        }
+    };
+
+    if (touch_.slot_max >= 0) {
+        // B 类：只上报变化的 slot
+        const auto& contact = contacts_[pointer];
+        append_event(out, EV_ABS, ABS_MT_SLOT, pointer);
+        if (down_changed) {
+            int32_t id = -1;
+            if (contact) {
+                id = next_tracking_id_;
+                next_tracking_id_ = next_tracking_id_ >= touch_.tracking_max ? 0 : next_tracking_id_ + 1;
+            }
+            append_event(out, EV_ABS, ABS_MT_TRACKING_ID, id);
+        }
+        if (contact) {
+            append_position(*contact);
+        }
+    } else {
+        // A 类：每帧重发全部触点，没有触点时发一个空的 SYN_MT_REPORT
+        for (size_t i = 0; i < contacts_.size(); ++i) {
+            if (!contacts_[i]) continue;
+            append_event(out, EV_ABS, ABS_MT_TRACKING_ID, static_cast<int32_t>(i));
+            append_position(*contacts_[i]);
+            append_event(out, EV_SYN, SYN_MT_REPORT, 0);
+        }
+        if (!any_down) {
+            append_event(out, EV_SYN, SYN_MT_REPORT, 0);
+        }
+    }
+    if (down_changed && touch_.has_btn_touch) {
+        // 第一根手指按下 / 最后一根手指抬起
+        size_t down_count = std::count_if(contacts_.begin(), contacts_.end(), [](const auto& c) { return c.has_value(); });
+        if ((contacts_[pointer] && down_count == 1) || !any_down) {
+            append_event(out, EV_KEY, BTN_TOUCH, any_down ? 1 : 0);
+        }
+    }
+    append_event(out, EV_SYN, SYN_REPORT, 0);
+}
+
+bool AdbTouchInjector::write_events(const std::string& events) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!channel_ && !open_channel()) {
+            return false;
+        }
+        boost::system::error_code ec;
+        boost::asio::write(*channel_, boost::asio::buffer(events), ec);
+        if (!ec) {
+            return true;
+        }
+        // 通道断开（cat 退出或连接被回收），重开后重发
+        channel_.reset();
+    }
+    return false;
+}
+
+bool AdbTouchInjector::touch_down(int pointer, int x, int y) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_ || pointer < 0 || pointer >= static_cast<int>(contacts_.size()) || contacts_[pointer]) {
+        return false;
+    }
+    contacts_[pointer] = map_point(x, y);
+    std::string events;
+    append_frame(events, pointer, true);
+    return write_events(events);
+}
+
+bool AdbTouchInjector::touch_move(int pointer, int x, int y) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_ || pointer < 0 || pointer >= static_cast<int>(contacts_.size()) || !contacts_[pointer]) {
+        return false;
+    }
+    contacts_[pointer] = map_point(x, y);
+    std::string events;
+    append_frame(events, pointer, false);
+    return write_events(events);
+}
+
+bool AdbTouchInjector::touch_up(int pointer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_ || pointer < 0 || pointer >= static_cast<int>(contacts_.size()) || !contacts_[pointer]) {
+        return false;
+    }
+    contacts_[pointer].reset();
+    std::string events;
+    append_frame(events, pointer, true);
+    return write_events(events);
+}
+
+bool AdbTouchInjector::tap(int x, int y, int hold_ms) {
+    if (!touch_down(0, x, y)) {
+        return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(hold_ms));
+    return touch_up(0);
+}
+
+bool AdbTouchInjector::swipe(int x1, int y1, int x2, int y2, int duration_ms, int step_ms) {
+    if (!touch_down(0, x1, y1)) {
+        return false;
+    }
+    // 按绝对时刻推进，单次写入的耗时不会累积成总时长误差
+    int steps = std::max(1, duration_ms / std::max(1, step_ms));
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    for (int i = 1; i <= steps && ok; ++i) {
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(static_cast<int64_t>(duration_ms) * i / steps));
+        int x = x1 + (x2 - x1) * i / steps;
+        int y = y1 + (y2 - y1) * i / steps;
+        ok = touch_move(0, x, y);
+    }
+    // 无论移动是否成功都要抬起，避免残留按下状态
+    return touch_up(0) && ok;
+}
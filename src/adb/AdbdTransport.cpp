@@ -0,0 +1,484 @@
+#include "../../include/adb/AdbdTransport.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <future>
+#include <stdexcept>
+#include <sys/socket.h>
+
+using boost::asio::awaitable;
+using boost::asio::ip::tcp;
+
+namespace {
+
+// 报文命令（小端 ASCII）
+constexpr uint32_t A_CNXN = 0x4e584e43;
+constexpr uint32_t A_AUTH = 0x48545541;
+constexpr uint32_t A_OPEN = 0x4e45504f;
+constexpr uint32_t A_OKAY = 0x59414b4f;
+constexpr uint32_t A_CLSE = 0x45534c43;
+constexpr uint32_t A_WRTE = 0x45545257;
+constexpr uint32_t A_STLS = 0x534c5453;
+
+// AUTH 报文 arg0
+constexpr uint32_t AUTH_TOKEN = 1;
+constexpr uint32_t AUTH_SIGNATURE = 2;
+constexpr uint32_t AUTH_RSAPUBLICKEY = 3;
+
+// 0x01000001 起双方跳过负载校验和；更早的设备仍要求校验和正确
+constexpr uint32_t A_VERSION = 0x01000001;
+// 本端可接收的最大负载（与 adb 的 MAX_PAYLOAD 一致）
+constexpr uint32_t MAX_PAYLOAD = 1024 * 1024;
+
+// 只声明实际支持的特性，设备据此选择 shell v2 等协议
+constexpr std::string_view HOST_BANNER = "host::features=shell_v2,cmd,stat_v2";
+
+void put_le32(char* dst, uint32_t value) {
+    dst[0] = static_cast<char>(value & 0xff);
+    dst[1] = static_cast<char>((value >> 8) & 0xff);
+    dst[2] = static_cast<char>((value >> 16) & 0xff);
+    dst[3] = static_cast<char>((value >> 24) & 0xff);
+}
+
+uint32_t get_le32(const char* src) {
+    auto b = reinterpret_cast<const unsigned char*>(src);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+uint32_t checksum(std::string_view payload) {
+    uint32_t sum = 0;
+    for (unsigned char c : payload) sum += c;
+    return sum;
+}
+
+// 设备标识与特性以 \0 结尾时去掉
+std::string trim_nul(std::string text) {
+    while (!text.empty() && text.back() == '\0') text.pop_back();
+    return text;
+}
+
+} // namespace
+
+AdbdTransport::AdbdTransport(boost::asio::io_context& io_context, tcp::socket socket)
+    : io_context_(io_context)
+    , socket_(std::move(socket))
+{
+}
+
+AdbdTransport::~AdbdTransport() = default;
+
+std::shared_ptr<AdbdTransport> AdbdTransport::connect(boost::asio::io_context& io_context,
+                                                      const tcp::resolver::results_type& endpoints,
+                                                      std::shared_ptr<const AdbRsaKey> key,
+                                                      AdbWatchdog* watchdog) {
+    tcp::socket socket(io_context);
+    boost::asio::connect(socket, endpoints);
+    socket.set_option(tcp::no_delay(true));
+
+    std::shared_ptr<AdbdTransport> transport(new AdbdTransport(io_context, std::move(socket)));
+    {
+        // 等待用户确认公钥也在监视范围内，握手完成后交由 IO 线程读取
+        std::optional<AdbWatchdog::Watch> watch;
+        if (watchdog) {
+            watch.emplace(watchdog->watch(transport->socket_));
+        }
+        transport->handshake(key.get());
+    }
+    transport->alive_.store(true, std::memory_order_release);
+    boost::asio::post(io_context, [transport] { transport->start(); });
+    return transport;
+}
+
+std::array<char, ADBD_HEADER_SIZE> AdbdTransport::make_header(uint32_t command, uint32_t arg0, uint32_t arg1,
+                                                              std::string_view payload) const {
+    std::array<char, ADBD_HEADER_SIZE> header;
+    put_le32(header.data(), command);
+    put_le32(header.data() + 4, arg0);
+    put_le32(header.data() + 8, arg1);
+    put_le32(header.data() + 12, static_cast<uint32_t>(payload.size()));
+    // 握手完成前协议版本未知，按旧版本计算校验和
+    put_le32(header.data() + 16, protocol_version_ >= A_VERSION ? 0 : checksum(payload));
+    put_le32(header.data() + 20, command ^ 0xffffffff);
+    return header;
+}
+
+void AdbdTransport::write_packet_sync(uint32_t command, uint32_t arg0, uint32_t arg1, std::string_view payload) {
+    auto header = make_header(command, arg0, arg1, payload);
+    std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(header),
+        boost::asio::buffer(payload.data(), payload.size())
+    };
+    boost::asio::write(socket_, buffers);
+}
+
+AdbdTransport::Packet AdbdTransport::read_packet_sync() {
+    char header[ADBD_HEADER_SIZE];
+    boost::asio::read(socket_, boost::asio::buffer(header));
+    Packet packet;
+    packet.command = get_le32(header);
+    packet.arg0 = get_le32(header + 4);
+    packet.arg1 = get_le32(header + 8);
+    uint32_t length = get_le32(header + 12);
+    if (get_le32(header + 20) != (packet.command ^ 0xffffffff) || length > MAX_PAYLOAD) {
+        throw std::runtime_error("adbd 报文头无效");
+    }
+    packet.payload.resize(length);
+    boost::asio::read(socket_, boost::asio::buffer(packet.payload.data(), length));
+    return packet;
+}
+
+void AdbdTransport::handshake(const AdbRsaKey* key) {
+    write_packet_sync(A_CNXN, A_VERSION, MAX_PAYLOAD, HOST_BANNER);
+
+    bool signed_token = false;
+    bool sent_public_key = false;
+    while (true) {
+        Packet packet = read_packet_sync();
+        if (packet.command == A_CNXN) {
+            protocol_version_ = std::min(packet.arg0, A_VERSION);
+            max_payload_ = std::min<size_t>(packet.arg1, MAX_PAYLOAD);
+            banner_ = trim_nul(std::move(packet.payload));
+            // "device::ro.product.name=...;ro.product.model=...;features=a,b,c"
+            size_t start = banner_.find("features=");
+            if (start != std::string::npos) {
+                start += 9;
+                std::string_view list(banner_);
+                list = list.substr(start, list.find(';', start) == std::string_view::npos
+                                              ? std::string_view::npos : list.find(';', start) - start);
+                while (!list.empty()) {
+                    size_t comma = list.find(',');
+                    features_.emplace_back(list.substr(0, comma));
+                    if (comma == std::string_view::npos) break;
+                    list.remove_prefix(comma + 1);
+                }
+            }
+            return;
+        }
+        if (packet.command == A_STLS) {
+            // Android 11 配对式无线调试要求 TLS，此处只支持 adb tcpip 的 RSA 认证
+            throw std::runtime_error("adbd 要求 TLS，不支持");
+        }
+        if (packet.command != A_AUTH || packet.arg0 != AUTH_TOKEN) {
+            continue;
+        }
+        if (!key) {
+            throw std::runtime_error("adbd 要求认证，但没有可用的密钥");
+        }
+        if (!signed_token) {
+            std::string signature = key->sign(packet.payload);
+            if (signature.empty()) {
+                throw std::runtime_error("AUTH 令牌签名失败");
+            }
+            write_packet_sync(A_AUTH, AUTH_SIGNATURE, 0, signature);
+            signed_token = true;
+        } else if (!sent_public_key) {
+            // 设备不认识该密钥：发送公钥，等待用户在设备上允许调试
+            std::string public_key = key->public_key();
+            public_key.push_back('\0');
+            write_packet_sync(A_AUTH, AUTH_RSAPUBLICKEY, 0, public_key);
+            sent_public_key = true;
+        } else {
+            throw std::runtime_error("adbd 拒绝了公钥");
+        }
+    }
+}
+
+bool AdbdTransport::has_feature(std::string_view feature) const {
+    return std::find(features_.begin(), features_.end(), feature) != features_.end();
+}
+
+std::string AdbdTransport::features() const {
+    std::string joined;
+    for (const auto& feature : features_) {
+        if (!joined.empty()) joined += ',';
+        joined += feature;
+    }
+    return joined;
+}
+
+tcp::socket AdbdTransport::open(std::string_view service, AdbWatchdog* watchdog) {
+    uint32_t local_id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    auto promise = std::make_shared<std::promise<tcp::socket>>();
+    auto future = promise->get_future();
+    boost::asio::post(io_context_, [self = shared_from_this(), local_id, service = std::string(service), promise]() mutable {
+        self->begin_open(local_id, std::move(service), [promise](boost::system::error_code ec, tcp::socket socket) {
+            if (ec) {
+                promise->set_exception(std::make_exception_ptr(boost::system::system_error(ec)));
+            } else {
+                promise->set_value(std::move(socket));
+            }
+        });
+    });
+    // 先投递 OPEN 再监视：中断动作同样投递到 IO 线程，保证排在 begin_open 之后
+    std::optional<AdbWatchdog::Watch> watch;
+    if (watchdog) {
+        watch.emplace(watchdog->watch([self = shared_from_this(), local_id] {
+            boost::asio::post(self->io_context_, [self, local_id] { self->abort_open(local_id); });
+        }));
+    }
+    return future.get();
+}
+
+awaitable<tcp::socket> AdbdTransport::async_open(std::string service) {
+    uint32_t local_id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    auto self = shared_from_this();
+    co_return co_await boost::asio::async_initiate<decltype(boost::asio::use_awaitable),
+                                                   void(boost::system::error_code, tcp::socket)>(
+        [self, local_id, &service](auto handler) {
+            auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+            self->begin_open(local_id, std::move(service), [shared](boost::system::error_code ec, tcp::socket socket) {
+                (*shared)(ec, std::move(socket));
+            });
+        },
+        boost::asio::use_awaitable);
+}
+
+void AdbdTransport::close() {
+    alive_.store(false, std::memory_order_release);
+    boost::asio::post(io_context_, [self = shared_from_this()] {
+        self->fail(boost::asio::error::operation_aborted);
+    });
+}
+
+void AdbdTransport::start() {
+    if (!alive()) return;
+    read_header();
+}
+
+void AdbdTransport::read_header() {
+    boost::asio::async_read(socket_, boost::asio::buffer(read_header_),
+        [self = shared_from_this()](const boost::system::error_code& ec, size_t) {
+            if (ec) return self->fail(ec);
+            auto packet = std::make_shared<Packet>();
+            const char* header = self->read_header_.data();
+            packet->command = get_le32(header);
+            packet->arg0 = get_le32(header + 4);
+            packet->arg1 = get_le32(header + 8);
+            uint32_t length = get_le32(header + 12);
+            if (get_le32(header + 20) != (packet->command ^ 0xffffffff) || length > MAX_PAYLOAD) {
+                return self->fail(boost::asio::error::invalid_argument);
+            }
+            if (length == 0) {
+                self->dispatch(*packet);
+                return self->read_header();
+            }
+            self->read_payload(std::move(packet), length);
+        });
+}
+
+void AdbdTransport::read_payload(std::shared_ptr<Packet> packet, uint32_t length) {
+    packet->payload.resize(length);
+    auto buffer = boost::asio::buffer(packet->payload.data(), length);
+    boost::asio::async_read(socket_, buffer,
+        [self = shared_from_this(), packet](const boost::system::error_code& ec, size_t) {
+            if (ec) return self->fail(ec);
+            self->dispatch(*packet);
+            self->read_header();
+        });
+}
+
+void AdbdTransport::dispatch(Packet& packet) {
+    if (!alive()) return;
+    // OKAY/WRTE/CLSE 的 arg0 为设备端流 ID，arg1 为本端流 ID
+    auto it = streams_.find(packet.arg1);
+    std::shared_ptr<Stream> stream = it != streams_.end() ? it->second : nullptr;
+
+    switch (packet.command) {
+        case A_OKAY:
+            if (!stream) {
+                // 已放弃的打开请求：通知设备关闭
+                if (packet.arg0 != 0) send(A_CLSE, 0, packet.arg0);
+                return;
+            }
+            if (stream->on_open) {
+                stream->remote_id = packet.arg0;
+                stream->buffer.resize(max_payload_);
+                OpenHandler handler = std::move(stream->on_open);
+                stream->on_open = nullptr;
+                tcp::socket peer = std::move(*stream->peer);
+                stream->peer.reset();
+                handler({}, std::move(peer));
+            }
+            // 打开确认或上一个 WRTE 的确认：继续读取调用方写入的数据
+            pump_bridge(stream);
+            return;
+        case A_WRTE:
+            if (!stream) {
+                send(A_CLSE, 0, packet.arg0);
+                return;
+            }
+            stream->incoming.push_back(std::move(packet.payload));
+            drain_incoming(stream);
+            return;
+        case A_CLSE:
+            if (!stream) return;
+            if (stream->on_open) {
+                // 打开前关闭：设备拒绝了该服务
+                close_stream(stream, false, boost::asio::error::connection_refused);
+                return;
+            }
+            // 尚未写入 bridge 的数据写完后再关闭
+            stream->remote_closed = true;
+            if (!stream->writing) close_stream(stream, false);
+            return;
+        default:
+            // 握手后的 CNXN/AUTH 等忽略
+            return;
+    }
+}
+
+void AdbdTransport::send(uint32_t command, uint32_t arg0, uint32_t arg1, std::string payload) {
+    Outgoing outgoing;
+    outgoing.header = make_header(command, arg0, arg1, payload);
+    outgoing.payload = std::move(payload);
+    outbox_.push_back(std::move(outgoing));
+    flush();
+}
+
+void AdbdTransport::send_write(const std::shared_ptr<Stream>& stream, size_t length) {
+    Outgoing outgoing;
+    outgoing.header = make_header(A_WRTE, stream->local_id, stream->remote_id,
+                                  std::string_view(stream->buffer.data(), length));
+    outgoing.stream = stream;
+    outgoing.length = length;
+    outbox_.push_back(std::move(outgoing));
+    flush();
+}
+
+void AdbdTransport::flush() {
+    if (flushing_ || outbox_.empty() || !alive()) return;
+    flushing_ = true;
+    Outgoing& front = outbox_.front();
+    std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(front.header),
+        front.stream ? boost::asio::buffer(front.stream->buffer.data(), front.length)
+                     : boost::asio::buffer(front.payload)
+    };
+    boost::asio::async_write(socket_, buffers, [self = shared_from_this()](const boost::system::error_code& ec, size_t) {
+        self->flushing_ = false;
+        if (!self->outbox_.empty()) self->outbox_.pop_front();
+        if (ec) return self->fail(ec);
+        self->flush();
+    });
+}
+
+void AdbdTransport::begin_open(uint32_t local_id, std::string service, OpenHandler handler) {
+    auto reject = [this, &handler](boost::system::error_code ec) {
+        // 异步完成，避免在发起者的调用栈内回调
+        boost::asio::post(io_context_, [this, handler = std::move(handler), ec] {
+            handler(ec, tcp::socket(io_context_));
+        });
+    };
+    if (!alive()) {
+        return reject(boost::asio::error::not_connected);
+    }
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        return reject(boost::system::error_code(errno, boost::system::system_category()));
+    }
+    // AF_UNIX 套接字挂在 tcp::socket 上：调用方只做读写与 shutdown，这些操作与协议族无关
+    tcp::socket bridge(io_context_);
+    tcp::socket peer(io_context_);
+    bridge.assign(tcp::v4(), fds[0]);
+    peer.assign(tcp::v4(), fds[1]);
+
+    auto stream = std::make_shared<Stream>(local_id, std::move(bridge));
+    stream->peer.emplace(std::move(peer));
+    stream->on_open = std::move(handler);
+    streams_.emplace(local_id, stream);
+    active_streams_.fetch_add(1, std::memory_order_relaxed);
+
+    // 服务名以 \0 结尾
+    service.push_back('\0');
+    send(A_OPEN, local_id, 0, std::move(service));
+}
+
+void AdbdTransport::abort_open(uint32_t local_id) {
+    auto it = streams_.find(local_id);
+    if (it == streams_.end() || !it->second->on_open) return;
+    // 设备稍后的 OKAY 会因找不到流而被回以 CLSE
+    close_stream(it->second, false, boost::asio::error::operation_aborted);
+}
+
+void AdbdTransport::pump_bridge(const std::shared_ptr<Stream>& stream) {
+    if (stream->closed || stream->local_closed) return;
+    stream->bridge.async_read_some(boost::asio::buffer(stream->buffer),
+        [self = shared_from_this(), stream](const boost::system::error_code& ec, size_t n) {
+            if (stream->closed) return;
+            if (ec == boost::asio::error::eof) {
+                // 调用方 shutdown 写端（或关闭、看门狗中断）：协议没有半关闭，只能以 CLSE 通知设备输入结束；
+                // 设备回应 CLSE 之前仍把它发来的数据写给调用方（如 exec:cat >> 追加后等待远端关闭）
+                stream->local_closed = true;
+                if (stream->remote_id != 0 && self->alive()) {
+                    self->send(A_CLSE, stream->local_id, stream->remote_id);
+                }
+                return;
+            }
+            if (ec) {
+                return self->close_stream(stream, true);
+            }
+            self->send_write(stream, n);
+        });
+}
+
+void AdbdTransport::drain_incoming(const std::shared_ptr<Stream>& stream) {
+    if (stream->writing || stream->closed || stream->incoming.empty()) return;
+    stream->writing = true;
+    const std::string& data = stream->incoming.front();
+    boost::asio::async_write(stream->bridge, boost::asio::buffer(data),
+        [self = shared_from_this(), stream](const boost::system::error_code& ec, size_t) {
+            stream->writing = false;
+            if (stream->closed) return;
+            stream->incoming.pop_front();
+            if (ec) {
+                return self->close_stream(stream, true);
+            }
+            if (stream->remote_closed) {
+                if (stream->incoming.empty()) self->close_stream(stream, false);
+                else self->drain_incoming(stream);
+                return;
+            }
+            // 调用方已收下，允许设备发送下一个 WRTE（已发出 CLSE 时不再确认）
+            if (!stream->local_closed) self->send(A_OKAY, stream->local_id, stream->remote_id);
+            self->drain_incoming(stream);
+        });
+}
+
+void AdbdTransport::close_stream(const std::shared_ptr<Stream>& stream, bool notify, boost::system::error_code ec) {
+    if (stream->closed) return;
+    stream->closed = true;
+    if (notify && !stream->local_closed && stream->remote_id != 0 && alive()) {
+        send(A_CLSE, stream->local_id, stream->remote_id);
+    }
+    boost::system::error_code ignored;
+    stream->bridge.shutdown(tcp::socket::shutdown_both, ignored);
+    stream->bridge.close(ignored);
+    streams_.erase(stream->local_id);
+    active_streams_.fetch_sub(1, std::memory_order_relaxed);
+    if (stream->on_open) {
+        OpenHandler handler = std::move(stream->on_open);
+        stream->on_open = nullptr;
+        stream->peer.reset();
+        handler(ec, tcp::socket(io_context_));
+    }
+}
+
+void AdbdTransport::fail(const boost::system::error_code& ec) {
+    alive_.store(false, std::memory_order_release);
+    boost::system::error_code ignored;
+    socket_.shutdown(tcp::socket::shutdown_both, ignored);
+    socket_.close(ignored);
+    // 正在发送的报文仍被 async_write 引用，其余丢弃
+    if (flushing_) {
+        outbox_.erase(outbox_.begin() + 1, outbox_.end());
+    } else {
+        outbox_.clear();
+    }
+    auto streams = std::move(streams_);
+    streams_.clear();
+    for (auto& [id, stream] : streams) {
+        close_stream(stream, false, ec ? ec : boost::asio::error::connection_reset);
+    }
+}
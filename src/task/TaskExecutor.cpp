@@ -1,6 +1,8 @@
 #include "task/TaskExecutor.hpp"
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <format>
 #include <variant>
 
 TaskExecutor::TaskExecutor(SimpleController& controller) : controller_(controller) {}
@@ -20,6 +22,8 @@ void TaskExecutor::stop() {
     if (!running_.load()) return;
     running_ = false;
     queue_cv_.notify_all();
+    // 中断当前步骤中阻塞的截图、命令与等待，工作线程随即看到 running_ 为 false
+    controller_.cancel();
     if (worker_thread_.joinable()) {
         worker_thread_.join();
     }
@@ -83,6 +87,7 @@ bool TaskExecutor::execute_task(const TaskConfig& task) {
     std::cout << std::string(60, '=') << std::endl;
 
     int loop_count = task.loop ? task.loop_count : 1;
+    FrameCacheStats cache_before = controller_.frame_cache_stats();
 
     for (int i = 0; i < loop_count && running_.load(); ++i) {
         if (loop_count > 1) {
@@ -91,6 +96,8 @@ bool TaskExecutor::execute_task(const TaskConfig& task) {
 
         int step_index = 0;
         for (const auto& step : task.steps) {
+            // 先取取消代数再检查 running_：stop() 先清 running_ 再 cancel()，两者之间的中断不会被错过
+            step_generation_ = controller_.cancel_generation();
             if (!running_.load()) {
                 std::cout << "[TaskExecutor] ⏹️ 任务被中断" << std::endl;
                 return false;
@@ -106,18 +113,28 @@ bool TaskExecutor::execute_task(const TaskConfig& task) {
 
             if (!result) {
                 std::cerr << "[Step " << step_index << "] ❌ 失败 (" << duration.count() << "ms)" << std::endl;
+                log_cache_stats(cache_before);
                 return false;
             }
             std::cout << "[Step " << step_index << "] ✅ 完成 (" << duration.count() << "ms)" << std::endl;
         }
     }
 
+    log_cache_stats(cache_before);
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "[TaskExecutor] ✅ 任务完成: " << task.name << std::endl;
     std::cout << std::string(60, '=') << "\n" << std::endl;
     return true;
 }
 
+void TaskExecutor::log_cache_stats(const FrameCacheStats& before) const {
+    FrameCacheStats now = controller_.frame_cache_stats();
+    FrameCacheStats task{now.hits - before.hits, now.misses - before.misses};
+    if (task.hits + task.misses == 0) return;
+    std::cout << "[TaskExecutor] 🗂️ 帧分析缓存: 命中 " << task.hits << "/" << (task.hits + task.misses)
+              << " (" << static_cast<int>(task.hit_rate() * 100) << "%)" << std::endl;
+}
+
 // ========== 静态多态：函数重载 ==========
 
 bool TaskExecutor::execute(const BasicStep& step) {
@@ -130,7 +147,15 @@ bool TaskExecutor::execute(const BasicStep& step) {
         return controller_.swipe(step.x, step.y, step.x2, step.y2, step.duration);
     } else if (step.action == "wait") {
         std::cout << "⏳ 等待 " << step.duration << "ms" << std::endl;
-        controller_.wait(step.duration);
+        controller_.wait(step.duration, step_generation_);
+        return true;
+    } else if (step.action == "wait_stable") {
+        std::cout << "⏳ 等待画面稳定 (最长 " << step.timeout << "ms)" << std::endl;
+        if (!controller_.wait_stable(step.timeout, step.min_wait, step.interval, step.threshold, step.stable_count,
+                                     step_generation_)) {
+            // 与固定等待一致：超时后继续执行，由后续识别步骤判断画面
+            std::cout << "  ⚠️ 画面未稳定，已等满 " << step.timeout << "ms" << std::endl;
+        }
         return true;
     }
     std::cerr << "❌ 未知操作: " << step.action << std::endl;
@@ -139,12 +164,23 @@ bool TaskExecutor::execute(const BasicStep& step) {
 
 bool TaskExecutor::execute(const VisionStep& step) {
     if (step.action == "screenshot") {
+        if (!step.capture_rois.empty()) {
+            std::cout << "📷 局部截图 (" << step.capture_rois.size() << " 个区域) -> " << step.image_name << std::endl;
+            std::vector<cv::Rect2f> regions;
+            for (const auto& roi : step.capture_rois) {
+                regions.emplace_back(static_cast<float>(roi.x) / roi.base_width,
+                                     static_cast<float>(roi.y) / roi.base_height,
+                                     static_cast<float>(roi.width) / roi.base_width,
+                                     static_cast<float>(roi.height) / roi.base_height);
+            }
+            return controller_.capture_partial(step.image_name, regions);
+        }
         std::cout << "📷 截图 -> " << step.image_name << std::endl;
         return controller_.capture_screenshot(step.image_name);
     } else if (step.action == "ocr_click") {
         std::cout << "🔍🖱️  OCR点击: \"" << step.text << "\"" << std::endl;
         int x, y;
-        if (controller_.find_text(step.image_name, step.text, x, y)) {
+        if (poll(step, step.retry, false, [&](const std::string& frame) { return controller_.find_text(frame, step.text, x, y); })) {
             std::cout << "  ✅ 位置: (" << x << ", " << y << ")" << std::endl;
             return controller_.click(x, y);
         }
@@ -159,29 +195,154 @@ bool TaskExecutor::execute(const VisionStep& step) {
         std::cout << "🔍📐 OCR区域 (" << roi.x << ", " << roi.y << ", "
                   << roi.width << "x" << roi.height << ")" << std::endl;
         std::string text;
-        if (controller_.ocr_region(step.image_name, roi.x, roi.y, roi.width, roi.height,
-                                    roi.base_width, roi.base_height, text)) {
-            std::cout << "  📝 结果: \"" << text << "\"" << std::endl;
-            if (!step.text.empty()) {
-                return text.find(step.text) != std::string::npos;
+        bool ok = poll(step, step.retry, false, [&](const std::string& frame) {
+            if (!read_roi(step, frame, text)) {
+                return false;
             }
-            return true;
+            return step.text.empty() || text.find(step.text) != std::string::npos;
+        });
+        if (!text.empty()) {
+            std::cout << "  📝 结果: \"" << text << "\"" << std::endl;
         }
-        return false;
+        return ok;
     } else if (step.action == "template") {
         std::cout << "🖼️  模板匹配: " << step.template_path << std::endl;
         int x, y;
-        if (controller_.find_template(step.image_name, step.template_path, x, y)) {
+        if (poll(step, step.retry, false, [&](const std::string& frame) {
+                return controller_.find_template(frame, step.template_path, x, y);
+            })) {
             std::cout << "  ✅ 位置: (" << x << ", " << y << ")" << std::endl;
             return controller_.click(x, y);
         }
         std::cerr << "  ❌ 匹配失败" << std::endl;
         return false;
+    } else if (step.action == "wait_for_text") {
+        std::cout << "⏳🔍 等待文本: \"" << step.text << "\" (最长 " << step.timeout << "ms)" << std::endl;
+        int x = 0, y = 0;
+        bool found;
+        if (step.roi.has_value()) {
+            // 只截取并识别 roi 区域，找到后点击区域中心
+            const auto& roi = step.roi.value();
+            std::string text, checked;
+            found = poll(step, 0, true, [&](const std::string& frame) {
+                checked = frame;
+                return read_roi(step, frame, text) && text.find(step.text) != std::string::npos;
+            });
+            if (found) {
+                cv::Mat frame = controller_.get_frame(checked);
+                x = (roi.x + roi.width / 2) * frame.cols / roi.base_width;
+                y = (roi.y + roi.height / 2) * frame.rows / roi.base_height;
+            }
+        } else {
+            found = poll(step, 0, true, [&](const std::string& frame) { return controller_.find_text(frame, step.text, x, y); });
+        }
+        if (!found) {
+            std::cerr << "  ❌ 超时未出现: \"" << step.text << "\"" << std::endl;
+            return false;
+        }
+        std::cout << "  ✅ 位置: (" << x << ", " << y << ")" << std::endl;
+        return !step.click || controller_.click(x, y);
+    } else if (step.action == "wait_for_template") {
+        std::cout << "⏳🖼️  等待模板: " << step.template_path << " (最长 " << step.timeout << "ms)" << std::endl;
+        int x, y;
+        if (!poll(step, 0, true, [&](const std::string& frame) {
+                return controller_.find_template(frame, step.template_path, x, y);
+            })) {
+            std::cerr << "  ❌ 超时未匹配" << std::endl;
+            return false;
+        }
+        std::cout << "  ✅ 位置: (" << x << ", " << y << ")" << std::endl;
+        return !step.click || controller_.click(x, y);
     }
     std::cerr << "❌ 未知操作: " << step.action << std::endl;
     return false;
 }
 
+bool TaskExecutor::poll(const VisionStep& step, int max_attempts, bool capture_first,
+                        const std::function<bool(const std::string& frame)>& check) {
+    using namespace std::chrono;
+    auto deadline = steady_clock::now() + milliseconds(step.timeout);
+    auto interval = milliseconds(100);
+    for (int attempt = 1; running_.load(); ++attempt) {
+        // 截图失败按检查失败处理，继续轮询
+        std::string frame = step.image_name;
+        bool captured = (!capture_first && attempt == 1) || recapture(step, frame);
+        if (captured && check(frame)) {
+            if (attempt > 1) {
+                std::cout << "  🔁 第 " << attempt << " 次检查成功" << std::endl;
+            }
+            return true;
+        }
+        if (max_attempts > 0 && attempt >= max_attempts) return false;
+        auto remaining = duration_cast<milliseconds>(deadline - steady_clock::now());
+        if (remaining <= milliseconds(0)) return false;
+        if (!controller_.wait(static_cast<int>(std::min(interval, remaining).count()), step_generation_)) return false;
+        interval = std::min(interval * 3 / 2, milliseconds(1000));
+    }
+    return false;
+}
+
+RegionOcrMode TaskExecutor::region_mode(const ROIConfig& roi) {
+    if (roi.ocr_mode == "line") return RegionOcrMode::Line;
+    if (roi.ocr_mode == "detect") return RegionOcrMode::Detect;
+    bool single_line = roi.height > 0 && roi.height <= roi.line_max_height &&
+                       roi.width <= roi.height * roi.line_max_aspect;
+    return single_line ? RegionOcrMode::LineThenDetect : RegionOcrMode::Detect;
+}
+
+bool TaskExecutor::read_roi(const VisionStep& step, const std::string& frame, std::string& text) {
+    const auto& roi = step.roi.value();
+    // 限定字符集会把集外字形（如 "82/135" 中的 '/'）改判为允许字符，只有整行须匹配时才安全；
+    // 否则不限定解码，集外字形原样保留，regex_search 在其处断开
+    bool full_match = roi.filter_regex && roi.filter_full_match;
+    auto read = [&](RegionOcrMode mode) {
+        return controller_.ocr_region(frame, roi.x, roi.y, roi.width, roi.height, roi.base_width, roi.base_height,
+                                      text, mode, full_match ? roi.filter_pattern : "");
+    };
+    RegionOcrMode mode = region_mode(roi);
+    if (!read(mode)) {
+        return false;
+    }
+    if (roi.filter_regex) {
+        std::smatch match;
+        auto matches = [&] {
+            return full_match ? std::regex_match(text, match, *roi.filter_regex)
+                              : std::regex_search(text, match, *roi.filter_regex);
+        };
+        bool matched = matches();
+        if (!matched && mode == RegionOcrMode::LineThenDetect) {
+            // 单行结果被正则拒绝（如区域内还有其他文字）时，与结果为空一样退回检测 + 识别
+            matched = read(RegionOcrMode::Detect) && matches();
+        }
+        if (!matched) {
+            std::cerr << "  ⚠️ 结果不匹配 " << roi.filter_pattern << ": \"" << text << "\"" << std::endl;
+            return false;
+        }
+        text = match.str();
+    }
+    return true;
+}
+
+bool TaskExecutor::recapture(const VisionStep& step, std::string& frame) {
+    if (step.roi.has_value()) {
+        const auto& roi = step.roi.value();
+        cv::Rect2f region(static_cast<float>(roi.x) / roi.base_width,
+                          static_cast<float>(roi.y) / roi.base_height,
+                          static_cast<float>(roi.width) / roi.base_width,
+                          static_cast<float>(roi.height) / roi.base_height);
+        // 局部帧只有 roi 所在的行有效，写到私有帧名，之后读取 image_name 的整帧步骤不受影响
+        frame = roi_frame_name(step);
+        return controller_.capture_partial(frame, {region});
+    }
+    frame = step.image_name;
+    return controller_.capture_screenshot(frame);
+}
+
+std::string TaskExecutor::roi_frame_name(const VisionStep& step) {
+    const auto& roi = step.roi.value();
+    return std::format("roi_{}_{}_{}x{}_{}", roi.x, roi.y, roi.width, roi.height, step.image_name);
+}
+
 bool TaskExecutor::execute(const SystemStep& step) {
     if (step.action == "shell") {
         std::cout << "💻 Shell: " << step.cmd << std::endl;
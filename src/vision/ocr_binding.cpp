@@ -0,0 +1,58 @@
+#include "ocr_binding.h"
+#include <cstring>
+
+BoundInference::BoundInference(Ort::Session& session, const char* input_name, const char* output_name)
+    : session_(session),
+      input_name_(input_name),
+      output_name_(output_name),
+      memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+      binding_(session) {}
+
+float* BoundInference::input(const std::array<int64_t, 4>& shape) {
+    if (shape != input_shape_ || !input_value_) {
+        size_t count = static_cast<size_t>(shape[0] * shape[1] * shape[2] * shape[3]);
+        if (count > input_buffer_.capacity()) {
+            reallocations_++;
+        }
+        input_buffer_.resize(count);
+        input_shape_ = shape;
+        input_value_ = Ort::Value::CreateTensor<float>(memory_info_, input_buffer_.data(), count,
+                                                       input_shape_.data(), input_shape_.size());
+        binding_.BindInput(input_name_, input_value_);
+        // 输出形状随输入形状变化，下一次推理重新探测
+        output_bound_ = false;
+    }
+    return input_buffer_.data();
+}
+
+const float* BoundInference::run() {
+    if (!enabled_) {
+        unbound_outputs_ = session_.Run(run_options_, &input_name_, &input_value_, 1, &output_name_, 1);
+        output_shape_ = unbound_outputs_[0].GetTensorTypeAndShapeInfo().GetShape();
+        return unbound_outputs_[0].GetTensorData<float>();
+    }
+
+    if (!output_bound_) {
+        // 该输入形状第一次推理：由 ONNX Runtime 分配输出，得知形状后换成自有缓冲区
+        binding_.BindOutput(output_name_, memory_info_);
+        session_.Run(run_options_, binding_);
+        std::vector<Ort::Value> outputs = binding_.GetOutputValues();
+        auto info = outputs[0].GetTensorTypeAndShapeInfo();
+        output_shape_ = info.GetShape();
+        size_t count = info.GetElementCount();
+        if (count > output_buffer_.capacity()) {
+            reallocations_++;
+        }
+        output_buffer_.resize(count);
+        std::memcpy(output_buffer_.data(), outputs[0].GetTensorData<float>(), count * sizeof(float));
+
+        output_value_ = Ort::Value::CreateTensor<float>(memory_info_, output_buffer_.data(), count,
+                                                        output_shape_.data(), output_shape_.size());
+        binding_.BindOutput(output_name_, output_value_);
+        output_bound_ = true;
+        return output_buffer_.data();
+    }
+
+    session_.Run(run_options_, binding_);
+    return output_buffer_.data();
+}
@@ -0,0 +1,142 @@
+#include "ocr_charset.h"
+#include <regex>
+#include <set>
+
+namespace {
+
+// UTF-8 首字节对应的字符字节数
+size_t utf8Length(unsigned char lead) {
+    if (lead >= 0xF0) return 4;
+    if (lead >= 0xE0) return 3;
+    if (lead >= 0xC0) return 2;
+    return 1;
+}
+
+} // namespace
+
+std::optional<std::vector<int>> regexCharsetIndices(const std::string& pattern,
+                                                    const std::vector<std::string>& dictionary) {
+    std::vector<std::string> literals; // 与字典条目逐字比较
+    std::vector<std::string> classes;  // 单字符正则，对 ASCII 字典条目做匹配
+
+    size_t i = 0;
+    while (i < pattern.size()) {
+        unsigned char ch = pattern[i];
+        if (ch >= 0x80) {
+            size_t len = utf8Length(ch);
+            literals.push_back(pattern.substr(i, len));
+            i += len;
+        } else if (ch == '\\') {
+            if (i + 1 >= pattern.size()) return std::nullopt;
+            char e = pattern[i + 1];
+            if (e == 'd' || e == 'w' || e == 's') {
+                classes.push_back(pattern.substr(i, 2));
+            } else if (e == 'D' || e == 'W' || e == 'S' || e == 'x' || e == 'u' || e == 'c' ||
+                       (e >= '0' && e <= '9')) {
+                // 否定类、编码转义、反向引用：不推导
+                return std::nullopt;
+            } else if (e != 'b' && e != 'B' && e != 'n' && e != 'r' && e != 't' && e != 'f' && e != 'v') {
+                literals.push_back(std::string(1, e));
+            }
+            i += 2;
+        } else if (ch == '[') {
+            size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == '^') return std::nullopt;
+            if (j < pattern.size() && pattern[j] == ']') j++;
+            while (j < pattern.size() && pattern[j] != ']') {
+                if (static_cast<unsigned char>(pattern[j]) >= 0x80) return std::nullopt;
+                if (pattern[j] == '\\') {
+                    j += 2;
+                } else if (pattern[j] == '[' && j + 1 < pattern.size() && pattern[j + 1] == ':') {
+                    size_t end = pattern.find(":]", j + 2);
+                    if (end == std::string::npos) return std::nullopt;
+                    j = end + 2;
+                } else {
+                    j++;
+                }
+            }
+            if (j >= pattern.size()) return std::nullopt;
+            classes.push_back(pattern.substr(i, j - i + 1));
+            i = j + 1;
+        } else if (ch == '.') {
+            return std::nullopt;
+        } else if (ch == '{') {
+            size_t end = pattern.find('}', i);
+            if (end == std::string::npos) return std::nullopt;
+            i = end + 1;
+        } else if (ch == '(') {
+            i++;
+            // (?: (?= (?! 只跳过前缀
+            if (i < pattern.size() && pattern[i] == '?') {
+                i++;
+                if (i < pattern.size() && (pattern[i] == ':' || pattern[i] == '=' || pattern[i] == '!')) i++;
+            }
+        } else if (ch == ')' || ch == '|' || ch == '*' || ch == '+' || ch == '?' || ch == '^' || ch == '$') {
+            i++;
+        } else {
+            literals.push_back(std::string(1, static_cast<char>(ch)));
+            i++;
+        }
+    }
+
+    std::vector<std::regex> compiled;
+    try {
+        for (const auto& c : classes) {
+            compiled.emplace_back(c);
+        }
+    } catch (const std::regex_error&) {
+        return std::nullopt;
+    }
+
+    std::set<std::string> literal_set(literals.begin(), literals.end());
+    std::vector<int> indices{0};
+    for (size_t k = 1; k < dictionary.size(); k++) {
+        const std::string& entry = dictionary[k];
+        bool allowed = literal_set.count(entry) > 0;
+        if (!allowed && entry.size() == 1) {
+            for (const auto& re : compiled) {
+                if (std::regex_match(entry, re)) {
+                    allowed = true;
+                    break;
+                }
+            }
+        }
+        if (allowed) {
+            indices.push_back(static_cast<int>(k));
+        }
+    }
+    return indices;
+}
+
+std::string ctcGreedyDecode(const float* output, int seq_len, int num_classes,
+                            const std::vector<std::string>& dictionary, const std::vector<int>* allowed) {
+    std::string result;
+    int last_idx = 0;
+    for (int i = 0; i < seq_len; i++) {
+        const float* step = output + i * num_classes;
+        int max_idx = 0;
+        float max_val = step[0];
+        if (allowed) {
+            // 只比较允许字符（含空白）的得分
+            for (int j : *allowed) {
+                if (j < num_classes && step[j] > max_val) {
+                    max_val = step[j];
+                    max_idx = j;
+                }
+            }
+        } else {
+            for (int j = 1; j < num_classes; j++) {
+                if (step[j] > max_val) {
+                    max_val = step[j];
+                    max_idx = j;
+                }
+            }
+        }
+
+        if (max_idx != 0 && max_idx != last_idx && static_cast<size_t>(max_idx) < dictionary.size()) {
+            result += dictionary[max_idx];
+        }
+        last_idx = max_idx;
+    }
+    return result;
+}
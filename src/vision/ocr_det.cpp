@@ -1,8 +1,9 @@
 #include "ocr_det.h"
+#include "ocr_normalize.h"
 #include <algorithm>
 
-TextDetector::TextDetector(Ort::Env& env, const std::string& model_path)
-    : session_(env, model_path.c_str(), Ort::SessionOptions{nullptr}) {
+TextDetector::TextDetector(Ort::Env& env, const std::string& model_path, const OrtSessionConfig& config)
+    : session_(env, model_path.c_str(), config.build()) {
 
     size_t num_input = session_.GetInputCount();
     size_t num_output = session_.GetOutputCount();
@@ -21,9 +22,10 @@ TextDetector::TextDetector(Ort::Env& env, const std::string& model_path)
         output_name_strings_[i] = name.get();
         output_names_.push_back(output_name_strings_[i].c_str());
     }
+    binding_ = std::make_unique<BoundInference>(session_, input_names_[0], output_names_[0]);
 }
 
-cv::Mat TextDetector::preprocess(const cv::Mat& img, float& ratio_h, float& ratio_w) {
+const cv::Mat& TextDetector::preprocess(const cv::Mat& img, float& ratio_h, float& ratio_w) {
     int max_side_len = 960;
     int h = img.rows;
     int w = img.cols;
@@ -39,19 +41,13 @@ cv::Mat TextDetector::preprocess(const cv::Mat& img, float& ratio_h, float& rati
     resize_h = (resize_h + 31) / 32 * 32;
     resize_w = (resize_w + 31) / 32 * 32;
 
-    cv::Mat resized;
-    cv::resize(img, resized, cv::Size(resize_w, resize_h));
+    // 各缓冲区尺寸不变时复用内存
+    cv::resize(img, resized_, cv::Size(resize_w, resize_h));
 
     ratio_h = resize_h * 1.0f / h;
     ratio_w = resize_w * 1.0f / w;
 
-    resized.convertTo(resized, CV_32FC3, 1.0 / 255.0);
-
-    cv::Mat normalized;
-    cv::subtract(resized, cv::Scalar(0.485, 0.456, 0.406), normalized);
-    cv::divide(normalized, cv::Scalar(0.229, 0.224, 0.225), normalized);
-
-    return normalized;
+    return resized_;
 }
 
 std::vector<TextBox> TextDetector::postprocess(const cv::Mat& pred, float ratio_h, float ratio_w) {
@@ -123,34 +119,18 @@ std::vector<TextBox> TextDetector::postprocess(const cv::Mat& pred, float ratio_
 
 std::vector<TextBox> TextDetector::detect(const cv::Mat& img) {
     float ratio_h, ratio_w;
-    cv::Mat input = preprocess(img, ratio_h, ratio_w);
-
-    std::vector<int64_t> input_shape = {1, 3, input.rows, input.cols};
-    size_t input_tensor_size = 1 * 3 * input.rows * input.cols;
-    std::vector<float> input_tensor_values(input_tensor_size);
-
-    std::vector<cv::Mat> channels(3);
-    cv::split(input, channels);
-    for (int c = 0; c < 3; c++) {
-        std::memcpy(input_tensor_values.data() + c * input.rows * input.cols,
-                   channels[c].data, input.rows * input.cols * sizeof(float));
-    }
-
-    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
-        memory_info, input_tensor_values.data(), input_tensor_size,
-        input_shape.data(), input_shape.size());
+    const cv::Mat& input = preprocess(img, ratio_h, ratio_w);
 
-    auto output_tensors = session_.Run(Ort::RunOptions{nullptr},
-                                       input_names_.data(), &input_tensor, 1,
-                                       output_names_.data(), 1);
+    // 一次遍历完成归一化与 HWC 转 CHW，直接写入绑定的输入缓冲区
+    float* data = binding_->input({1, 3, input.rows, input.cols});
+    normalizeToPlanar(input, data, input.cols, {0.485f, 0.456f, 0.406f}, {0.229f, 0.224f, 0.225f});
 
-    float* output = output_tensors[0].GetTensorMutableData<float>();
-    auto output_shape = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
+    const float* output = binding_->run();
+    const auto& output_shape = binding_->output_shape();
 
     int out_h = output_shape[2];
     int out_w = output_shape[3];
-    cv::Mat pred(out_h, out_w, CV_32FC1, output);
+    cv::Mat pred(out_h, out_w, CV_32FC1, const_cast<float*>(output));
 
     // 计算从输出特征图到预处理后图像的比例
     float ratio_h_out = static_cast<float>(input.rows) / out_h;
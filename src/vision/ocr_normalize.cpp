@@ -0,0 +1,215 @@
+#include "ocr_normalize.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define OCR_NORMALIZE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// 单行归一化：src 为 width 个像素，三个平面各写入 width 个 float
+// 归一化化简为 x * scale + bias，scale = 1 / (255 * std)，bias = -mean / std
+struct RowArgs {
+    const uint8_t* src;
+    int width;
+    float* planes[3];
+    float scale[3];
+    float bias[3];
+};
+
+using RowKernel = void (*)(const RowArgs&, int x);
+
+void bgrRowScalar(const RowArgs& a, int x) {
+    for (; x < a.width; x++) {
+        for (int c = 0; c < 3; c++) {
+            a.planes[c][x] = a.src[3 * x + c] * a.scale[c] + a.bias[c];
+        }
+    }
+}
+
+void grayRowScalar(const RowArgs& a, int x) {
+    for (; x < a.width; x++) {
+        float v = a.src[x];
+        for (int c = 0; c < 3; c++) {
+            a.planes[c][x] = v * a.scale[c] + a.bias[c];
+        }
+    }
+}
+
+#ifdef OCR_NORMALIZE_X86
+
+// 16 个 BGR 像素（48 字节）解交织为 B、G、R 三个 16 字节向量
+__attribute__((target("ssse3")))
+inline void deinterleave16(const uint8_t* p, __m128i& b, __m128i& g, __m128i& r) {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+
+    b = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+    g = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+    r = _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(v0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+            _mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+            _mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// 16 个 uint8 转 float 后做 x * scale + bias，写入 dst[0..15]
+__attribute__((target("sse4.1")))
+inline void store16Sse(__m128i v, __m128 scale, __m128 bias, float* dst) {
+    for (int i = 0; i < 4; i++) {
+        __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v));
+        _mm_storeu_ps(dst + 4 * i, _mm_add_ps(_mm_mul_ps(f, scale), bias));
+        v = _mm_srli_si128(v, 4);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+inline void store16Avx(__m128i v, __m256 scale, __m256 bias, float* dst) {
+    __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+    __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+    _mm256_storeu_ps(dst, _mm256_fmadd_ps(lo, scale, bias));
+    _mm256_storeu_ps(dst + 8, _mm256_fmadd_ps(hi, scale, bias));
+}
+
+__attribute__((target("ssse3,sse4.1")))
+void bgrRowSse(const RowArgs& a, int x) {
+    const __m128 s0 = _mm_set1_ps(a.scale[0]), s1 = _mm_set1_ps(a.scale[1]), s2 = _mm_set1_ps(a.scale[2]);
+    const __m128 b0 = _mm_set1_ps(a.bias[0]), b1 = _mm_set1_ps(a.bias[1]), b2 = _mm_set1_ps(a.bias[2]);
+    for (; x + 16 <= a.width; x += 16) {
+        __m128i c0, c1, c2;
+        deinterleave16(a.src + 3 * x, c0, c1, c2);
+        store16Sse(c0, s0, b0, a.planes[0] + x);
+        store16Sse(c1, s1, b1, a.planes[1] + x);
+        store16Sse(c2, s2, b2, a.planes[2] + x);
+    }
+    bgrRowScalar(a, x);
+}
+
+__attribute__((target("ssse3,sse4.1")))
+void grayRowSse(const RowArgs& a, int x) {
+    const __m128 s0 = _mm_set1_ps(a.scale[0]), s1 = _mm_set1_ps(a.scale[1]), s2 = _mm_set1_ps(a.scale[2]);
+    const __m128 b0 = _mm_set1_ps(a.bias[0]), b1 = _mm_set1_ps(a.bias[1]), b2 = _mm_set1_ps(a.bias[2]);
+    for (; x + 16 <= a.width; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.src + x));
+        store16Sse(v, s0, b0, a.planes[0] + x);
+        store16Sse(v, s1, b1, a.planes[1] + x);
+        store16Sse(v, s2, b2, a.planes[2] + x);
+    }
+    grayRowScalar(a, x);
+}
+
+__attribute__((target("avx2,fma")))
+void bgrRowAvx2(const RowArgs& a, int x) {
+    const __m256 s0 = _mm256_set1_ps(a.scale[0]), s1 = _mm256_set1_ps(a.scale[1]), s2 = _mm256_set1_ps(a.scale[2]);
+    const __m256 b0 = _mm256_set1_ps(a.bias[0]), b1 = _mm256_set1_ps(a.bias[1]), b2 = _mm256_set1_ps(a.bias[2]);
+    for (; x + 16 <= a.width; x += 16) {
+        __m128i c0, c1, c2;
+        deinterleave16(a.src + 3 * x, c0, c1, c2);
+        store16Avx(c0, s0, b0, a.planes[0] + x);
+        store16Avx(c1, s1, b1, a.planes[1] + x);
+        store16Avx(c2, s2, b2, a.planes[2] + x);
+    }
+    bgrRowScalar(a, x);
+}
+
+__attribute__((target("avx2,fma")))
+void grayRowAvx2(const RowArgs& a, int x) {
+    const __m256 s0 = _mm256_set1_ps(a.scale[0]), s1 = _mm256_set1_ps(a.scale[1]), s2 = _mm256_set1_ps(a.scale[2]);
+    const __m256 b0 = _mm256_set1_ps(a.bias[0]), b1 = _mm256_set1_ps(a.bias[1]), b2 = _mm256_set1_ps(a.bias[2]);
+    for (; x + 16 <= a.width; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.src + x));
+        store16Avx(v, s0, b0, a.planes[0] + x);
+        store16Avx(v, s1, b1, a.planes[1] + x);
+        store16Avx(v, s2, b2, a.planes[2] + x);
+    }
+    grayRowScalar(a, x);
+}
+
+#endif
+
+NormalizeIsa bestIsa() {
+#ifdef OCR_NORMALIZE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return NormalizeIsa::AVX2;
+    if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1")) return NormalizeIsa::SSE41;
+#endif
+    return NormalizeIsa::Scalar;
+}
+
+std::atomic<NormalizeIsa>& currentIsa() {
+    static std::atomic<NormalizeIsa> isa{bestIsa()};
+    return isa;
+}
+
+RowKernel rowKernel(NormalizeIsa isa, bool gray) {
+    switch (isa) {
+#ifdef OCR_NORMALIZE_X86
+    case NormalizeIsa::AVX2: return gray ? grayRowAvx2 : bgrRowAvx2;
+    case NormalizeIsa::SSE41: return gray ? grayRowSse : bgrRowSse;
+#endif
+    default: return gray ? grayRowScalar : bgrRowScalar;
+    }
+}
+
+} // namespace
+
+void normalizeToPlanar(const cv::Mat& src, float* dst, int dst_width,
+                       const std::array<float, 3>& mean, const std::array<float, 3>& std) {
+    bool gray = src.type() == CV_8UC1;
+    if (!gray && src.type() != CV_8UC3) {
+        throw std::invalid_argument("normalizeToPlanar: 仅支持 CV_8UC1 / CV_8UC3 图像");
+    }
+    if (dst_width < src.cols) {
+        throw std::invalid_argument("normalizeToPlanar: dst_width 小于图像宽度");
+    }
+
+    RowKernel kernel = rowKernel(currentIsa().load(std::memory_order_relaxed), gray);
+    size_t plane = static_cast<size_t>(src.rows) * dst_width;
+    RowArgs args{};
+    args.width = src.cols;
+    for (int c = 0; c < 3; c++) {
+        args.scale[c] = 1.0f / (255.0f * std[c]);
+        args.bias[c] = -mean[c] / std[c];
+    }
+
+    for (int y = 0; y < src.rows; y++) {
+        args.src = src.ptr<uint8_t>(y);
+        for (int c = 0; c < 3; c++) {
+            args.planes[c] = dst + c * plane + static_cast<size_t>(y) * dst_width;
+        }
+        kernel(args, 0);
+        // 右侧补齐像素值 0
+        for (int c = 0; c < 3; c++) {
+            std::fill(args.planes[c] + src.cols, args.planes[c] + dst_width, args.bias[c]);
+        }
+    }
+}
+
+NormalizeIsa normalizeIsa() {
+    return currentIsa().load(std::memory_order_relaxed);
+}
+
+NormalizeIsa setNormalizeIsa(NormalizeIsa isa) {
+    NormalizeIsa best = bestIsa();
+    NormalizeIsa applied = static_cast<int>(isa) <= static_cast<int>(best) ? isa : best;
+    currentIsa().store(applied, std::memory_order_relaxed);
+    return applied;
+}
+
+const char* normalizeIsaName(NormalizeIsa isa) {
+    switch (isa) {
+    case NormalizeIsa::AVX2: return "AVX2";
+    case NormalizeIsa::SSE41: return "SSE4.1";
+    default: return "scalar";
+    }
+}
@@ -47,33 +47,40 @@ cv::Mat getRotateCropImage(const cv::Mat& img, const std::vector<cv::Point2f>& b
 
 OcrPack::OcrPack(const std::string& det_model_path,
                  const std::string& rec_model_path,
-                 const std::string& dict_path) {
+                 const std::string& dict_path,
+                 const OcrRuntimeConfig& runtime) {
     // 初始化 ONNX Runtime 环境
     env_ = std::make_unique<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "OcrPack");
 
     // 初始化检测器和识别器
-    detector_ = std::make_unique<TextDetector>(*env_, det_model_path);
-    recognizer_ = std::make_unique<TextRecognizer>(*env_, rec_model_path, dict_path);
+    detector_ = std::make_unique<TextDetector>(*env_, det_model_path, runtime.det);
+    recognizer_ = std::make_unique<TextRecognizer>(*env_, rec_model_path, dict_path, runtime.rec,
+                                                   runtime.rec_batch_size, runtime.rec_vocabulary);
 }
 
-std::vector<std::pair<TextBox, std::string>> OcrPack::recognizeAll(const cv::Mat& img) {
+std::vector<std::pair<TextBox, std::string>> OcrPack::recognizeAll(const cv::Mat& img,
+                                                                   const std::string& filter_pattern) {
     std::vector<std::pair<TextBox, std::string>> results;
 
     // 1. 检测文本区域
     std::vector<TextBox> boxes = detector_->detect(img);
 
-    // 2. 对每个区域进行识别
+    // 2. 裁剪所有区域后批量识别
+    std::vector<cv::Mat> crops;
+    crops.reserve(boxes.size());
     for (const auto& box : boxes) {
-        cv::Mat crop = getRotateCropImage(img, box.box);
-        std::string text = recognizer_->recognize(crop);
-        results.push_back({box, text});
+        crops.push_back(getRotateCropImage(img, box.box));
+    }
+    std::vector<std::string> texts = recognizer_->recognizeBatch(crops, filter_pattern);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        results.push_back({boxes[i], std::move(texts[i])});
     }
 
     return results;
 }
 
-std::string OcrPack::recognizeText(const cv::Mat& img) {
-    return recognizer_->recognize(img);
+std::string OcrPack::recognizeText(const cv::Mat& img, const std::string& filter_pattern) {
+    return recognizer_->recognize(img, filter_pattern);
 }
 
 std::vector<TextBox> OcrPack::detectTextRegions(const cv::Mat& img) {
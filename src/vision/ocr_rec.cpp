@@ -1,13 +1,37 @@
 #include "ocr_rec.h"
+#include "ocr_charset.h"
+#include "ocr_normalize.h"
+#include "ocr_rec_prune.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 
 TextRecognizer::TextRecognizer(Ort::Env& env, const std::string& model_path,
-                               const std::string& dict_path)
-    : session_(env, model_path.c_str(), Ort::SessionOptions{nullptr}) {
+                               const std::string& dict_path, const OrtSessionConfig& config, int max_batch,
+                               const std::string& vocab_path)
+    : session_(nullptr), max_batch_(std::max(1, max_batch)) {
 
     loadDict(dict_path);
 
+    // 按词表裁剪分类层，失败时使用完整模型；字典读取失败时类别数未知，不裁剪
+    if (!vocab_path.empty() && characters_.empty()) {
+        std::cerr << "识别字典为空，不按词表裁剪分类层" << std::endl;
+    } else if (!vocab_path.empty()) {
+        try {
+            PrunedRecModel pruned = pruneRecognizerHead(model_path, characters_, vocab_path);
+            session_ = Ort::Session(env, pruned.model_path.c_str(), config.build());
+            std::cout << "识别模型分类层按词表裁剪为 " << pruned.characters.size() << " 类"
+                      << (pruned.from_cache ? "（缓存）" : "") << ": " << pruned.model_path << std::endl;
+            characters_ = std::move(pruned.characters);
+        } catch (const std::exception& e) {
+            std::cerr << "识别模型裁剪失败，使用完整模型: " << e.what() << std::endl;
+        }
+    }
+    if (!session_) {
+        session_ = Ort::Session(env, model_path.c_str(), config.build());
+    }
+
     size_t num_input = session_.GetInputCount();
     size_t num_output = session_.GetOutputCount();
 
@@ -25,6 +49,14 @@ TextRecognizer::TextRecognizer(Ort::Env& env, const std::string& model_path,
         output_name_strings_[i] = name.get();
         output_names_.push_back(output_name_strings_[i].c_str());
     }
+
+    // 导出时固定了批大小或宽度的模型只能按固定形状推理
+    auto input_shape = session_.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    if (input_shape.size() == 4) {
+        if (input_shape[0] > 0) max_batch_ = 1;
+        dynamic_width_ = input_shape[3] <= 0;
+    }
+    clahe_ = cv::createCLAHE(2.0, cv::Size(8, 8));
 }
 
 void TextRecognizer::loadDict(const std::string& dict_path) {
@@ -44,104 +76,141 @@ void TextRecognizer::loadDict(const std::string& dict_path) {
     file.close();
 }
 
-cv::Mat TextRecognizer::preprocess(const cv::Mat& img) {
-    int img_h = 48;
-    int img_w = 320;
+int TextRecognizer::bucketWidth(const cv::Mat& img) const {
+    if (!dynamic_width_ || img.rows == 0) {
+        return kMaxWidth;
+    }
+    int resize_w = std::min(int(kHeight * (img.cols * 1.0f / img.rows)), kMaxWidth);
+    int width = (resize_w + kWidthStep - 1) / kWidthStep * kWidthStep;
+    return std::clamp(width, kWidthStep, kMaxWidth);
+}
 
-     cv::Mat processed = img.clone();
+void TextRecognizer::preprocess(const cv::Mat& img, int width, float* dst) {
+    int img_h = kHeight;
+    int img_w = width;
 
     // 如果图片太小，先放大
+    const cv::Mat* processed = &img;
     if (img.rows < 20) {
         float scale = 20.0f / img.rows;
-        cv::resize(img, processed, cv::Size(), scale, scale, cv::INTER_CUBIC);
+        cv::resize(img, enlarged_, cv::Size(), scale, scale, cv::INTER_CUBIC);
+        processed = &enlarged_;
     }
 
     // 转为灰度图
-    cv::Mat gray;
-    if (processed.channels() == 3) {
-        cv::cvtColor(processed, gray, cv::COLOR_BGR2GRAY);
-    } else {
-        gray = processed.clone();
+    const cv::Mat* gray = processed;
+    if (processed->channels() == 3) {
+        cv::cvtColor(*processed, gray_, cv::COLOR_BGR2GRAY);
+        gray = &gray_;
     }
 
     // 自适应直方图均衡化，增强对比度
-    cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(2.0, cv::Size(8, 8));
-    cv::Mat enhanced;
-    clahe->apply(gray, enhanced);
-
-    // 转回3通道
-    cv::Mat enhanced_bgr;
-    cv::cvtColor(enhanced, enhanced_bgr, cv::COLOR_GRAY2BGR);
+    clahe_->apply(*gray, enhanced_);
 
     // 计算缩放比例
-    float ratio = enhanced_bgr.cols * 1.0f / enhanced_bgr.rows;
+    float ratio = enhanced_.cols * 1.0f / enhanced_.rows;
     int resize_w = std::min(int(img_h * ratio), img_w);
 
-    cv::Mat resized;
-    cv::resize(enhanced_bgr, resized, cv::Size(resize_w, img_h), 0, 0, cv::INTER_CUBIC);
-
-    if (resize_w < img_w) {
-        cv::copyMakeBorder(resized, resized, 0, 0, 0, img_w - resize_w,
-                          cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
-    }
+    // 灰度图缩放后由 normalizeToPlanar 复制到三个通道，与先转回三通道再缩放结果一致
+    cv::resize(enhanced_, resized_, cv::Size(resize_w, img_h), 0, 0, cv::INTER_CUBIC);
 
-    resized.convertTo(resized, CV_32FC3, 1.0 / 255.0);
+    normalizeToPlanar(resized_, dst, img_w, {0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f});
+}
 
-    cv::Mat normalized;
-    cv::subtract(resized, cv::Scalar(0.5, 0.5, 0.5), normalized);
-    cv::divide(normalized, cv::Scalar(0.5, 0.5, 0.5), normalized);
+std::string TextRecognizer::recognize(const cv::Mat& img, const std::string& filter_pattern) {
+    return recognizeBatch({img}, filter_pattern)[0];
+}
 
-    return normalized;
+const std::vector<int>* TextRecognizer::allowedClasses(const std::string& filter_pattern) {
+    if (filter_pattern.empty()) {
+        return nullptr;
+    }
+    auto it = charsets_.find(filter_pattern);
+    if (it == charsets_.end()) {
+        it = charsets_.emplace(filter_pattern, regexCharsetIndices(filter_pattern, characters_)).first;
+        if (it->second) {
+            std::cout << "识别字符集 " << filter_pattern << ": " << it->second->size() - 1 << " 个字符" << std::endl;
+        } else {
+            std::cout << "识别字符集 " << filter_pattern << ": 无法推导，不限制" << std::endl;
+        }
+    }
+    return it->second ? &*it->second : nullptr;
 }
 
-std::string TextRecognizer::recognize(const cv::Mat& img) {
-    cv::Mat input = preprocess(img);
-
-    std::vector<int64_t> input_shape = {1, 3, input.rows, input.cols};
-    size_t input_tensor_size = 1 * 3 * input.rows * input.cols;
-    std::vector<float> input_tensor_values(input_tensor_size);
-
-    std::vector<cv::Mat> channels(3);
-    cv::split(input, channels);
-    for (int c = 0; c < 3; c++) {
-        std::memcpy(input_tensor_values.data() + c * input.rows * input.cols,
-                   channels[c].data, input.rows * input.cols * sizeof(float));
-    }
-
-    auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
-        memory_info, input_tensor_values.data(), input_tensor_size,
-        input_shape.data(), input_shape.size());
-
-    auto output_tensors = session_.Run(Ort::RunOptions{nullptr},
-                                       input_names_.data(), &input_tensor, 1,
-                                       output_names_.data(), 1);
-
-    float* output = output_tensors[0].GetTensorMutableData<float>();
-    auto output_shape = output_tensors[0].GetTensorTypeAndShapeInfo().GetShape();
-
-    int seq_len = output_shape[1];
-    int num_classes = output_shape[2];
-
-    std::string result;
-    int last_idx = 0;
-    for (int i = 0; i < seq_len; i++) {
-        int max_idx = 0;
-        float max_val = output[i * num_classes];
-        for (int j = 1; j < num_classes; j++) {
-            if (output[i * num_classes + j] > max_val) {
-                max_val = output[i * num_classes + j];
-                max_idx = j;
-            }
+std::vector<std::string> TextRecognizer::recognizeBatch(const std::vector<cv::Mat>& imgs,
+                                                        const std::string& filter_pattern) {
+    std::vector<std::string> results(imgs.size());
+    const std::vector<int>* allowed = allowedClasses(filter_pattern);
+
+    // 按桶宽排序，相邻同宽的文本框进入同一批
+    std::vector<int> widths(imgs.size());
+    std::vector<size_t> order(imgs.size());
+    for (size_t i = 0; i < imgs.size(); i++) {
+        widths[i] = bucketWidth(imgs[i]);
+    }
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return widths[a] < widths[b]; });
+
+    size_t begin = 0;
+    while (begin < order.size()) {
+        int width = widths[order[begin]];
+        size_t end = begin;
+        while (end < order.size() && end - begin < static_cast<size_t>(max_batch_) && widths[order[end]] == width) {
+            end++;
         }
 
-        if (max_idx != 0 && max_idx != last_idx) {
-            if (max_idx < characters_.size()) {
-                result += characters_[max_idx];
-            }
+        // 多个文本框时补满 max_batch_ 个样本：批大小随框数变化会反复重新绑定，并由 ONNX Runtime 分配输出；
+        // 单个文本框（区域识别的常见情形）不补齐，免去多余的计算
+        size_t count = end - begin;
+        int64_t batch = count == 1 ? 1 : max_batch_;
+        BoundInference& inference = binding(batch, width);
+
+        // 逐个预处理，直接写入绑定输入缓冲区中该样本的位置，补齐的样本填空白
+        float* data = inference.input({batch, 3, kHeight, width});
+        size_t sample = static_cast<size_t>(3) * kHeight * width;
+        for (size_t k = begin; k < end; k++) {
+            preprocess(imgs[order[k]], width, data + (k - begin) * sample);
+        }
+        std::fill(data + count * sample, data + static_cast<size_t>(batch) * sample, kPadValue);
+
+        const float* output = inference.run();
+        const auto& output_shape = inference.output_shape();
+        int seq_len = output_shape[1];
+        int num_classes = output_shape[2];
+        for (size_t k = begin; k < end; k++) {
+            results[order[k]] = decode(output + (k - begin) * seq_len * num_classes, seq_len, num_classes, allowed);
         }
-        last_idx = max_idx;
+        begin = end;
+    }
+
+    return results;
+}
+
+BoundInference& TextRecognizer::binding(int64_t batch, int width) {
+    auto& inference = bindings_[{batch, width}];
+    if (!inference) {
+        inference = std::make_unique<BoundInference>(session_, input_names_[0], output_names_[0]);
+        inference->set_enabled(binding_enabled_);
     }
+    return *inference;
+}
+
+void TextRecognizer::setBindingEnabled(bool enabled) {
+    binding_enabled_ = enabled;
+    for (auto& [shape, inference] : bindings_) {
+        inference->set_enabled(enabled);
+    }
+}
+
+uint64_t TextRecognizer::reallocations() const {
+    uint64_t total = 0;
+    for (const auto& [shape, inference] : bindings_) {
+        total += inference->reallocations();
+    }
+    return total;
+}
 
-    return result;
+std::string TextRecognizer::decode(const float* output, int seq_len, int num_classes,
+                                   const std::vector<int>* allowed) const {
+    return ctcGreedyDecode(output, seq_len, num_classes, characters_, allowed);
 }
@@ -0,0 +1,526 @@
+#include "ocr_rec_prune.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ---- protobuf 编解码：只处理改写分类层用到的字段，其余字段原样保留 ----
+
+struct PbField {
+    uint32_t number = 0;
+    uint32_t wire = 0;      ///< 0 varint，1 fixed64，2 length-delimited，5 fixed32
+    uint64_t value = 0;     ///< varint 的值
+    std::string_view data;  ///< length-delimited 的载荷
+    std::string_view raw;   ///< 含标签的完整编码，未修改时原样写回
+};
+
+uint64_t readVarint(std::string_view buf, size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= buf.size()) throw std::runtime_error("protobuf varint 截断");
+        uint8_t byte = static_cast<uint8_t>(buf[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error("protobuf varint 过长");
+}
+
+std::vector<PbField> parseMessage(std::string_view buf) {
+    std::vector<PbField> fields;
+    size_t pos = 0;
+    while (pos < buf.size()) {
+        size_t start = pos;
+        uint64_t key = readVarint(buf, pos);
+        PbField f;
+        f.number = static_cast<uint32_t>(key >> 3);
+        f.wire = static_cast<uint32_t>(key & 7);
+        switch (f.wire) {
+        case 0: f.value = readVarint(buf, pos); break;
+        case 1: pos += 8; break;
+        case 5: pos += 4; break;
+        case 2: {
+            uint64_t len = readVarint(buf, pos);
+            if (len > buf.size() - pos) throw std::runtime_error("protobuf 字段长度越界");
+            f.data = buf.substr(pos, len);
+            pos += len;
+            break;
+        }
+        default: throw std::runtime_error("不支持的 protobuf wire type");
+        }
+        if (pos > buf.size()) throw std::runtime_error("protobuf 字段截断");
+        f.raw = buf.substr(start, pos - start);
+        fields.push_back(f);
+    }
+    return fields;
+}
+
+void writeVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void writeVarintField(std::string& out, uint32_t number, uint64_t value) {
+    writeVarint(out, (static_cast<uint64_t>(number) << 3) | 0);
+    writeVarint(out, value);
+}
+
+void writeBytesField(std::string& out, uint32_t number, std::string_view data) {
+    writeVarint(out, (static_cast<uint64_t>(number) << 3) | 2);
+    writeVarint(out, data.size());
+    out.append(data);
+}
+
+// ---- ONNX 消息字段号（onnx.proto） ----
+constexpr uint32_t kModelGraph = 7;
+constexpr uint32_t kGraphNode = 1, kGraphInitializer = 5, kGraphOutput = 12, kGraphValueInfo = 13;
+constexpr uint32_t kNodeInput = 1, kNodeOutput = 2, kNodeOpType = 4, kNodeAttribute = 5;
+constexpr uint32_t kAttrName = 1, kAttrInt = 3, kAttrTensor = 5;
+constexpr uint32_t kTensorDims = 1, kTensorDataType = 2, kTensorFloatData = 4, kTensorName = 8,
+                   kTensorRawData = 9, kTensorDataLocation = 14;
+constexpr uint32_t kValueInfoType = 2, kTypeTensor = 1, kTensorTypeShape = 2, kShapeDim = 1, kDimValue = 1;
+constexpr uint64_t kFloat = 1;
+
+struct NodeInfo {
+    std::string op_type;
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::map<std::string, PbField> attributes; // 属性名 -> 属性消息中的值字段（int / tensor）
+};
+
+NodeInfo parseNode(std::string_view data) {
+    NodeInfo node;
+    for (const auto& f : parseMessage(data)) {
+        if (f.number == kNodeInput) node.inputs.emplace_back(f.data);
+        else if (f.number == kNodeOutput) node.outputs.emplace_back(f.data);
+        else if (f.number == kNodeOpType) node.op_type = f.data;
+        else if (f.number == kNodeAttribute) {
+            std::string name;
+            PbField value;
+            for (const auto& a : parseMessage(f.data)) {
+                if (a.number == kAttrName) name = a.data;
+                else if (a.number == kAttrInt || a.number == kAttrTensor) value = a;
+            }
+            node.attributes.emplace(name, value);
+        }
+    }
+    return node;
+}
+
+struct TensorInfo {
+    std::vector<int64_t> dims;
+    std::vector<float> values;
+};
+
+TensorInfo parseFloatTensor(std::string_view data) {
+    TensorInfo tensor;
+    uint64_t data_type = 0;
+    std::string_view raw;
+    for (const auto& f : parseMessage(data)) {
+        if (f.number == kTensorDims) {
+            if (f.wire == 2) {
+                size_t pos = 0;
+                while (pos < f.data.size()) tensor.dims.push_back(static_cast<int64_t>(readVarint(f.data, pos)));
+            } else {
+                tensor.dims.push_back(static_cast<int64_t>(f.value));
+            }
+        } else if (f.number == kTensorDataType) {
+            data_type = f.value;
+        } else if (f.number == kTensorFloatData) {
+            std::string_view bytes = f.wire == 2 ? f.data : f.raw.substr(f.raw.size() - 4);
+            size_t offset = tensor.values.size();
+            tensor.values.resize(offset + bytes.size() / 4);
+            std::memcpy(tensor.values.data() + offset, bytes.data(), bytes.size() / 4 * 4);
+        } else if (f.number == kTensorRawData) {
+            raw = f.data;
+        } else if (f.number == kTensorDataLocation && f.value == 1) {
+            throw std::runtime_error("不支持外部数据存储的权重");
+        }
+    }
+    if (data_type != kFloat) throw std::runtime_error("分类层权重不是 float32");
+    if (!raw.empty()) {
+        tensor.values.resize(raw.size() / 4);
+        std::memcpy(tensor.values.data(), raw.data(), raw.size() / 4 * 4);
+    }
+    size_t count = 1;
+    for (int64_t d : tensor.dims) count *= static_cast<size_t>(d);
+    if (count != tensor.values.size()) throw std::runtime_error("权重数据与形状不符");
+    return tensor;
+}
+
+// 按 axis（0 或 1，1-D 张量为 0）保留 keep 中的下标，返回新的 TensorProto
+std::string sliceTensor(std::string_view data, int axis, const std::vector<int>& keep) {
+    TensorInfo tensor = parseFloatTensor(data);
+    std::vector<float> sliced;
+    std::vector<int64_t> dims = tensor.dims;
+    if (dims.size() == 1) {
+        for (int k : keep) sliced.push_back(tensor.values[k]);
+    } else if (axis == 1) {
+        for (int64_t r = 0; r < dims[0]; r++) {
+            for (int k : keep) sliced.push_back(tensor.values[r * dims[1] + k]);
+        }
+    } else {
+        for (int k : keep) {
+            sliced.insert(sliced.end(), tensor.values.begin() + k * dims[1], tensor.values.begin() + (k + 1) * dims[1]);
+        }
+    }
+    dims[dims.size() == 1 ? 0 : axis] = static_cast<int64_t>(keep.size());
+
+    std::string out;
+    for (int64_t d : dims) writeVarintField(out, kTensorDims, static_cast<uint64_t>(d));
+    for (const auto& f : parseMessage(data)) {
+        if (f.number != kTensorDims && f.number != kTensorFloatData && f.number != kTensorRawData) {
+            out.append(f.raw);
+        }
+    }
+    writeBytesField(out, kTensorRawData,
+                    std::string_view(reinterpret_cast<const char*>(sliced.data()), sliced.size() * sizeof(float)));
+    return out;
+}
+
+std::vector<int64_t> tensorDims(std::string_view data) {
+    std::vector<int64_t> dims;
+    for (const auto& f : parseMessage(data)) {
+        if (f.number != kTensorDims) continue;
+        if (f.wire == 2) {
+            size_t pos = 0;
+            while (pos < f.data.size()) dims.push_back(static_cast<int64_t>(readVarint(f.data, pos)));
+        } else {
+            dims.push_back(static_cast<int64_t>(f.value));
+        }
+    }
+    return dims;
+}
+
+// ValueInfoProto 的形状中取值为 from 的维度改为 to
+std::string rewriteDims(std::string_view value_info, int64_t from, int64_t to) {
+    // ValueInfoProto.type.tensor_type.shape.dim.dim_value
+    auto rewrite = [](std::string_view msg, uint32_t number, const auto& inner) {
+        std::string out;
+        for (const auto& f : parseMessage(msg)) {
+            if (f.number == number && f.wire == 2) writeBytesField(out, number, inner(f.data));
+            else out.append(f.raw);
+        }
+        return out;
+    };
+    auto dim = [&](std::string_view d) {
+        std::string out;
+        for (const auto& f : parseMessage(d)) {
+            if (f.number == kDimValue && f.wire == 0 && static_cast<int64_t>(f.value) == from) {
+                writeVarintField(out, kDimValue, static_cast<uint64_t>(to));
+            } else {
+                out.append(f.raw);
+            }
+        }
+        return out;
+    };
+    auto shape = [&](std::string_view s) { return rewrite(s, kShapeDim, dim); };
+    auto tensor_type = [&](std::string_view t) { return rewrite(t, kTensorTypeShape, shape); };
+    auto type = [&](std::string_view t) { return rewrite(t, kTypeTensor, tensor_type); };
+    return rewrite(value_info, kValueInfoType, type);
+}
+
+// 将 Constant 节点的 value 属性替换为 tensor
+std::string replaceConstant(std::string_view node, const std::string& tensor) {
+    std::string out;
+    for (const auto& f : parseMessage(node)) {
+        if (f.number != kNodeAttribute) {
+            out.append(f.raw);
+            continue;
+        }
+        std::string attr;
+        bool is_value = false;
+        for (const auto& a : parseMessage(f.data)) {
+            if (a.number == kAttrName && a.data == "value") is_value = true;
+        }
+        for (const auto& a : parseMessage(f.data)) {
+            if (is_value && a.number == kAttrTensor) writeBytesField(attr, kAttrTensor, tensor);
+            else attr.append(a.raw);
+        }
+        writeBytesField(out, kNodeAttribute, attr);
+    }
+    return out;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) throw std::runtime_error("无法打开文件: " + path);
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+// ValueInfoProto 形状的最后一维，动态维度或没有形状时为空
+std::optional<int64_t> lastDim(std::string_view value_info) {
+    auto child = [](std::string_view msg, uint32_t number) {
+        std::string_view found;
+        for (const auto& f : parseMessage(msg)) {
+            if (f.number == number && f.wire == 2) found = f.data;
+        }
+        return found;
+    };
+    std::string_view shape = child(child(child(value_info, kValueInfoType), kTypeTensor), kTensorTypeShape);
+    std::string_view dim;
+    for (const auto& f : parseMessage(shape)) {
+        if (f.number == kShapeDim && f.wire == 2) dim = f.data;
+    }
+    for (const auto& f : parseMessage(dim)) {
+        if (f.number == kDimValue && f.wire == 0) return static_cast<int64_t>(f.value);
+    }
+    return std::nullopt;
+}
+
+// 缓存的裁剪模型是否可用：非空、计算图完整可解析，且输出的类别维（静态时）等于保留的类别数
+bool validPrunedModel(const fs::path& path, size_t classes) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (ec || size == 0) return false;
+    try {
+        std::string model = readFile(path.string());
+        std::string_view graph;
+        for (const auto& f : parseMessage(model)) {
+            if (f.number == kModelGraph) graph = f.data;
+        }
+        for (const auto& f : parseMessage(graph)) {
+            if (f.number != kGraphOutput) continue;
+            auto dim = lastDim(f.data);
+            return !dim || *dim == static_cast<int64_t>(classes);
+        }
+    } catch (const std::exception&) {
+        // 截断或损坏
+    }
+    return false;
+}
+
+// 删除同一模型的其他裁剪缓存与遗留的临时文件；较新的临时文件可能正被其他实例写入，保留
+void removeStaleCaches(const fs::path& source, const fs::path& current) {
+    fs::path dir = source.has_parent_path() ? source.parent_path() : fs::path(".");
+    std::string prefix = source.stem().string() + ".pruned-";
+    auto now = fs::file_time_type::clock::now();
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path& path = it->path();
+        std::string name = path.filename().string();
+        if (path.filename() == current.filename() || name.rfind(prefix, 0) != 0) continue;
+        if (name.find(".onnx.tmp") != std::string::npos) {
+            std::error_code time_ec;
+            auto mtime = fs::last_write_time(path, time_ec);
+            if (time_ec || now - mtime < std::chrono::minutes(10)) continue;
+        } else if (path.extension() != ".onnx") {
+            continue;
+        }
+        // 文件被占用（如 Windows 上其他实例已加载）时删除失败，下次加载再试
+        std::error_code remove_ec;
+        fs::remove(path, remove_ec);
+    }
+}
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+std::string pruneClassifierHead(const std::string& model, size_t min_classes, const std::vector<int>& keep) {
+    auto model_fields = parseMessage(model);
+    std::string_view graph;
+    for (const auto& f : model_fields) {
+        if (f.number == kModelGraph) graph = f.data;
+    }
+    if (graph.empty()) throw std::runtime_error("模型中没有计算图");
+    auto graph_fields = parseMessage(graph);
+
+    // 权重来源：initializer 或 Constant 节点，名称 -> graph 字段下标
+    std::map<std::string, size_t> initializers, constants;
+    std::vector<std::optional<NodeInfo>> nodes(graph_fields.size());
+    for (size_t i = 0; i < graph_fields.size(); i++) {
+        const auto& f = graph_fields[i];
+        if (f.number == kGraphInitializer) {
+            for (const auto& t : parseMessage(f.data)) {
+                if (t.number == kTensorName) initializers.emplace(std::string(t.data), i);
+            }
+        } else if (f.number == kGraphNode) {
+            nodes[i] = parseNode(f.data);
+            if (nodes[i]->op_type == "Constant" && !nodes[i]->outputs.empty() &&
+                nodes[i]->attributes.count("value")) {
+                constants.emplace(nodes[i]->outputs[0], i);
+            }
+        }
+    }
+    auto tensor = [&](const std::string& name) -> std::optional<std::string_view> {
+        if (auto it = initializers.find(name); it != initializers.end()) return graph_fields[it->second].data;
+        if (auto it = constants.find(name); it != constants.end()) return nodes[it->second]->attributes.at("value").data;
+        return std::nullopt;
+    };
+
+    // 找类别数最多（且不少于 min_classes）的 MatMul / Gemm 作为分类层
+    std::string weight_name, bias_name;
+    int weight_axis = 1;
+    int64_t classes = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i] || nodes[i]->inputs.size() < 2) continue;
+        const NodeInfo& node = *nodes[i];
+        if (node.op_type != "MatMul" && node.op_type != "Gemm") continue;
+        auto w = tensor(node.inputs[1]);
+        if (!w) continue;
+        auto dims = tensorDims(*w);
+        if (dims.size() != 2) continue;
+        int axis = 1;
+        if (node.op_type == "Gemm" && node.attributes.count("transB") && node.attributes.at("transB").value) axis = 0;
+        if (dims[axis] < static_cast<int64_t>(min_classes) || dims[axis] <= classes) continue;
+
+        classes = dims[axis];
+        weight_name = node.inputs[1];
+        weight_axis = axis;
+        bias_name.clear();
+        if (node.op_type == "Gemm") {
+            if (node.inputs.size() > 2) bias_name = node.inputs[2];
+        } else {
+            // MatMul 之后紧接的 Add 偏置
+            for (const auto& add : nodes) {
+                if (!add || add->op_type != "Add" || add->inputs.size() != 2) continue;
+                for (int k = 0; k < 2; k++) {
+                    if (add->inputs[k] != node.outputs[0]) continue;
+                    auto b = tensor(add->inputs[1 - k]);
+                    if (b && tensorDims(*b) == std::vector<int64_t>{classes}) bias_name = add->inputs[1 - k];
+                }
+            }
+        }
+    }
+    if (classes == 0) throw std::runtime_error("找不到类别数不少于 " + std::to_string(min_classes) + " 的分类层");
+    for (int k : keep) {
+        if (k < 0 || k >= classes) throw std::runtime_error("保留的类别下标越界");
+    }
+
+    std::map<std::string, std::string> replaced;
+    replaced[weight_name] = sliceTensor(*tensor(weight_name), weight_axis, keep);
+    if (!bias_name.empty()) replaced[bias_name] = sliceTensor(*tensor(bias_name), 0, keep);
+
+    std::string new_graph;
+    for (size_t i = 0; i < graph_fields.size(); i++) {
+        const auto& f = graph_fields[i];
+        if (f.number == kGraphValueInfo) {
+            continue; // 中间形状随分类层改变，交由 ONNX Runtime 重新推导
+        }
+        if (f.number == kGraphOutput) {
+            writeBytesField(new_graph, kGraphOutput, rewriteDims(f.data, classes, static_cast<int64_t>(keep.size())));
+            continue;
+        }
+        bool done = false;
+        for (const auto& [name, data] : replaced) {
+            if (auto it = initializers.find(name); it != initializers.end() && it->second == i) {
+                writeBytesField(new_graph, kGraphInitializer, data);
+                done = true;
+            } else if (auto it = constants.find(name); it != constants.end() && it->second == i) {
+                writeBytesField(new_graph, kGraphNode, replaceConstant(f.data, data));
+                done = true;
+            }
+        }
+        if (!done) new_graph.append(f.raw);
+    }
+
+    std::string out;
+    for (const auto& f : model_fields) {
+        if (f.number == kModelGraph) writeBytesField(out, kModelGraph, new_graph);
+        else out.append(f.raw);
+    }
+    return out;
+}
+
+PrunedRecModel pruneRecognizerHead(const std::string& model_path,
+                                   const std::vector<std::string>& characters,
+                                   const std::string& vocab_path) {
+    // 字典读取失败时类别数未知，无法定位分类层
+    if (characters.size() < 2) throw std::runtime_error("识别字典为空");
+
+    // 词表中出现的字符（按 UTF-8 切分）
+    std::ifstream vocab(vocab_path);
+    if (!vocab.is_open()) throw std::runtime_error("无法打开词表: " + vocab_path);
+    std::set<std::string> wanted;
+    std::string line;
+    while (std::getline(vocab, line)) {
+        for (size_t i = 0; i < line.size();) {
+            unsigned char lead = line[i];
+            size_t len = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            std::string ch = line.substr(i, len);
+            if (ch != "\r" && ch != " ") wanted.insert(ch);
+            i += len;
+        }
+    }
+
+    PrunedRecModel result;
+    std::vector<int> keep{0};
+    result.characters.push_back(characters.empty() ? " " : characters[0]);
+    for (size_t i = 1; i < characters.size(); i++) {
+        if (wanted.erase(characters[i])) {
+            keep.push_back(static_cast<int>(i));
+            result.characters.push_back(characters[i]);
+        }
+    }
+    if (!wanted.empty()) {
+        std::cerr << "词表中有 " << wanted.size() << " 个字符不在识别字典中，已忽略" << std::endl;
+    }
+
+    // 缓存文件名：原模型大小、修改时间与保留类别的散列
+    uint64_t hash = 14695981039346656037ULL;
+    auto size = fs::file_size(model_path);
+    auto mtime = fs::last_write_time(model_path).time_since_epoch().count();
+    hash = fnv1a(hash, &size, sizeof(size));
+    hash = fnv1a(hash, &mtime, sizeof(mtime));
+    hash = fnv1a(hash, keep.data(), keep.size() * sizeof(int));
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    fs::path source(model_path);
+    fs::path cached = source.parent_path() / (source.stem().string() + ".pruned-" + hex + ".onnx");
+    result.model_path = cached.string();
+
+    if (fs::exists(cached)) {
+        if (validPrunedModel(cached, keep.size())) {
+            result.from_cache = true;
+            removeStaleCaches(source, cached);
+            return result;
+        }
+        std::cerr << "裁剪模型缓存无效，重新生成: " << cached.string() << std::endl;
+        std::error_code ec;
+        fs::remove(cached, ec);
+    }
+
+    std::string pruned = pruneClassifierHead(readFile(model_path), characters.size(), keep);
+    // 先写临时文件再改名，避免多个实例同时生成时读到不完整的文件
+    fs::path tmp = cached;
+    tmp += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    try {
+        std::ofstream out(tmp, std::ios::binary);
+        if (!out.is_open()) throw std::runtime_error("无法写入裁剪模型缓存: " + tmp.string());
+        out.write(pruned.data(), static_cast<std::streamsize>(pruned.size()));
+        out.close();
+        if (!out) throw std::runtime_error("写入裁剪模型缓存失败: " + tmp.string());
+        fs::rename(tmp, cached);
+    } catch (...) {
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        throw;
+    }
+    removeStaleCaches(source, cached);
+    return result;
+}
@@ -0,0 +1,101 @@
+#include "ocr_session_config.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <json/json.h>
+
+namespace {
+
+std::optional<GraphOptimizationLevel> parseOptimizationLevel(const std::string& level) {
+    if (level == "disable") return ORT_DISABLE_ALL;
+    if (level == "basic") return ORT_ENABLE_BASIC;
+    if (level == "extended") return ORT_ENABLE_EXTENDED;
+    if (level == "all") return ORT_ENABLE_ALL;
+    return std::nullopt;
+}
+
+// 读取 j 中出现的字段，覆盖 config 中的同名项
+void apply(const Json::Value& j, OrtSessionConfig& config) {
+    if (j.isMember("intra_op_threads")) config.intra_op_threads = j["intra_op_threads"].asInt();
+    if (j.isMember("inter_op_threads")) config.inter_op_threads = j["inter_op_threads"].asInt();
+    if (j.isMember("graph_optimization")) {
+        std::string level = j["graph_optimization"].asString();
+        if (parseOptimizationLevel(level)) {
+            config.graph_optimization = level;
+        } else {
+            std::cerr << "未知的图优化级别: " << level << "（可选 disable / basic / extended / all），已忽略" << std::endl;
+        }
+    }
+    if (j.isMember("execution_mode")) {
+        std::string mode = j["execution_mode"].asString();
+        if (mode == "sequential" || mode == "parallel") {
+            config.parallel_execution = mode == "parallel";
+        } else {
+            std::cerr << "未知的执行模式: " << mode << "（可选 sequential / parallel），已忽略" << std::endl;
+        }
+    }
+    if (j.isMember("mem_pattern")) config.mem_pattern = j["mem_pattern"].asBool();
+    if (j.isMember("cpu_arena")) config.cpu_arena = j["cpu_arena"].asBool();
+    if (j.isMember("allow_spinning")) config.allow_spinning = j["allow_spinning"].asBool();
+}
+
+} // namespace
+
+Ort::SessionOptions OrtSessionConfig::build() const {
+    Ort::SessionOptions options;
+    if (intra_op_threads) options.SetIntraOpNumThreads(*intra_op_threads);
+    if (inter_op_threads) options.SetInterOpNumThreads(*inter_op_threads);
+    if (graph_optimization) {
+        if (auto level = parseOptimizationLevel(*graph_optimization)) {
+            options.SetGraphOptimizationLevel(*level);
+        }
+    }
+    if (parallel_execution) options.SetExecutionMode(*parallel_execution ? ORT_PARALLEL : ORT_SEQUENTIAL);
+    if (mem_pattern) {
+        *mem_pattern ? options.EnableMemPattern() : options.DisableMemPattern();
+    }
+    if (cpu_arena) {
+        *cpu_arena ? options.EnableCpuMemArena() : options.DisableCpuMemArena();
+    }
+    if (allow_spinning) {
+        const char* value = *allow_spinning ? "1" : "0";
+        options.AddConfigEntry("session.intra_op.allow_spinning", value);
+        options.AddConfigEntry("session.inter_op.allow_spinning", value);
+    }
+    return options;
+}
+
+OcrRuntimeConfig OcrRuntimeConfig::load(const std::string& path) {
+    OcrRuntimeConfig config;
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "无法打开 OCR 运行配置: " << path << std::endl;
+        return config;
+    }
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if (!Json::parseFromStream(builder, file, &root, &errors)) {
+        std::cerr << "OCR 运行配置解析失败: " << errors << std::endl;
+        return config;
+    }
+
+    apply(root, config.det);
+    apply(root, config.rec);
+    if (root.isMember("det")) apply(root["det"], config.det);
+    if (root.isMember("rec")) {
+        apply(root["rec"], config.rec);
+        if (root["rec"].isMember("batch_size")) {
+            config.rec_batch_size = std::max(1, root["rec"]["batch_size"].asInt());
+        }
+        if (root["rec"].isMember("vocabulary")) {
+            std::filesystem::path vocab = root["rec"]["vocabulary"].asString();
+            if (vocab.is_relative()) {
+                vocab = std::filesystem::path(path).parent_path() / vocab;
+            }
+            config.rec_vocabulary = vocab.string();
+        }
+    }
+    return config;
+}
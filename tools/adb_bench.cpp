@@ -0,0 +1,161 @@
+// ADB 截图链路基准测试
+// 用法: adb_bench <device_id>[,<device_id>...] [iterations]
+// 对比 PNG / RAW / FRAMEBUFFER / GZIP_RAW 传输方式从发起截图到得到 BGR 图像的耗时，
+// 并输出 ADBClient 累计的带宽与解压 CPU 统计；
+// 最后对比 N 台设备逐台阻塞截图与单事件循环并发（协程）截图一轮的耗时
+#include "adb/ADBClient.hpp"
+#include "vision/frame_convert.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchResult {
+    std::string name;
+    std::vector<double> samples_ms;
+    size_t payload_bytes = 0;
+    int failures = 0;
+};
+
+void print_result(const BenchResult& r) {
+    if (r.samples_ms.empty()) {
+        std::cout << r.name << ": 全部失败 (" << r.failures << ")" << std::endl;
+        return;
+    }
+    auto sorted = r.samples_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double v : sorted) sum += v;
+    auto pct = [&](double p) { return sorted[static_cast<size_t>(p * (sorted.size() - 1))]; };
+    std::cout << r.name
+              << ": avg " << sum / sorted.size() << "ms"
+              << ", p50 " << pct(0.5) << "ms"
+              << ", p95 " << pct(0.95) << "ms"
+              << ", min " << sorted.front() << "ms"
+              << ", 传输 " << r.payload_bytes / 1024 << "KiB/帧"
+              << ", 失败 " << r.failures << std::endl;
+}
+
+template <typename Fn>
+BenchResult run(const std::string& name, int iterations, Fn&& capture) {
+    BenchResult r;
+    r.name = name;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        size_t bytes = 0;
+        if (capture(bytes)) {
+            r.samples_ms.push_back(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count());
+            r.payload_bytes = bytes;
+        } else {
+            r.failures++;
+        }
+    }
+    return r;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <device_id>[,<device_id>...] [iterations]" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> devices;
+    std::istringstream device_list(argv[1]);
+    for (std::string id; std::getline(device_list, id, ',');) {
+        if (!id.empty()) devices.push_back(id);
+    }
+    if (devices.empty()) {
+        return 1;
+    }
+    const std::string& device = devices.front();
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    ADBClient adb("/tmp");
+    std::string png;
+    AdbRawFrame raw;
+    cv::Mat bgr;
+
+    print_result(run("PNG (screencap -p + imdecode)", iterations, [&](size_t& bytes) {
+        if (!adb.capture_png(device, png)) return false;
+        bytes = png.size();
+        bgr = cv::imdecode(cv::Mat(1, static_cast<int>(png.size()), CV_8UC1, png.data()), cv::IMREAD_COLOR);
+        return !bgr.empty();
+    }));
+    print_result(run("RAW (screencap + cvtColor)", iterations, [&](size_t& bytes) {
+        if (!adb.capture_raw(device, raw, AdbCaptureMode::RAW)) return false;
+        bytes = raw.pixels.size();
+        return rawFrameToBgr(raw, bgr);
+    }));
+    // 局部截图：取屏幕 20%~30% 高度的一条横带（约等于一个 ROI 所需的行）
+    uint32_t band_first = raw.height / 5;
+    uint32_t band_count = std::max<uint32_t>(1, raw.height / 10);
+    print_result(run("PARTIAL (10% 行 + cvtColor)", iterations, [&](size_t& bytes) {
+        if (!adb.capture_rows(device, {{band_first, band_count}}, raw)) return false;
+        bytes = 0;
+        for (const auto& r : raw.valid_rows) bytes += r.count * raw.row_bytes();
+        return rawFrameToBgr(raw, bgr);
+    }));
+    print_result(run("FRAMEBUFFER (framebuffer: + cvtColor)", iterations, [&](size_t& bytes) {
+        if (!adb.capture_raw(device, raw, AdbCaptureMode::FRAMEBUFFER)) return false;
+        bytes = raw.pixels.size();
+        return rawFrameToBgr(raw, bgr);
+    }));
+    print_result(run("GZIP_RAW (screencap | gzip -1 + inflate + cvtColor)", iterations, [&](size_t& bytes) {
+        if (!adb.capture_raw(device, raw, AdbCaptureMode::GZIP_RAW)) return false;
+        bytes = raw.pixels.size();
+        return rawFrameToBgr(raw, bgr);
+    }));
+
+    const char* names[] = {"PNG", "RAW", "FRAMEBUFFER", "GZIP_RAW"};
+    std::cout << "\n传输统计（每帧平均）:" << std::endl;
+    for (const auto& [mode, stats] : adb.capture_stats(device)) {
+        if (stats.frames == 0) continue;
+        std::cout << "  " << names[static_cast<int>(mode)]
+                  << ": 传输 " << stats.wire_bytes / stats.frames / 1024 << "KiB"
+                  << ", 压缩比 " << stats.compression_ratio()
+                  << ", 耗时 " << stats.avg_ms() << "ms"
+                  << ", 解压 CPU " << stats.decode_seconds * 1000.0 / stats.frames << "ms" << std::endl;
+    }
+
+    // 多设备：每轮每台设备各截一帧原始图
+    std::cout << "\n" << devices.size() << " 台设备每轮各截一帧 (RAW):" << std::endl;
+    std::vector<AdbRawFrame> frames(devices.size());
+    print_result(run("阻塞逐台", iterations, [&](size_t& bytes) {
+        bytes = 0;
+        for (size_t i = 0; i < devices.size(); ++i) {
+            if (!adb.capture_raw(devices[i], frames[i], AdbCaptureMode::RAW)) return false;
+            bytes += frames[i].pixels.size();
+        }
+        return true;
+    }));
+    print_result(run("协程并发", iterations, [&](size_t& bytes) {
+        std::promise<void> done;
+        std::atomic<size_t> pending{devices.size()};
+        std::atomic<bool> all_ok{true};
+        for (size_t i = 0; i < devices.size(); ++i) {
+            boost::asio::co_spawn(adb.io_context(),
+                [&, i]() -> boost::asio::awaitable<void> {
+                    if (!co_await adb.async_capture_raw(devices[i], frames[i], AdbCaptureMode::RAW)) {
+                        all_ok = false;
+                    }
+                    if (--pending == 0) done.set_value();
+                },
+                boost::asio::detached);
+        }
+        done.get_future().wait();
+        bytes = 0;
+        for (const auto& f : frames) bytes += f.pixels.size();
+        return all_ok.load();
+    }));
+    return 0;
+}
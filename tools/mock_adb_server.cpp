@@ -0,0 +1,1256 @@
+// 本地模拟 ADB Server：无需模拟器即可驱动 ADBClient 全链路，用于离线基准测试与调试
+// 用法: mock_adb_server [选项]
+//   --port N            监听端口（默认 5037）
+//   --devices N         模拟设备数量，序列号 emulator-5554、emulator-5556 ...（默认 1）
+//   --screens DIR       预置截图目录：*.raw 为 screencap 原始输出，*.png 为 PNG，按文件名顺序轮流返回
+//   --size WxH          无预置截图时生成的测试画面尺寸（默认 1280x720）
+//   --root DIR          sync:/exec: 文件操作映射到的本地目录（默认 ./mock_device）
+//   --latency-ms N      每条命令（服务请求、会话中的每行命令）的额外延迟
+//   --bandwidth-kbps N  下行带宽上限（KiB/s），0 为不限
+//   --tap-log FILE      触摸记录同时追加写入文件
+//   --evdev             允许写 /dev/input/event1（默认拒绝，客户端退回 input tap）
+//   --flap-ms N         每 N ms 让一台设备轮流掉线 N ms 后重连（transport_id 变化），用于测试设备跟踪与故障切换
+//   --adbd-port N       同时在该端口模拟第一台设备的 adbd，以 ADB 线协议（CNXN/AUTH/OPEN/WRTE/OKAY/CLSE）直连
+//   --adbd-keys FILE    adbd 已授权的公钥文件（adb_keys 格式）；收到新公钥时视为用户已允许并追加写入
+//
+// 支持的服务：host:version / host:devices / host:devices-l / host:track-devices / host:track-devices-l /
+// host:connect: / host:disconnect: /
+// host-serial:<id>:features / host:transport:<id> / host:transport-any，
+// 设备服务 shell: / exec: / exec-out: / shell,v2,raw: / sync:（STAT/RECV/SEND/QUIT）。
+// shell:logcat 每 100 ms 输出一行，不会自行结束。
+// 模拟 adbd 要求 RSA 认证：签名能被已授权公钥验证即通过，否则接受客户端随后发送的公钥；
+// 其上的服务流与经 ADB Server 转发的服务行为相同。
+// shell 命令由内置的最小解释器执行（input、screencap、dd、gzip、getevent、wm、getprop、rm 等），不会在主机上执行。
+#include <boost/asio.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/param_build.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
+#include <sys/socket.h>
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace asio = boost::asio;
+namespace fs = std::filesystem;
+using asio::awaitable;
+using asio::use_awaitable;
+using asio::ip::tcp;
+
+namespace {
+
+// 注意：co_await 表达式中不要直接传临时 std::string（GCC 12 协程对临时对象的生命周期处理有缺陷），先存入具名变量
+
+struct Options {
+    uint16_t port = 5037;
+    int devices = 1;
+    std::string screens_dir;
+    int width = 1280;
+    int height = 720;
+    fs::path root = "mock_device";
+    int latency_ms = 0;
+    int bandwidth_kbps = 0;
+    std::string tap_log;
+    bool evdev = false;
+    int flap_ms = 0;
+    uint16_t adbd_port = 0;
+    std::string adbd_keys;
+};
+
+// 触摸屏节点与上报范围（与 --size 一致，旋转固定为 0）
+constexpr std::string_view TOUCH_NODE = "/dev/input/event1";
+// 模拟 64 位用户态，input_event 为 24 字节
+constexpr size_t EVENT_SIZE = 24;
+
+void put_le32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+void put_be32(std::string& out, uint32_t value) {
+    for (int i = 3; i >= 0; --i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+uint32_t get_le32(const char* src) {
+    auto b = reinterpret_cast<const unsigned char*>(src);
+    return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+           (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+}
+
+// 最小 PNG 编码（RGBA8，无滤波），供只有原始帧时应答 screencap -p
+std::string encode_png(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    std::string scanlines;
+    scanlines.reserve(static_cast<size_t>(width * 4 + 1) * height);
+    for (uint32_t y = 0; y < height; ++y) {
+        scanlines.push_back('\0');
+        scanlines.append(reinterpret_cast<const char*>(rgba + static_cast<size_t>(y) * width * 4), width * 4);
+    }
+    uLongf packed_size = compressBound(static_cast<uLong>(scanlines.size()));
+    std::string packed(packed_size, '\0');
+    compress2(reinterpret_cast<Bytef*>(packed.data()), &packed_size,
+              reinterpret_cast<const Bytef*>(scanlines.data()), static_cast<uLong>(scanlines.size()), 1);
+    packed.resize(packed_size);
+
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+    auto chunk = [&](std::string_view type, const std::string& data) {
+        put_be32(png, static_cast<uint32_t>(data.size()));
+        std::string body = std::string(type) + data;
+        png += body;
+        put_be32(png, static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(body.data()), static_cast<uInt>(body.size()))));
+    };
+    std::string ihdr;
+    put_be32(ihdr, width);
+    put_be32(ihdr, height);
+    ihdr += std::string("\x08\x06\x00\x00\x00", 5); // 8 位 RGBA
+    chunk("IHDR", ihdr);
+    chunk("IDAT", packed);
+    chunk("IEND", "");
+    return png;
+}
+
+// gzip 压缩（对应设备端 gzip -1）
+std::string gzip_compress(const std::string& input) {
+    z_stream zs{};
+    deflateInit2(&zs, 1, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, static_cast<uLong>(input.size())) + 32, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    zs.avail_in = static_cast<uInt>(input.size());
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+// 一帧预置截图
+struct Screen {
+    std::string raw;   // screencap 原始输出（含 16 字节头部）
+    std::string png;
+};
+
+// 生成测试画面：按行列渐变，便于肉眼与程序校验
+Screen generate_screen(int width, int height, int index) {
+    Screen screen;
+    put_le32(screen.raw, width);
+    put_le32(screen.raw, height);
+    put_le32(screen.raw, 1); // RGBA_8888
+    put_le32(screen.raw, 0); // colorspace
+    size_t header = screen.raw.size();
+    screen.raw.resize(header + static_cast<size_t>(width) * height * 4);
+    auto* pixels = reinterpret_cast<uint8_t*>(screen.raw.data() + header);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = pixels + (static_cast<size_t>(y) * width + x) * 4;
+            p[0] = static_cast<uint8_t>(x * 255 / std::max(1, width - 1));
+            p[1] = static_cast<uint8_t>(y * 255 / std::max(1, height - 1));
+            p[2] = static_cast<uint8_t>(index * 40);
+            p[3] = 255;
+        }
+    }
+    screen.png = encode_png(pixels, width, height);
+    return screen;
+}
+
+std::string read_file(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+// 命令执行结果
+struct CommandResult {
+    std::string out;
+    std::string err;
+    int code = 0;
+};
+
+// 简单分词：支持单双引号
+std::vector<std::string> tokenize(std::string_view cmd) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool has_token = false;
+    char quote = 0;
+    for (char c : cmd) {
+        if (quote) {
+            if (c == quote) quote = 0;
+            else current += c;
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            has_token = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (has_token) tokens.push_back(std::move(current));
+            current.clear();
+            has_token = false;
+        } else {
+            current += c;
+            has_token = true;
+        }
+    }
+    if (has_token) tokens.push_back(std::move(current));
+    return tokens;
+}
+
+// 按分隔符切分（不处理引号内的分隔符，模拟命令足够）
+std::vector<std::string> split(std::string_view text, std::string_view delim) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t pos = text.find(delim, start);
+        parts.emplace_back(text.substr(start, pos == std::string_view::npos ? std::string_view::npos : pos - start));
+        if (pos == std::string_view::npos) break;
+        start = pos + delim.size();
+    }
+    return parts;
+}
+
+// dd 参数 key=value 取值
+std::optional<uint64_t> dd_arg(const std::vector<std::string>& args, std::string_view key) {
+    for (const auto& arg : args) {
+        if (arg.starts_with(key) && arg.size() > key.size() && arg[key.size()] == '=') {
+            return std::stoull(arg.substr(key.size() + 1));
+        }
+    }
+    return std::nullopt;
+}
+
+// ========== 模拟 adbd：线协议与认证 ==========
+
+constexpr uint32_t A_CNXN = 0x4e584e43;
+constexpr uint32_t A_AUTH = 0x48545541;
+constexpr uint32_t A_OPEN = 0x4e45504f;
+constexpr uint32_t A_OKAY = 0x59414b4f;
+constexpr uint32_t A_CLSE = 0x45534c43;
+constexpr uint32_t A_WRTE = 0x45545257;
+constexpr uint32_t A_VERSION = 0x01000001;
+// 设备端最大负载，小于客户端的 1 MiB，用于验证双方取较小值
+constexpr uint32_t ADBD_MAX_PAYLOAD = 256 * 1024;
+constexpr uint32_t AUTH_TOKEN = 1;
+constexpr uint32_t AUTH_SIGNATURE = 2;
+constexpr uint32_t AUTH_RSAPUBLICKEY = 3;
+constexpr size_t AUTH_TOKEN_SIZE = 20;
+
+struct AdbdPacket {
+    uint32_t command = 0;
+    uint32_t arg0 = 0;
+    uint32_t arg1 = 0;
+    std::string payload;
+};
+
+std::string adbd_packet(uint32_t command, uint32_t arg0, uint32_t arg1, std::string_view payload) {
+    std::string packet;
+    packet.reserve(24 + payload.size());
+    put_le32(packet, command);
+    put_le32(packet, arg0);
+    put_le32(packet, arg1);
+    put_le32(packet, static_cast<uint32_t>(payload.size()));
+    put_le32(packet, 0); // 协议版本 0x01000001 起不校验
+    put_le32(packet, command ^ 0xffffffff);
+    packet += payload;
+    return packet;
+}
+
+awaitable<AdbdPacket> read_adbd_packet(tcp::socket& socket) {
+    char header[24];
+    co_await asio::async_read(socket, asio::buffer(header, 24), use_awaitable);
+    AdbdPacket packet;
+    packet.command = get_le32(header);
+    packet.arg0 = get_le32(header + 4);
+    packet.arg1 = get_le32(header + 8);
+    uint32_t length = get_le32(header + 12);
+    if (get_le32(header + 20) != (packet.command ^ 0xffffffff) || length > 1024 * 1024) {
+        throw std::runtime_error("adbd 报文头无效");
+    }
+    packet.payload.resize(length);
+    co_await asio::async_read(socket, asio::buffer(packet.payload.data(), length), use_awaitable);
+    co_return packet;
+}
+
+// 用 Android 格式公钥（base64(RSAPublicKey) [注释]）验证 AUTH 签名
+bool verify_adb_signature(const std::string& public_key, std::string_view token, std::string_view signature) {
+    std::string encoded = public_key.substr(0, public_key.find(' '));
+    std::string decoded(encoded.size() / 4 * 3 + 3, '\0');
+    int n = EVP_DecodeBlock(reinterpret_cast<unsigned char*>(decoded.data()),
+                            reinterpret_cast<const unsigned char*>(encoded.data()), static_cast<int>(encoded.size()));
+    // len(4) n0inv(4) n[256] rr[256] e(4)，均为小端
+    constexpr size_t MODULUS_SIZE = 256;
+    if (n < static_cast<int>(8 + MODULUS_SIZE * 2 + 4)) return false;
+    auto data = reinterpret_cast<const unsigned char*>(decoded.data());
+    BIGNUM* modulus = BN_lebin2bn(data + 8, MODULUS_SIZE, nullptr);
+    BIGNUM* exponent = BN_new();
+    BN_set_word(exponent, get_le32(decoded.data() + 8 + MODULUS_SIZE * 2));
+
+    OSSL_PARAM_BLD* builder = OSSL_PARAM_BLD_new();
+    OSSL_PARAM_BLD_push_BN(builder, OSSL_PKEY_PARAM_RSA_N, modulus);
+    OSSL_PARAM_BLD_push_BN(builder, OSSL_PKEY_PARAM_RSA_E, exponent);
+    OSSL_PARAM* params = OSSL_PARAM_BLD_to_param(builder);
+    EVP_PKEY_CTX* from_ctx = EVP_PKEY_CTX_new_from_name(nullptr, "RSA", nullptr);
+    EVP_PKEY* key = nullptr;
+    bool ok = from_ctx && EVP_PKEY_fromdata_init(from_ctx) > 0 &&
+              EVP_PKEY_fromdata(from_ctx, &key, EVP_PKEY_PUBLIC_KEY, params) > 0;
+    EVP_PKEY_CTX_free(from_ctx);
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(builder);
+    BN_free(modulus);
+    BN_free(exponent);
+    if (!ok) return false;
+
+    // 令牌即摘要：PKCS#1 v1.5 / SHA-1，与 adbd 的 RSA_verify(NID_sha1, ...) 一致
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, nullptr);
+    ok = ctx && EVP_PKEY_verify_init(ctx) > 0 &&
+         EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) > 0 &&
+         EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha1()) > 0 &&
+         EVP_PKEY_verify(ctx, reinterpret_cast<const unsigned char*>(signature.data()), signature.size(),
+                         reinterpret_cast<const unsigned char*>(token.data()), token.size()) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+class MockServer {
+public:
+    explicit MockServer(Options options) : options_(std::move(options)) {
+        for (int i = 0; i < options_.devices; ++i) {
+            serials_.push_back(std::format("emulator-{}", 5554 + 2 * i));
+            device_states_[serials_.back()] = {true, ++next_transport_id_};
+        }
+        load_screens();
+        fs::create_directories(options_.root);
+        if (!options_.tap_log.empty()) {
+            tap_log_.open(options_.tap_log, std::ios::app);
+        }
+        if (!options_.adbd_keys.empty()) {
+            std::ifstream keys(options_.adbd_keys);
+            for (std::string line; std::getline(keys, line);) {
+                if (!line.empty()) adbd_keys_.push_back(line);
+            }
+        }
+    }
+
+    awaitable<void> listen() {
+        auto executor = co_await asio::this_coro::executor;
+        tcp::acceptor acceptor(executor, {asio::ip::make_address("127.0.0.1"), options_.port});
+        std::cout << std::format("mock adb server 监听 127.0.0.1:{}，设备 {} 台，截图 {} 帧",
+                                 options_.port, serials_.size(), screens_.size()) << std::endl;
+        while (true) {
+            tcp::socket socket = co_await acceptor.async_accept(use_awaitable);
+            socket.set_option(tcp::no_delay(true));
+            asio::co_spawn(executor, handle(std::move(socket)), asio::detached);
+        }
+    }
+
+    // 设备轮流掉线重连
+    awaitable<void> flap() {
+        if (options_.flap_ms <= 0) co_return;
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        for (size_t i = 0;; ++i) {
+            const std::string& serial = serials_[i % serials_.size()];
+            timer.expires_after(std::chrono::milliseconds(options_.flap_ms));
+            co_await timer.async_wait(use_awaitable);
+            device_states_[serial].online = false;
+            std::cout << std::format("{} offline", serial) << std::endl;
+            notify_devices_changed();
+            timer.expires_after(std::chrono::milliseconds(options_.flap_ms));
+            co_await timer.async_wait(use_awaitable);
+            device_states_[serial] = {true, ++next_transport_id_};
+            std::cout << std::format("{} online", serial) << std::endl;
+            notify_devices_changed();
+        }
+    }
+
+    // 模拟第一台设备的 adbd：每条连接先认证，再以 OPEN/WRTE/OKAY/CLSE 多路复用服务流
+    awaitable<void> adbd_listen() {
+        if (options_.adbd_port == 0) co_return;
+        auto executor = co_await asio::this_coro::executor;
+        tcp::acceptor acceptor(executor, {asio::ip::make_address("127.0.0.1"), options_.adbd_port});
+        std::cout << std::format("mock adbd 监听 127.0.0.1:{}（{}），已授权公钥 {} 个",
+                                 options_.adbd_port, serials_.front(), adbd_keys_.size()) << std::endl;
+        while (true) {
+            tcp::socket socket = co_await acceptor.async_accept(use_awaitable);
+            socket.set_option(tcp::no_delay(true));
+            asio::co_spawn(executor, adbd_connection(std::move(socket)), asio::detached);
+        }
+    }
+
+private:
+    void load_screens() {
+        if (!options_.screens_dir.empty() && fs::is_directory(options_.screens_dir)) {
+            std::vector<fs::path> files;
+            for (const auto& entry : fs::directory_iterator(options_.screens_dir)) {
+                auto ext = entry.path().extension();
+                if (ext == ".raw" || ext == ".png") files.push_back(entry.path());
+            }
+            std::sort(files.begin(), files.end());
+            for (const auto& path : files) {
+                Screen screen;
+                if (path.extension() == ".raw") {
+                    screen.raw = read_file(path);
+                    if (screen.raw.size() < 16) continue;
+                    uint32_t w = get_le32(screen.raw.data());
+                    uint32_t h = get_le32(screen.raw.data() + 4);
+                    size_t header = screen.raw.size() - static_cast<size_t>(w) * h * 4;
+                    if (header == 12 || header == 16) {
+                        screen.png = encode_png(reinterpret_cast<const uint8_t*>(screen.raw.data() + header), w, h);
+                    }
+                } else {
+                    // 只有 PNG 时原始截图退回生成画面
+                    screen.png = read_file(path);
+                    screen.raw = generate_screen(options_.width, options_.height, static_cast<int>(screens_.size())).raw;
+                }
+                screens_.push_back(std::move(screen));
+            }
+        }
+        if (screens_.empty()) {
+            screens_.push_back(generate_screen(options_.width, options_.height, 0));
+        }
+    }
+
+    // 每次截图取下一帧（多帧时轮流返回，便于回放录制的画面序列）
+    const Screen& next_screen(const std::string& serial) {
+        size_t& index = screen_index_[serial];
+        const Screen& screen = screens_[index % screens_.size()];
+        index++;
+        return screen;
+    }
+
+    std::string device_list(bool long_format) const {
+        std::string list;
+        for (const auto& serial : serials_) {
+            const DeviceState& state = device_states_.at(serial);
+            const char* status = state.online ? "device" : "offline";
+            list += long_format
+                ? std::format("{:<22} {} product:mock model:Mock device:mock transport_id:{}\n", serial, status, state.transport_id)
+                : std::format("{}\t{}\n", serial, status);
+        }
+        return list;
+    }
+
+    void notify_devices_changed() {
+        devices_generation_++;
+        wake_trackers();
+    }
+
+    // 取消定时器即唤醒所有等待中的 track-devices 连接
+    void wake_trackers() {
+        if (devices_changed_) devices_changed_->cancel();
+    }
+
+    // track-devices：连接后立即推送一次完整列表，之后每次变化推送一次
+    awaitable<void> track_devices(tcp::socket& socket, bool long_format) {
+        if (!devices_changed_) {
+            devices_changed_.emplace(co_await asio::this_coro::executor, asio::steady_timer::time_point::max());
+        }
+        co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+        uint64_t sent = devices_generation_;
+        std::string message = std::format("{:04x}{}", device_list(long_format).size(), device_list(long_format));
+        co_await asio::async_write(socket, asio::buffer(message), use_awaitable);
+
+        // 同时等待客户端断开，断开后立即结束
+        struct Probe {
+            bool closed = false;
+            char byte = 0;
+        };
+        auto probe = std::make_shared<Probe>();
+        socket.async_read_some(asio::buffer(&probe->byte, 1), [this, probe](const boost::system::error_code&, size_t) {
+            probe->closed = true;
+            wake_trackers();
+        });
+        while (!probe->closed) {
+            boost::system::error_code ec;
+            co_await devices_changed_->async_wait(asio::redirect_error(use_awaitable, ec));
+            if (devices_generation_ == sent) continue;
+            sent = devices_generation_;
+            message = std::format("{:04x}{}", device_list(long_format).size(), device_list(long_format));
+            co_await asio::async_write(socket, asio::buffer(message), asio::redirect_error(use_awaitable, ec));
+            if (ec) co_return;
+        }
+    }
+
+    void log_touch(const std::string& serial, std::string_view what) {
+        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::string line = std::format("[{}] {} {}", now, serial, what);
+        std::cout << line << std::endl;
+        if (tap_log_) tap_log_ << line << std::endl;
+    }
+
+    // 设备路径映射到 --root 下，拒绝 .. 越界
+    std::optional<fs::path> map_path(std::string_view remote) const {
+        fs::path relative = fs::path(remote).relative_path().lexically_normal();
+        if (relative.empty() || *relative.begin() == "..") return std::nullopt;
+        return options_.root / relative;
+    }
+
+    awaitable<void> delay(int ms) {
+        if (ms <= 0) co_return;
+        asio::steady_timer timer(co_await asio::this_coro::executor, std::chrono::milliseconds(ms));
+        co_await timer.async_wait(use_awaitable);
+    }
+
+    // 按带宽上限分块发送
+    awaitable<void> send(tcp::socket& socket, std::string_view data) {
+        if (options_.bandwidth_kbps <= 0) {
+            co_await asio::async_write(socket, asio::buffer(data.data(), data.size()), use_awaitable);
+            co_return;
+        }
+        constexpr auto TICK = std::chrono::milliseconds(10);
+        size_t per_tick = std::max<size_t>(1, static_cast<size_t>(options_.bandwidth_kbps) * 1024 / 100);
+        auto deadline = std::chrono::steady_clock::now();
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        for (size_t offset = 0; offset < data.size(); offset += per_tick) {
+            size_t n = std::min(per_tick, data.size() - offset);
+            co_await asio::async_write(socket, asio::buffer(data.data() + offset, n), use_awaitable);
+            deadline += TICK;
+            timer.expires_at(deadline);
+            co_await timer.async_wait(use_awaitable);
+        }
+    }
+
+    static awaitable<std::string> read_request(tcp::socket& socket) {
+        char len_buf[4];
+        co_await asio::async_read(socket, asio::buffer(len_buf, 4), use_awaitable);
+        size_t len = std::stoul(std::string(len_buf, 4), nullptr, 16);
+        std::string request(len, '\0');
+        co_await asio::async_read(socket, asio::buffer(request.data(), len), use_awaitable);
+        co_return request;
+    }
+
+    awaitable<void> reply(tcp::socket& socket, std::string_view payload) {
+        std::string data = std::format("OKAY{:04x}{}", payload.size(), payload);
+        co_await send(socket, data);
+    }
+
+    awaitable<void> fail(tcp::socket& socket, std::string message) {
+        std::string data = std::format("FAIL{:04x}{}", message.size(), message);
+        co_await asio::async_write(socket, asio::buffer(data), use_awaitable);
+    }
+
+    awaitable<void> handle(tcp::socket socket) {
+        try {
+            std::string request = co_await read_request(socket);
+            co_await delay(options_.latency_ms);
+
+            if (request == "host:version") {
+                co_await reply(socket, "0029");
+            } else if (request == "host:devices" || request == "host:devices-l") {
+                std::string list = device_list(request == "host:devices-l");
+                co_await reply(socket, list);
+            } else if (request == "host:track-devices" || request == "host:track-devices-l") {
+                co_await track_devices(socket, request == "host:track-devices-l");
+            } else if (request.starts_with("host:connect:")) {
+                std::string message = std::format("connected to {}", request.substr(13));
+                co_await reply(socket, message);
+            } else if (request.starts_with("host:disconnect:")) {
+                std::string message = std::format("disconnected {}", request.substr(16));
+                co_await reply(socket, message);
+            } else if (request.starts_with("host-serial:") && request.ends_with(":features")) {
+                co_await reply(socket, "shell_v2,cmd,stat_v2");
+            } else if (request.starts_with("host:transport:") || request == "host:transport-any") {
+                std::string serial = request == "host:transport-any" ? serials_.front() : request.substr(15);
+                if (std::find(serials_.begin(), serials_.end(), serial) == serials_.end()) {
+                    co_await fail(socket, std::format("device '{}' not found", serial));
+                    co_return;
+                }
+                if (!device_states_[serial].online) {
+                    co_await fail(socket, "device offline");
+                    co_return;
+                }
+                co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+                std::string service = co_await read_request(socket);
+                co_await delay(options_.latency_ms);
+                co_await device_service(socket, serial, service);
+            } else {
+                co_await fail(socket, std::format("unknown host service: {}", request));
+            }
+        } catch (const std::exception&) {
+            // 客户端断开
+        }
+    }
+
+    // logcat：每 100 ms 输出一行，直到客户端断开（参数忽略）
+    awaitable<void> logcat(tcp::socket& socket, const std::string& serial) {
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        for (uint64_t tick = 0;; ++tick) {
+            auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            std::string line = std::format("{}  1234  1234 I MockGame: {} tick {}\r\n", now, serial, tick);
+            co_await send(socket, line);
+            timer.expires_after(std::chrono::milliseconds(100));
+            co_await timer.async_wait(use_awaitable);
+        }
+    }
+
+    awaitable<void> device_service(tcp::socket& socket, const std::string& serial, const std::string& service) {
+        if (service == "sync:") {
+            co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+            co_await sync_session(socket);
+        } else if (service == "shell,v2,raw:" || service == "exec:sh") {
+            co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+            co_await shell_session(socket, serial, service != "exec:sh");
+        } else if (service.starts_with("exec:cat >")) {
+            co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+            co_await stdin_sink(socket, serial, service.substr(5));
+        } else if (service == "shell:logcat" || service.starts_with("shell:logcat ")) {
+            co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+            co_await logcat(socket, serial);
+        } else if (service.starts_with("shell:") || service.starts_with("exec:") || service.starts_with("exec-out:")) {
+            std::string command = service.substr(service.find(':') + 1);
+            co_await asio::async_write(socket, asio::buffer("OKAY", 4), use_awaitable);
+            CommandResult result = run(serial, command);
+            // shell: 经 pty 时标准错误与输出合并
+            if (service.starts_with("shell:")) {
+                result.out += result.err;
+            }
+            co_await send(socket, result.out);
+        } else {
+            co_await fail(socket, std::format("unknown service: {}", service));
+        }
+    }
+
+    // 执行由 ; 分隔、&& 连接的管道命令，各段输出依次拼接；
+    // 另支持 VAR=$? 保存退出码与 exit $VAR / exit $?
+    CommandResult run(const std::string& serial, std::string_view command) {
+        CommandResult result;
+        std::map<std::string, int> vars;
+        for (const auto& list : split(command, ";")) {
+            auto words = tokenize(list);
+            if (words.size() == 1 && words[0].ends_with("=$?")) {
+                vars[words[0].substr(0, words[0].size() - 3)] = result.code;
+                continue;
+            }
+            if (!words.empty() && words[0] == "exit") {
+                if (words.size() >= 2 && words[1] != "$?") {
+                    auto it = vars.find(words[1].substr(words[1].starts_with('$') ? 1 : 0));
+                    result.code = it != vars.end() ? it->second : std::atoi(words[1].c_str());
+                }
+                break;
+            }
+            for (const auto& part : split(list, "&&")) {
+                CommandResult stage_result;
+                std::string input;
+                for (const auto& stage : split(part, "|")) {
+                    stage_result = run_stage(serial, stage, input);
+                    if (stage_result.code != 0) break;
+                    input = stage_result.out;
+                }
+                result.out += stage_result.out;
+                result.err += stage_result.err;
+                result.code = stage_result.code;
+                if (result.code != 0) break;
+            }
+        }
+        return result;
+    }
+
+    CommandResult run_stage(const std::string& serial, std::string_view stage, const std::string& input) {
+        auto args = tokenize(stage);
+        // 丢弃 2>/dev/null 之类的重定向
+        std::erase_if(args, [](const std::string& a) { return a.starts_with("2>"); });
+        CommandResult result;
+        if (args.empty()) return result;
+        const std::string& cmd = args[0];
+
+        if (cmd == "echo") {
+            for (size_t i = 1; i < args.size(); ++i) {
+                result.out += (i > 1 ? " " : "") + args[i];
+            }
+            result.out += '\n';
+        } else if (cmd == "true") {
+        } else if (cmd == "false") {
+            result.code = 1;
+        } else if (cmd == "input" && args.size() >= 2) {
+            std::string what = args[1];
+            for (size_t i = 2; i < args.size(); ++i) what += " " + args[i];
+            log_touch(serial, what);
+        } else if (cmd == "screencap") {
+            const Screen& screen = next_screen(serial);
+            bool png = std::find(args.begin(), args.end(), "-p") != args.end();
+            auto target = std::find_if(args.begin() + 1, args.end(), [](const std::string& a) { return a[0] != '-'; });
+            if (target != args.end()) {
+                // screencap <file>：写入设备文件
+                if (auto path = map_path(*target)) {
+                    fs::create_directories(path->parent_path());
+                    std::ofstream(*path, std::ios::binary) << (png ? screen.png : screen.raw);
+                }
+            } else {
+                result.out = png ? screen.png : screen.raw;
+            }
+        } else if (cmd == "gzip") {
+            result.out = gzip_compress(input);
+        } else if (cmd == "dd") {
+            std::string data = input;
+            for (const auto& arg : args) {
+                if (arg.starts_with("if=")) {
+                    auto path = map_path(arg.substr(3));
+                    data = path ? read_file(*path) : std::string{};
+                }
+            }
+            // 只支持 iflag=skip_bytes,count_bytes 的字节偏移形式
+            uint64_t skip = dd_arg(args, "skip").value_or(0);
+            uint64_t count = dd_arg(args, "count").value_or(data.size());
+            result.out = skip < data.size() ? data.substr(skip, count) : std::string{};
+        } else if (cmd == "rm") {
+            for (size_t i = 1; i < args.size(); ++i) {
+                if (args[i].starts_with("-")) continue;
+                if (auto path = map_path(args[i])) {
+                    std::error_code ec;
+                    fs::remove(*path, ec);
+                }
+            }
+        } else if (cmd == "tail" && args.size() >= 4 && args[1] == "-c" && args[2].starts_with("+")) {
+            auto path = map_path(args[3]);
+            std::string data = path ? read_file(*path) : std::string{};
+            size_t from = std::stoull(args[2].substr(1)) - 1;
+            result.out = from < data.size() ? data.substr(from) : std::string{};
+        } else if (cmd == "grep") {
+            // grep [-m N] PATTERN：按子串过滤
+            size_t max = SIZE_MAX;
+            size_t i = 1;
+            if (args.size() > 3 && args[1] == "-m") {
+                max = std::stoul(args[2]);
+                i = 3;
+            }
+            std::string pattern = i < args.size() ? args[i] : "";
+            std::istringstream lines(input);
+            for (std::string line; std::getline(lines, line) && max > 0;) {
+                if (line.find(pattern) != std::string::npos) {
+                    result.out += line + "\n";
+                    max--;
+                }
+            }
+            result.code = result.out.empty() ? 1 : 0;
+        } else if (cmd == "getevent") {
+            result.out = std::format(
+                "add device 1: {}\n"
+                "  name:     \"mock_touchscreen\"\n"
+                "  events:\n"
+                "    KEY (0001): BTN_TOUCH\n"
+                "    ABS (0003): ABS_MT_SLOT           : value 0, min 0, max 9, fuzz 0, flat 0, resolution 0\n"
+                "                ABS_MT_POSITION_X     : value 0, min 0, max {}, fuzz 0, flat 0, resolution 0\n"
+                "                ABS_MT_POSITION_Y     : value 0, min 0, max {}, fuzz 0, flat 0, resolution 0\n"
+                "                ABS_MT_TRACKING_ID    : value 0, min 0, max 65535, fuzz 0, flat 0, resolution 0\n",
+                TOUCH_NODE, options_.width - 1, options_.height - 1);
+        } else if (cmd == "test" && args.size() >= 3 && args[1] == "-w") {
+            result.code = (options_.evdev && args[2] == TOUCH_NODE) ? 0 : 1;
+        } else if (cmd == "wm" && args.size() >= 2 && args[1] == "size") {
+            result.out = std::format("Physical size: {}x{}\n", options_.width, options_.height);
+        } else if (cmd == "getprop") {
+            result.out = args.size() >= 2 && args[1] == "ro.product.cpu.abi" ? "arm64-v8a\n" : "\n";
+        } else if (cmd == "dumpsys") {
+            result.out = "    SurfaceOrientation: 0\n";
+        } else if (cmd == "am" || cmd == "sleep") {
+            // 启动应用等命令只记录
+            log_touch(serial, stage);
+        } else {
+            result.err = std::format("/system/bin/sh: {}: not found\n", cmd);
+            result.code = 127;
+        }
+        return result;
+    }
+
+    // 长连接 shell：逐行执行标准输入，shell v2 按 [id][len][payload] 分帧
+    awaitable<void> shell_session(tcp::socket& socket, const std::string& serial, bool v2) {
+        auto send_stream = [&](uint8_t id, const std::string& data) -> awaitable<void> {
+            if (data.empty()) co_return;
+            if (!v2) {
+                co_await send(socket, data);
+                co_return;
+            }
+            std::string packet(1, static_cast<char>(id));
+            put_le32(packet, static_cast<uint32_t>(data.size()));
+            packet += data;
+            co_await send(socket, packet);
+        };
+
+        bool merge_stderr = !v2;
+        int last_code = 0;
+        std::string pending;
+        std::string buffer(16 * 1024, '\0');
+        while (true) {
+            // 读取标准输入
+            if (v2) {
+                char header[5];
+                co_await asio::async_read(socket, asio::buffer(header, 5), use_awaitable);
+                uint32_t len = get_le32(header + 1);
+                std::string data(len, '\0');
+                co_await asio::async_read(socket, asio::buffer(data.data(), len), use_awaitable);
+                if (header[0] == 4) co_return; // 关闭标准输入
+                if (header[0] != 0) continue;
+                pending += data;
+            } else {
+                size_t n = co_await socket.async_read_some(asio::buffer(buffer), use_awaitable);
+                pending.append(buffer.data(), n);
+            }
+
+            size_t eol;
+            while ((eol = pending.find('\n')) != std::string::npos) {
+                std::string line = pending.substr(0, eol);
+                pending.erase(0, eol + 1);
+                // { cmd 与 } </dev/null 为客户端的包裹，去掉后按普通命令执行
+                if (line.starts_with("{ ")) line = line.substr(2);
+                if (line.starts_with("}")) continue;
+                if (line == "exec 2>&1") {
+                    merge_stderr = true;
+                    continue;
+                }
+                if (line.starts_with("exit")) {
+                    auto args = tokenize(line);
+                    int code = args.size() > 1 ? std::stoi(args[1]) : last_code;
+                    if (v2) {
+                        std::string status(1, static_cast<char>(code & 0xff));
+                        co_await send_stream(3, status);
+                    }
+                    co_return;
+                }
+                bool to_stderr = false;
+                if (line.ends_with(">&2")) {
+                    to_stderr = true;
+                    line.resize(line.size() - 3);
+                }
+                for (size_t pos; (pos = line.find("$?")) != std::string::npos;) {
+                    line.replace(pos, 2, std::to_string(last_code));
+                }
+                co_await delay(options_.latency_ms);
+                CommandResult result = run(serial, line);
+                last_code = result.code;
+                if (to_stderr) {
+                    result.err = result.out + result.err;
+                    result.out.clear();
+                }
+                if (merge_stderr) {
+                    result.out += result.err;
+                    co_await send_stream(1, result.out);
+                } else {
+                    co_await send_stream(1, result.out);
+                    co_await send_stream(2, result.err);
+                }
+            }
+        }
+    }
+
+    // exec:cat > FILE / exec:cat >> FILE：接收标准输入直到客户端关闭写端
+    awaitable<void> stdin_sink(tcp::socket& socket, const std::string& serial, const std::string& command) {
+        auto args = tokenize(command);
+        bool append = args.size() >= 3 && args[1] == ">>";
+        std::string target = args.size() >= 3 ? args[2] : "";
+        bool evdev = target == TOUCH_NODE;
+
+        std::ofstream file;
+        if (!evdev) {
+            auto path = map_path(target);
+            if (!path) co_return;
+            fs::create_directories(path->parent_path());
+            file.open(*path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+        }
+
+        // 触摸事件解码：记录每根手指的按下位置与抬起位置
+        std::array<std::pair<int32_t, int32_t>, 10> position{};
+        std::array<bool, 10> down{};
+        int slot = 0;
+        std::string pending;
+        std::string buffer(16 * 1024, '\0');
+        while (true) {
+            boost::system::error_code ec;
+            size_t n = co_await socket.async_read_some(asio::buffer(buffer), asio::redirect_error(use_awaitable, ec));
+            if (!evdev) {
+                file.write(buffer.data(), static_cast<std::streamsize>(n));
+            } else {
+                pending.append(buffer.data(), n);
+                size_t used = 0;
+                for (; used + EVENT_SIZE <= pending.size(); used += EVENT_SIZE) {
+                    const char* ev = pending.data() + used + EVENT_SIZE - 8;
+                    uint16_t type = static_cast<uint8_t>(ev[0]) | (static_cast<uint8_t>(ev[1]) << 8);
+                    uint16_t code = static_cast<uint8_t>(ev[2]) | (static_cast<uint8_t>(ev[3]) << 8);
+                    auto value = static_cast<int32_t>(get_le32(ev + 4));
+                    if (type != 3) continue;
+                    if (code == 0x2f) slot = std::clamp(value, 0, 9);
+                    else if (code == 0x35) position[slot].first = value;
+                    else if (code == 0x36) position[slot].second = value;
+                    else if (code == 0x39) {
+                        bool now_down = value >= 0;
+                        if (now_down != down[slot]) {
+                            down[slot] = now_down;
+                            // 按下时坐标尚未到达，抬起时记录最后位置
+                            if (!now_down) {
+                                log_touch(serial, std::format("evdev up slot {} at {} {}",
+                                                              slot, position[slot].first, position[slot].second));
+                            } else {
+                                log_touch(serial, std::format("evdev down slot {}", slot));
+                            }
+                        }
+                    }
+                }
+                pending.erase(0, used);
+            }
+            if (ec) break;
+        }
+    }
+
+    // sync: 会话，文件读写映射到 --root
+    awaitable<void> sync_session(tcp::socket& socket) {
+        std::string data(64 * 1024, '\0');
+        while (true) {
+            char header[8];
+            co_await asio::async_read(socket, asio::buffer(header, 8), use_awaitable);
+            std::string_view id(header, 4);
+            uint32_t len = get_le32(header + 4);
+            if (id == "QUIT") co_return;
+            std::string arg(len, '\0');
+            co_await asio::async_read(socket, asio::buffer(arg.data(), len), use_awaitable);
+
+            if (id == "STAT") {
+                std::string out = "STAT";
+                std::error_code ec;
+                auto path = map_path(arg);
+                if (path && fs::is_regular_file(*path, ec)) {
+                    auto mtime = std::chrono::file_clock::to_sys(fs::last_write_time(*path));
+                    put_le32(out, 0100644);
+                    put_le32(out, static_cast<uint32_t>(fs::file_size(*path)));
+                    put_le32(out, static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                        mtime.time_since_epoch()).count()));
+                } else {
+                    put_le32(out, 0);
+                    put_le32(out, 0);
+                    put_le32(out, 0);
+                }
+                co_await send(socket, out);
+            } else if (id == "RECV") {
+                auto path = map_path(arg);
+                std::ifstream file;
+                if (path) file.open(*path, std::ios::binary);
+                if (!file) {
+                    std::string message = "No such file or directory";
+                    std::string out = "FAIL";
+                    put_le32(out, static_cast<uint32_t>(message.size()));
+                    out += message;
+                    co_await send(socket, out);
+                    continue;
+                }
+                while (file) {
+                    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+                    auto n = static_cast<size_t>(file.gcount());
+                    if (n == 0) break;
+                    std::string out = "DATA";
+                    put_le32(out, static_cast<uint32_t>(n));
+                    out.append(data.data(), n);
+                    co_await send(socket, out);
+                }
+                std::string done = "DONE";
+                put_le32(done, 0);
+                co_await send(socket, done);
+            } else if (id == "SEND") {
+                auto path = map_path(arg.substr(0, arg.rfind(',')));
+                std::ofstream file;
+                if (path) {
+                    fs::create_directories(path->parent_path());
+                    file.open(*path, std::ios::binary | std::ios::trunc);
+                }
+                while (true) {
+                    co_await asio::async_read(socket, asio::buffer(header, 8), use_awaitable);
+                    uint32_t n = get_le32(header + 4);
+                    if (std::string_view(header, 4) == "DONE") break;
+                    if (n > data.size()) co_return;
+                    co_await asio::async_read(socket, asio::buffer(data.data(), n), use_awaitable);
+                    file.write(data.data(), n);
+                }
+                std::string out = file ? "OKAY" : "FAIL";
+                put_le32(out, 0);
+                co_await send(socket, out);
+            } else {
+                co_return;
+            }
+        }
+    }
+
+    // ========== 模拟 adbd ==========
+
+    // 一个服务流：bridge 与服务协程持有的 socket 为一对 socketpair
+    struct AdbdStream {
+        uint32_t local_id;
+        uint32_t remote_id;
+        tcp::socket bridge;
+        asio::steady_timer ack_signal; // 收到 OKAY 时 cancel
+        bool acked = false;
+        bool closed = false;
+    };
+
+    // 一条 adbd 连接：报文由 writer 协程按序发送，避免多个流的写入交错
+    struct AdbdConnection {
+        tcp::socket socket;
+        asio::steady_timer outbox_signal;
+        std::deque<std::string> outbox;
+        std::map<uint32_t, std::shared_ptr<AdbdStream>> streams;
+        uint32_t next_id = 1;
+        size_t max_payload = 4096; // 客户端可接收的最大负载
+        bool closed = false;
+
+        explicit AdbdConnection(tcp::socket s)
+            : socket(std::move(s)), outbox_signal(socket.get_executor(), asio::steady_timer::time_point::max()) {}
+
+        void send(uint32_t command, uint32_t arg0, uint32_t arg1, std::string_view payload = {}) {
+            outbox.push_back(adbd_packet(command, arg0, arg1, payload));
+            outbox_signal.cancel();
+        }
+    };
+
+    static awaitable<void> adbd_writer(std::shared_ptr<AdbdConnection> conn) {
+        while (!conn->closed) {
+            if (conn->outbox.empty()) {
+                boost::system::error_code ec;
+                conn->outbox_signal.expires_at(asio::steady_timer::time_point::max());
+                co_await conn->outbox_signal.async_wait(asio::redirect_error(use_awaitable, ec));
+                continue;
+            }
+            boost::system::error_code ec;
+            co_await asio::async_write(conn->socket, asio::buffer(conn->outbox.front()), asio::redirect_error(use_awaitable, ec));
+            if (ec) co_return;
+            conn->outbox.pop_front();
+        }
+    }
+
+    std::string adbd_banner() const {
+        return "device::ro.product.name=mock;ro.product.model=Mock;ro.product.device=mock;features=shell_v2,cmd,stat_v2";
+    }
+
+    awaitable<void> adbd_connection(tcp::socket socket) {
+        auto executor = co_await asio::this_coro::executor;
+        auto conn = std::make_shared<AdbdConnection>(std::move(socket));
+        asio::co_spawn(executor, adbd_writer(conn), asio::detached);
+        const std::string serial = serials_.front();
+        bool authorized = false;
+        std::string token(AUTH_TOKEN_SIZE, '\0');
+        auto send_token = [&] {
+            RAND_bytes(reinterpret_cast<unsigned char*>(token.data()), static_cast<int>(token.size()));
+            conn->send(A_AUTH, AUTH_TOKEN, 0, token);
+        };
+
+        try {
+            while (true) {
+                AdbdPacket packet = co_await read_adbd_packet(conn->socket);
+                if (packet.command == A_CNXN) {
+                    conn->max_payload = std::min<size_t>(packet.arg1, ADBD_MAX_PAYLOAD);
+                    if (authorized) conn->send(A_CNXN, A_VERSION, ADBD_MAX_PAYLOAD, adbd_banner());
+                    else send_token();
+                } else if (packet.command == A_AUTH && !authorized) {
+                    if (packet.arg0 == AUTH_SIGNATURE) {
+                        authorized = std::any_of(adbd_keys_.begin(), adbd_keys_.end(), [&](const std::string& key) {
+                            return verify_adb_signature(key, token, packet.payload);
+                        });
+                        if (!authorized) {
+                            send_token();
+                            continue;
+                        }
+                        std::cout << "adbd: 签名验证通过" << std::endl;
+                    } else if (packet.arg0 == AUTH_RSAPUBLICKEY) {
+                        // 模拟用户在设备上点了“允许”
+                        std::string key = packet.payload.substr(0, packet.payload.find('\0'));
+                        adbd_keys_.push_back(key);
+                        if (!options_.adbd_keys.empty()) std::ofstream(options_.adbd_keys, std::ios::app) << key << "\n";
+                        std::cout << std::format("adbd: 已授权新公钥 {}", key.substr(key.find(' ') + 1)) << std::endl;
+                        authorized = true;
+                    } else {
+                        continue;
+                    }
+                    conn->send(A_CNXN, A_VERSION, ADBD_MAX_PAYLOAD, adbd_banner());
+                } else if (!authorized) {
+                    continue;
+                } else if (packet.command == A_OPEN) {
+                    std::string service = packet.payload.substr(0, packet.payload.find('\0'));
+                    int fds[2];
+                    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+                        conn->send(A_CLSE, 0, packet.arg0);
+                        continue;
+                    }
+                    tcp::socket bridge(executor);
+                    tcp::socket service_end(executor);
+                    bridge.assign(tcp::v4(), fds[0]);
+                    service_end.assign(tcp::v4(), fds[1]);
+                    uint32_t id = conn->next_id++;
+                    auto stream = std::make_shared<AdbdStream>(AdbdStream{
+                        id, packet.arg0, std::move(bridge),
+                        asio::steady_timer(executor, asio::steady_timer::time_point::max())});
+                    conn->streams[id] = stream;
+                    asio::co_spawn(executor, adbd_service(std::move(service_end), serial, service), asio::detached);
+                    asio::co_spawn(executor, adbd_pump(conn, stream), asio::detached);
+                } else if (auto it = conn->streams.find(packet.arg1); it != conn->streams.end()) {
+                    auto stream = it->second;
+                    if (packet.command == A_OKAY) {
+                        stream->acked = true;
+                        stream->ack_signal.cancel();
+                    } else if (packet.command == A_WRTE) {
+                        // 另起协程写入，读循环继续处理其他流；客户端在 OKAY 前不会再发该流的 WRTE
+                        asio::co_spawn(executor, adbd_deliver(conn, stream, std::move(packet.payload)), asio::detached);
+                    } else if (packet.command == A_CLSE) {
+                        // 与 adbd 一致：关闭本端并回应 CLSE
+                        close_adbd_stream(*conn, *stream, true);
+                    }
+                }
+            }
+        } catch (const std::exception&) {
+            // 客户端断开
+        }
+        conn->closed = true;
+        conn->outbox_signal.cancel();
+        for (auto& [id, stream] : std::map(conn->streams)) {
+            close_adbd_stream(*conn, *stream, false);
+        }
+    }
+
+    static void close_adbd_stream(AdbdConnection& conn, AdbdStream& stream, bool notify) {
+        if (stream.closed) return;
+        stream.closed = true;
+        if (notify && !conn.closed) conn.send(A_CLSE, stream.local_id, stream.remote_id);
+        boost::system::error_code ec;
+        stream.bridge.shutdown(tcp::socket::shutdown_both, ec);
+        stream.bridge.close(ec);
+        stream.ack_signal.cancel();
+        conn.streams.erase(stream.local_id);
+    }
+
+    // 服务协程持有 socketpair 的一端，返回后关闭，bridge 读到结尾即向客户端发送 CLSE
+    awaitable<void> adbd_service(tcp::socket socket, std::string serial, std::string service) {
+        try {
+            co_await delay(options_.latency_ms);
+            co_await device_service(socket, serial, service);
+        } catch (const std::exception&) {
+            // 流被关闭
+        }
+    }
+
+    // 服务输出转为 WRTE：每个 WRTE 等客户端 OKAY 后再发下一个
+    static awaitable<void> adbd_pump(std::shared_ptr<AdbdConnection> conn, std::shared_ptr<AdbdStream> stream) {
+        boost::system::error_code ec;
+        // 服务先回应 OKAY 或 FAIL（与经 ADB Server 时相同），FAIL 即拒绝打开
+        char status[4];
+        co_await asio::async_read(stream->bridge, asio::buffer(status, 4), asio::redirect_error(use_awaitable, ec));
+        if (ec || std::string_view(status, 4) != "OKAY") {
+            conn->send(A_CLSE, 0, stream->remote_id);
+            close_adbd_stream(*conn, *stream, false);
+            co_return;
+        }
+        conn->send(A_OKAY, stream->local_id, stream->remote_id);
+
+        std::string buffer(conn->max_payload, '\0');
+        while (!stream->closed) {
+            size_t n = co_await stream->bridge.async_read_some(asio::buffer(buffer), asio::redirect_error(use_awaitable, ec));
+            if (stream->closed) co_return;
+            if (ec) break;
+            stream->acked = false;
+            conn->send(A_WRTE, stream->local_id, stream->remote_id, std::string_view(buffer.data(), n));
+            while (!stream->acked && !stream->closed) {
+                stream->ack_signal.expires_at(asio::steady_timer::time_point::max());
+                co_await stream->ack_signal.async_wait(asio::redirect_error(use_awaitable, ec));
+            }
+        }
+        close_adbd_stream(*conn, *stream, true);
+    }
+
+    // 客户端 WRTE 写入服务后回 OKAY
+    static awaitable<void> adbd_deliver(std::shared_ptr<AdbdConnection> conn, std::shared_ptr<AdbdStream> stream,
+                                        std::string data) {
+        boost::system::error_code ec;
+        co_await asio::async_write(stream->bridge, asio::buffer(data), asio::redirect_error(use_awaitable, ec));
+        if (stream->closed) co_return;
+        if (ec) {
+            close_adbd_stream(*conn, *stream, true);
+            co_return;
+        }
+        conn->send(A_OKAY, stream->local_id, stream->remote_id);
+    }
+
+    Options options_;
+    struct DeviceState {
+        bool online = true;
+        uint64_t transport_id = 0;
+    };
+
+    std::vector<std::string> serials_;
+    std::map<std::string, DeviceState> device_states_;
+    uint64_t next_transport_id_ = 0;
+    uint64_t devices_generation_ = 0;
+    std::optional<asio::steady_timer> devices_changed_; // 设备列表变化时 cancel，唤醒 track-devices
+    std::vector<Screen> screens_;
+    std::map<std::string, size_t> screen_index_;
+    std::ofstream tap_log_;
+    std::vector<std::string> adbd_keys_; // 模拟 adbd 已授权的公钥
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument(std::format("{} 缺少参数", arg));
+            return argv[++i];
+        };
+        if (arg == "--port") options.port = static_cast<uint16_t>(std::stoi(value()));
+        else if (arg == "--devices") options.devices = std::max(1, std::stoi(value()));
+        else if (arg == "--screens") options.screens_dir = value();
+        else if (arg == "--root") options.root = value();
+        else if (arg == "--latency-ms") options.latency_ms = std::stoi(value());
+        else if (arg == "--bandwidth-kbps") options.bandwidth_kbps = std::stoi(value());
+        else if (arg == "--tap-log") options.tap_log = value();
+        else if (arg == "--evdev") options.evdev = true;
+        else if (arg == "--flap-ms") options.flap_ms = std::stoi(value());
+        else if (arg == "--adbd-port") options.adbd_port = static_cast<uint16_t>(std::stoi(value()));
+        else if (arg == "--adbd-keys") options.adbd_keys = value();
+        else if (arg == "--size") {
+            std::string size = value();
+            size_t x = size.find('x');
+            if (x == std::string::npos) return false;
+            options.width = std::stoi(size.substr(0, x));
+            options.height = std::stoi(size.substr(x + 1));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            std::cerr << "用法: " << argv[0]
+                      << " [--port N] [--devices N] [--screens DIR] [--size WxH] [--root DIR]"
+                         " [--latency-ms N] [--bandwidth-kbps N] [--tap-log FILE] [--evdev] [--flap-ms N]"
+                         " [--adbd-port N] [--adbd-keys FILE]" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    try {
+        asio::io_context io_context;
+        MockServer server(options);
+        asio::co_spawn(io_context, server.listen(), asio::detached);
+        asio::co_spawn(io_context, server.flap(), asio::detached);
+        asio::co_spawn(io_context, server.adbd_listen(), asio::detached);
+        io_context.run();
+    } catch (const std::exception& e) {
+        std::cerr << "mock adb server 异常: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+// OCR 推理基准测试
+// 用法: ocr_bench <image> [iterations] [ocr_runtime.json] [vocabulary.txt]
+// 对 image 做文本检测，并对检出的文本框逐个识别，分别在关闭 / 开启 IoBinding 时统计
+// 每次 detect / recognize 的耗时与堆分配次数（含 OpenCV 与 ONNX Runtime 内部的 malloc），
+// 再对比全部文本框逐个识别与分桶批量识别的总耗时，以及整套 OcrPack::recognizeAll 的耗时与分配次数；指定词表时对比完整分类层与按词表裁剪的分类层
+// 的耗时，并以完整分类层的结果为参照统计裁剪后的整行一致率与字符准确率。
+// 开始前先用合成的 CTC 输出校验带分隔字形（"82/135" 中的 '/'）时按字符集限定解码与正则截取的行为
+#include "Config.hpp"
+#include "vision/ocr_charset.h"
+#include "vision/ocr_det.h"
+#include "vision/ocr_pack.h"
+#include "vision/ocr_rec.h"
+#include "vision/ocr_session_config.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+// glibc 下替换 malloc 系列以统计分配次数，释放与实际分配仍由 glibc 完成
+#ifdef __GLIBC__
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+}
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+}
+
+static uint64_t allocation_count() { return g_allocations.load(std::memory_order_relaxed); }
+#else
+static uint64_t allocation_count() { return 0; }
+#endif
+
+namespace {
+
+struct BenchResult {
+    std::string name;
+    std::vector<double> samples_ms;
+    double allocations_per_call = 0.0;
+};
+
+std::vector<std::string> utf8_chars(const std::string& s) {
+    std::vector<std::string> chars;
+    for (size_t i = 0; i < s.size();) {
+        unsigned char lead = s[i];
+        size_t len = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+        chars.push_back(s.substr(i, len));
+        i += len;
+    }
+    return chars;
+}
+
+// 按字符的编辑距离
+size_t edit_distance(const std::string& a, const std::string& b) {
+    auto x = utf8_chars(a), y = utf8_chars(b);
+    std::vector<size_t> prev(y.size() + 1), cur(y.size() + 1);
+    for (size_t j = 0; j <= y.size(); ++j) prev[j] = j;
+    for (size_t i = 1; i <= x.size(); ++i) {
+        cur[0] = i;
+        for (size_t j = 1; j <= y.size(); ++j) {
+            cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (x[i - 1] == y[j - 1] ? 0 : 1)});
+        }
+        std::swap(prev, cur);
+    }
+    return prev[y.size()];
+}
+
+void print_result(const BenchResult& r) {
+    auto sorted = r.samples_ms;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double v : sorted) sum += v;
+    auto pct = [&](double p) { return sorted[static_cast<size_t>(p * (sorted.size() - 1))]; };
+    std::cout << r.name
+              << ": avg " << sum / sorted.size() << "ms"
+              << ", p50 " << pct(0.5) << "ms"
+              << ", p95 " << pct(0.95) << "ms"
+              << ", 分配 " << r.allocations_per_call << " 次/调用" << std::endl;
+}
+
+// 预热后测量 iterations 次调用的耗时与平均分配次数
+BenchResult run(const std::string& name, int iterations, const std::function<void()>& call) {
+    for (int i = 0; i < 3; ++i) call();
+    BenchResult r;
+    r.name = name;
+    uint64_t allocations = 0;
+    for (int i = 0; i < iterations; ++i) {
+        uint64_t before = allocation_count();
+        auto start = std::chrono::steady_clock::now();
+        call();
+        r.samples_ms.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+        allocations += allocation_count() - before;
+    }
+    r.allocations_per_call = static_cast<double>(allocations) / iterations;
+    return r;
+}
+
+// 合成 "82/135" 的 CTC 输出（'/' 帧的次高分为 '1'），校验：
+// 不限定解码时 '/' 原样保留，regex_search 取到 "82"；按 \d+ 的字符集限定解码时 '/' 被改判，整行成为 "82135"
+bool check_separator_decode() {
+    std::vector<std::string> dict{" ", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "/"};
+    const int classes = static_cast<int>(dict.size());
+    auto index = [&](const std::string& c) { return static_cast<int>(std::find(dict.begin(), dict.end(), c) - dict.begin()); };
+    std::vector<std::pair<std::string, std::string>> frames{
+        {"8", ""}, {" ", ""}, {"2", ""}, {"/", "1"}, {"1", ""}, {"3", ""}, {"5", ""}};
+    std::vector<float> logits(frames.size() * classes, 0.0f);
+    for (size_t t = 0; t < frames.size(); t++) {
+        logits[t * classes + index(frames[t].first)] = 10.0f;
+        if (!frames[t].second.empty()) logits[t * classes + index(frames[t].second)] = 5.0f;
+    }
+
+    std::string pattern = "\\d+";
+    auto allowed = regexCharsetIndices(pattern, dict);
+    std::string free_text = ctcGreedyDecode(logits.data(), static_cast<int>(frames.size()), classes, dict);
+    std::string forced = ctcGreedyDecode(logits.data(), static_cast<int>(frames.size()), classes, dict,
+                                         allowed ? &*allowed : nullptr);
+    std::smatch match;
+    std::string searched = std::regex_search(free_text, match, std::regex(pattern)) ? match.str() : "";
+
+    bool ok = allowed && free_text == "82/135" && searched == "82" && forced == "82135";
+    std::cout << "分隔字形解码校验 " << (ok ? "通过" : "失败") << ": 不限定 \"" << free_text << "\" -> 匹配 \"" << searched
+              << "\"，按 " << pattern << " 限定 \"" << forced << "\"（仅 filter_full_match 时使用）" << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!check_separator_decode()) {
+        return 1;
+    }
+    if (argc < 2) {
+        std::cerr << "用法: ocr_bench <image> [iterations] [ocr_runtime.json] [vocabulary.txt]" << std::endl;
+        return 1;
+    }
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 50;
+    OcrRuntimeConfig runtime;
+    if (argc > 3) {
+        runtime = OcrRuntimeConfig::load(argv[3]);
+    }
+
+    cv::Mat img = cv::imread(argv[1]);
+    if (img.empty()) {
+        std::cerr << "无法读取图像: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::string model_dir = std::string(Config::PROJECT_ROOT_DIR) + "/models/onnx/";
+    std::string dict_path = std::string(Config::PROJECT_ROOT_DIR) + "/models/ppocr_keys_v1.txt";
+    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "ocr_bench");
+    TextDetector detector(env, model_dir + "ch_ppocr_det.onnx", runtime.det);
+    TextRecognizer recognizer(env, model_dir + "ch_ppocr_rec.onnx", dict_path, runtime.rec,
+                              runtime.rec_batch_size);
+
+    std::vector<cv::Mat> crops;
+    for (const auto& box : detector.detect(img)) {
+        crops.push_back(getRotateCropImage(img, box.box));
+    }
+    if (crops.empty()) {
+        crops.push_back(img);
+    }
+    std::cout << "图像 " << img.cols << "x" << img.rows << "，检出 " << crops.size() << " 个文本框，"
+              << iterations << " 次迭代" << std::endl;
+#ifndef __GLIBC__
+    std::cout << "（非 glibc 平台，不统计分配次数）" << std::endl;
+#endif
+
+    size_t next_crop = 0;
+    for (bool bound : {false, true}) {
+        detector.binding().set_enabled(bound);
+        recognizer.setBindingEnabled(bound);
+        std::string mode = bound ? "IoBinding" : "Session::Run";
+        print_result(run("detect    [" + mode + "]", iterations, [&] { detector.detect(img); }));
+        print_result(run("recognize [" + mode + "]", iterations, [&] {
+            recognizer.recognize(crops[next_crop++ % crops.size()]);
+        }));
+    }
+
+    // 全部文本框：逐个推理与分桶批量推理，并核对两者结果是否一致
+    print_result(run("recognize all [逐个]", iterations, [&] {
+        for (const auto& crop : crops) recognizer.recognize(crop);
+    }));
+    print_result(run("recognize all [批量]", iterations, [&] { recognizer.recognizeBatch(crops); }));
+    std::vector<std::string> batched = recognizer.recognizeBatch(crops);
+    int mismatches = 0;
+    for (size_t i = 0; i < crops.size(); i++) {
+        if (recognizer.recognize(crops[i]) != batched[i]) mismatches++;
+    }
+    std::cout << "批量与逐个识别结果不一致: " << mismatches << "/" << crops.size() << std::endl;
+
+    // 整套流程（检测 + 裁剪 + 批量识别）的稳定状态分配次数
+    OcrPack pack(model_dir + "ch_ppocr_det.onnx", model_dir + "ch_ppocr_rec.onnx", dict_path, runtime);
+    print_result(run("recognizeAll [OcrPack]", iterations, [&] { pack.recognizeAll(img); }));
+
+    if (argc > 4) {
+        TextRecognizer pruned(env, model_dir + "ch_ppocr_rec.onnx", dict_path, runtime.rec,
+                              runtime.rec_batch_size, argv[4]);
+        print_result(run("recognize all [完整分类层]", iterations, [&] { recognizer.recognizeBatch(crops); }));
+        print_result(run("recognize all [裁剪分类层]", iterations, [&] { pruned.recognizeBatch(crops); }));
+        std::vector<std::string> full = recognizer.recognizeBatch(crops);
+        std::vector<std::string> small = pruned.recognizeBatch(crops);
+        size_t same = 0, chars = 0, errors = 0;
+        for (size_t i = 0; i < crops.size(); i++) {
+            if (full[i] == small[i]) same++;
+            chars += utf8_chars(full[i]).size();
+            errors += edit_distance(full[i], small[i]);
+        }
+        std::cout << "裁剪分类层与完整分类层: 整行一致 " << same << "/" << crops.size()
+                  << "，字符准确率 " << (chars ? 100.0 * (1.0 - static_cast<double>(errors) / chars) : 100.0)
+                  << "%" << std::endl;
+    }
+    std::cout << "缓冲区重新分配: 检测 " << detector.binding().reallocations()
+              << " 次，识别 " << recognizer.reallocations() << " 次（" << recognizer.bindingCount()
+              << " 种输入形状）" << std::endl;
+    return 0;
+}
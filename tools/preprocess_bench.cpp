@@ -0,0 +1,131 @@
+// OCR 预处理基准测试
+// 用法: preprocess_bench [image] [iterations]
+// 对比原有的 convertTo / subtract / divide / split 多趟预处理链与 normalizeToPlanar 单趟内核
+// （分别限定为标量、SSE4.1、AVX2）的耗时，并校验两者输出的最大误差。未指定图像时使用随机图像
+#include "vision/ocr_normalize.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 预热后取 iterations 次调用的平均耗时（毫秒）
+double time_ms(int iterations, const std::function<void()>& call) {
+    for (int i = 0; i < 3; ++i) call();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) call();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+float max_diff(const std::vector<float>& a, const std::vector<float>& b) {
+    float diff = 0;
+    for (size_t i = 0; i < a.size(); ++i) diff = std::max(diff, std::fabs(a[i] - b[i]));
+    return diff;
+}
+
+// 原检测预处理：缩放后的 BGR 图像转 float、减均值、除方差、拆分到 CHW 缓冲区
+void legacy_det(const cv::Mat& resized, float* dst) {
+    cv::Mat scaled, normalized;
+    resized.convertTo(scaled, CV_32FC3, 1.0 / 255.0);
+    cv::subtract(scaled, cv::Scalar(0.485, 0.456, 0.406), normalized);
+    cv::divide(normalized, cv::Scalar(0.229, 0.224, 0.225), normalized);
+    size_t plane = static_cast<size_t>(resized.rows) * resized.cols;
+    cv::Mat channels[3] = {
+        cv::Mat(resized.rows, resized.cols, CV_32FC1, dst),
+        cv::Mat(resized.rows, resized.cols, CV_32FC1, dst + plane),
+        cv::Mat(resized.rows, resized.cols, CV_32FC1, dst + 2 * plane),
+    };
+    cv::split(normalized, channels);
+}
+
+// 原识别预处理（CLAHE 之后）：转回三通道、缩放、补齐、转 float、归一化、拆分
+void legacy_rec(const cv::Mat& enhanced, int width, float* dst) {
+    cv::Mat bgr, resized, padded, scaled, normalized;
+    cv::cvtColor(enhanced, bgr, cv::COLOR_GRAY2BGR);
+    int resize_w = std::min(int(48 * (bgr.cols * 1.0f / bgr.rows)), width);
+    cv::resize(bgr, resized, cv::Size(resize_w, 48), 0, 0, cv::INTER_CUBIC);
+    cv::copyMakeBorder(resized, padded, 0, 0, 0, width - resize_w, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
+    padded.convertTo(scaled, CV_32FC3, 1.0 / 255.0);
+    cv::subtract(scaled, cv::Scalar(0.5, 0.5, 0.5), normalized);
+    cv::divide(normalized, cv::Scalar(0.5, 0.5, 0.5), normalized);
+    size_t plane = static_cast<size_t>(48) * width;
+    cv::Mat channels[3] = {
+        cv::Mat(48, width, CV_32FC1, dst),
+        cv::Mat(48, width, CV_32FC1, dst + plane),
+        cv::Mat(48, width, CV_32FC1, dst + 2 * plane),
+    };
+    cv::split(normalized, channels);
+}
+
+// 现识别预处理（CLAHE 之后）：灰度缩放后单趟归一化
+void fused_rec(const cv::Mat& enhanced, int width, float* dst) {
+    cv::Mat resized;
+    int resize_w = std::min(int(48 * (enhanced.cols * 1.0f / enhanced.rows)), width);
+    cv::resize(enhanced, resized, cv::Size(resize_w, 48), 0, 0, cv::INTER_CUBIC);
+    normalizeToPlanar(resized, dst, width, {0.5f, 0.5f, 0.5f}, {0.5f, 0.5f, 0.5f});
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    cv::Mat img;
+    if (argc > 1) {
+        img = cv::imread(argv[1]);
+        if (img.empty()) {
+            std::cerr << "无法读取图像: " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        img.create(1080, 1920, CV_8UC3);
+        std::mt19937 rng(42);
+        for (int y = 0; y < img.rows; ++y) {
+            uint8_t* row = img.ptr<uint8_t>(y);
+            for (int x = 0; x < img.cols * 3; ++x) row[x] = static_cast<uint8_t>(rng());
+        }
+    }
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    // 检测：按 960 长边缩放并对齐到 32 的倍数
+    float ratio = std::min(1.0f, 960.0f / std::max(img.rows, img.cols));
+    cv::Size det_size((int(img.cols * ratio) + 31) / 32 * 32, (int(img.rows * ratio) + 31) / 32 * 32);
+    cv::Mat resized;
+    cv::resize(img, resized, det_size);
+
+    // 识别：取左上角一条文本行大小的区域转灰度
+    cv::Mat gray;
+    cv::cvtColor(img(cv::Rect(0, 0, std::min(img.cols, 200), std::min(img.rows, 32))), gray, cv::COLOR_BGR2GRAY);
+    const int rec_width = 320;
+
+    std::vector<float> det_ref(3 * resized.total()), det_out(det_ref.size());
+    std::vector<float> rec_ref(3 * 48 * rec_width), rec_out(rec_ref.size());
+    legacy_det(resized, det_ref.data());
+    legacy_rec(gray, rec_width, rec_ref.data());
+
+    std::cout << "检测输入 " << det_size.width << "x" << det_size.height << "，识别输入 " << rec_width << "x48，"
+              << iterations << " 次迭代，CPU 最优指令集 " << normalizeIsaName(normalizeIsa()) << std::endl;
+    std::cout << "detect    [原预处理链]: " << time_ms(iterations, [&] { legacy_det(resized, det_ref.data()); })
+              << "ms" << std::endl;
+    std::cout << "recognize [原预处理链]: " << time_ms(iterations, [&] { legacy_rec(gray, rec_width, rec_ref.data()); })
+              << "ms" << std::endl;
+
+    NormalizeIsa best = normalizeIsa();
+    for (NormalizeIsa isa : {NormalizeIsa::Scalar, NormalizeIsa::SSE41, NormalizeIsa::AVX2}) {
+        if (setNormalizeIsa(isa) != isa) continue;
+        std::string name = normalizeIsaName(isa);
+        double det_ms = time_ms(iterations, [&] {
+            normalizeToPlanar(resized, det_out.data(), resized.cols, {0.485f, 0.456f, 0.406f}, {0.229f, 0.224f, 0.225f});
+        });
+        double rec_ms = time_ms(iterations, [&] { fused_rec(gray, rec_width, rec_out.data()); });
+        std::cout << "detect    [" << name << "]: " << det_ms << "ms，最大误差 " << max_diff(det_ref, det_out) << std::endl;
+        std::cout << "recognize [" << name << "]: " << rec_ms << "ms，最大误差 " << max_diff(rec_ref, rec_out) << std::endl;
+    }
+    setNormalizeIsa(best);
+    return 0;
+}